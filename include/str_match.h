@@ -34,8 +34,125 @@ _TSM_ENUM(TsmResult) {
     TSM_OK = 0,
     TSM_FAIL = 1,
     TSM_SYNTAX_ERROR = 2,
+    TSM_OUT_OF_MEMORY = 3,
 };
 
+/**
+ * Option flags for compiled patterns.
+ *
+ * @enum TsmFlag
+ */
+_TSM_ENUM(TsmFlag) {
+    TSM_FLAG_NONE = 0,
+    TSM_FLAG_ICASE = 1 << 0,  // Case-insensitive matching (ASCII and simple Unicode case folding)
+    TSM_FLAG_UNICODE = 1 << 1,  // Unicode-aware \d, \w, and \s for regex (ignored by wildcard)
+    TSM_FLAG_PATH = 1 << 2,  // Path mode for wildcard: "*" and "?" stop at "/" (ignored by regex)
+    TSM_FLAG_MEMOIZE = 1 << 3,  // Bound regex backtracking with a memo (ignored by wildcard)
+    TSM_FLAG_BYTES = 1 << 4,  // Each byte is a Latin-1 character. No utf-8 decoding or validation
+    TSM_FLAG_JIT = 1 << 5,  // Compile regex bytecode to machine code when possible (x86-64 Linux)
+    TSM_FLAG_SAFE = 1 << 6,  // Memoize regex patterns that can backtrack in super-linear time
+};
+
+/**
+ * Engines for compiled regex patterns. See tsm_regex_strategy().
+ *
+ * @enum TsmStrategy
+ */
+_TSM_ENUM(TsmStrategy) {
+    TSM_STRATEGY_BACKTRACK = 0,  // Backtracking with an explicit stack (any pattern)
+    TSM_STRATEGY_LITERAL = 1,  // Substring search for literal patterns
+    TSM_STRATEGY_PREFIX = 2,  // Prefix comparison for "^literal"
+    TSM_STRATEGY_SUFFIX = 3,  // Suffix comparison for "literal$"
+    TSM_STRATEGY_EXACT = 4,  // String comparison for "^literal$"
+    TSM_STRATEGY_SHIFT_AND = 5,  // Bit-parallel forward scan for short patterns without "|"
+    TSM_STRATEGY_BNDM = 6,  // Bit-parallel backward scan for short fixed-length ASCII patterns
+    TSM_STRATEGY_VM = 7,  // Bytecode VM for other patterns
+    TSM_STRATEGY_JIT = 8,  // Machine code compiled from the bytecode (TSM_FLAG_JIT)
+};
+
+/**
+ * Events for trace callbacks. See tsm_regex_set_trace().
+ *
+ * @enum TsmTraceEvent
+ */
+_TSM_ENUM(TsmTraceEvent) {
+    TSM_TRACE_START = 0,  // A match attempt starts at the offset
+    TSM_TRACE_STEP = 1,  // An atom is tested against the character at the offset
+    TSM_TRACE_BACKTRACK = 2,  // The matcher goes back to the offset to try another way
+};
+
+/**
+ * Status of text in an incremental matcher. See tsm_regex_incremental_status().
+ *
+ * @enum TsmPrefixStatus
+ */
+_TSM_ENUM(TsmPrefixStatus) {
+    TSM_PREFIX_DEAD = 0,  // Neither the text nor longer text that starts with it can match
+    TSM_PREFIX_VIABLE = 1,  // The text doesn't match, but longer text that starts with it can
+    TSM_PREFIX_COMPLETE = 2,  // The text matches
+};
+
+/**
+ * Compiled regex pattern.
+ * Create it with tsm_regex_compile() and free it with tsm_regex_free().
+ */
+typedef struct TsmRegex TsmRegex;
+
+/**
+ * Incremental matcher for text that is edited at the end, such as input fields.
+ * Create it with tsm_regex_incremental_new() and free it with tsm_regex_incremental_free().
+ */
+typedef struct TsmIncremental TsmIncremental;
+
+/**
+ * Compiled wildcard pattern.
+ * Create it with tsm_wildcard_compile() and free it with tsm_wildcard_free().
+ */
+typedef struct TsmWildcard TsmWildcard;
+
+/**
+ * Byte range of a match. The match is str[start] to str[end - 1].
+ */
+typedef struct TsmMatch {
+    size_t start;
+    size_t end;
+} TsmMatch;
+
+/**
+ * Iterator over fields between regex matches. See tsm_regex_split_init().
+ * The members are private. The iterator doesn't own the pattern or the buffer.
+ */
+typedef struct TsmSplit {
+    const TsmRegex *compiled;
+    const char *str;
+    size_t len;
+    size_t start;  // start of the next field
+    size_t next;   // where to search the next delimiter. len + 1 after the last one
+    int done;
+} TsmSplit;
+
+/**
+ * Profiling counters of a compiled regex pattern. See tsm_regex_stats().
+ */
+typedef struct TsmStats {
+    uint64_t calls;       // match, search, and count calls
+    uint64_t starts;      // start positions tried by the backtracker and the VM
+    uint64_t steps;       // atoms tested against characters
+    uint64_t backtracks;  // times the matchers went back to try another way
+    uint64_t rejects;     // calls that the literal and bit-parallel engines decided alone
+    uint64_t nanos;       // time spent in the calls
+} TsmStats;
+
+/**
+ * Trace callback for compiled regex patterns. See tsm_regex_set_trace().
+ *
+ * @param user The pointer that was passed to tsm_regex_set_trace().
+ * @param event A TsmTraceEvent value.
+ * @param obj Index of the regex object. (-1 for TSM_TRACE_START)
+ * @param offset Offset from the start of the string. (code units for utf-16 and utf-32)
+ */
+typedef void (*TsmTraceFn)(void *user, TsmTraceEvent event, int obj, size_t offset);
+
 /**
  * Checks if a string matches a wildcard pattern or not.
  *
@@ -56,6 +173,392 @@ _TSM_EXTERN TsmResult tsm_wildcard_match(const char *pattern, const char *str);
  */
 _TSM_EXTERN TsmResult tsm_regex_match(const char *pattern, const char *str);
 
+/**
+ * Checks if a whole string matches a regex pattern or not.
+ *
+ * @note The pattern is anchored at both ends as if it were "^(pattern)$".
+ *       It tries only the beginning of the string, so it's faster than tsm_regex_match().
+ *
+ * @param pattern A regex pattern.
+ * @param str A string.
+ * @returns Zero when the whole string matches. One if not. Two when got a syntax error.
+ */
+_TSM_EXTERN TsmResult tsm_regex_fullmatch(const char *pattern, const char *str);
+
+/**
+ * Compiles a wildcard pattern.
+ *
+ * @param pattern A wildcard pattern.
+ * @param flags Bitwise OR of TsmFlag values.
+ * @param compiled Receives the compiled pattern. NULL when failed.
+ * @returns Zero when compiled. One for null pointers. Two when got bad runes.
+ *          Three when failed to allocate memory.
+ */
+_TSM_EXTERN TsmResult tsm_wildcard_compile(const char *pattern, int flags,
+                                           TsmWildcard **compiled);
+
+/**
+ * Checks if a string matches a compiled wildcard pattern or not.
+ *
+ * @param compiled A compiled wildcard pattern.
+ * @param str A string.
+ * @returns Zero when the string has the wildcard pattern. One if not.
+ */
+_TSM_EXTERN TsmResult tsm_wildcard_match_compiled(const TsmWildcard *compiled, const char *str);
+
+/**
+ * Checks if an utf-16 or utf-32 string matches a compiled wildcard pattern or not.
+ *
+ * @note Strings are decoded while matching. They aren't converted to utf-8.
+ *       Unpaired surrogates and invalid code points make matching fail.
+ *       Patterns with TSM_FLAG_BYTES don't match them because they aren't bytes.
+ *
+ * @param compiled A compiled wildcard pattern.
+ * @param str An utf-16 or utf-32 string. It doesn't need a null terminator.
+ * @param len The number of code units in the string.
+ * @returns Zero when the string has the wildcard pattern. One if not.
+ *          Three when failed to allocate memory.
+ */
+_TSM_EXTERN TsmResult tsm_wildcard_match_utf16(const TsmWildcard *compiled,
+                                               const uint16_t *str, size_t len);
+_TSM_EXTERN TsmResult tsm_wildcard_match_utf32(const TsmWildcard *compiled,
+                                               const uint32_t *str, size_t len);
+
+/**
+ * Checks if any path under a directory can match a compiled wildcard pattern.
+ *
+ * @note It helps to skip subtrees while walking directories.
+ *       The directory can end with "/" or not. An empty string means the current directory.
+ *       TSM_OK doesn't mean that a matching path exists. TSM_FAIL means that no paths can match.
+ *
+ * @param compiled A compiled wildcard pattern. It should use TSM_FLAG_PATH for paths.
+ * @param dir A directory path.
+ * @returns Zero when paths under the directory can match the pattern. One if not.
+ */
+_TSM_EXTERN TsmResult tsm_wildcard_can_descend(const TsmWildcard *compiled, const char *dir);
+
+/**
+ * Frees a compiled wildcard pattern.
+ *
+ * @param compiled A compiled wildcard pattern. It can be NULL.
+ */
+_TSM_EXTERN void tsm_wildcard_free(TsmWildcard *compiled);
+
+/**
+ * Compiles a regex pattern.
+ *
+ * @param pattern A regex pattern.
+ * @param flags Bitwise OR of TsmFlag values.
+ * @param compiled Receives the compiled pattern. NULL when failed.
+ * @returns Zero when compiled. One for null pointers. Two when got a syntax error.
+ *          Three when failed to allocate memory.
+ */
+_TSM_EXTERN TsmResult tsm_regex_compile(const char *pattern, int flags, TsmRegex **compiled);
+
+/**
+ * Checks if a string matches a compiled regex pattern or not.
+ *
+ * @param compiled A compiled regex pattern.
+ * @param str A string.
+ * @returns Zero when found the regex pattern. One when not found.
+ */
+_TSM_EXTERN TsmResult tsm_regex_match_compiled(const TsmRegex *compiled, const char *str);
+
+/**
+ * Checks if a whole string matches a compiled regex pattern or not.
+ *
+ * @note The pattern is anchored at both ends. See tsm_regex_fullmatch().
+ *
+ * @param compiled A compiled regex pattern.
+ * @param str A string.
+ * @returns Zero when the whole string matches. One if not.
+ */
+_TSM_EXTERN TsmResult tsm_regex_fullmatch_compiled(const TsmRegex *compiled, const char *str);
+
+/**
+ * Checks if an utf-16 or utf-32 string matches a compiled regex pattern or not.
+ *
+ * @note The bytecode VM decodes strings while matching. Patterns that the VM doesn't support,
+ *       and patterns with TSM_FLAG_MEMOIZE, match a temporary utf-8 copy of the string.
+ *       Unpaired surrogates and invalid code points make matching fail when reached.
+ *       Patterns with TSM_FLAG_BYTES don't match them because they aren't bytes.
+ *
+ * @param compiled A compiled regex pattern.
+ * @param str An utf-16 or utf-32 string. It doesn't need a null terminator.
+ * @param len The number of code units in the string.
+ * @returns Zero when found the regex pattern. One when not found.
+ *          Three when failed to allocate memory.
+ */
+_TSM_EXTERN TsmResult tsm_regex_match_utf16(const TsmRegex *compiled,
+                                            const uint16_t *str, size_t len);
+_TSM_EXTERN TsmResult tsm_regex_match_utf32(const TsmRegex *compiled,
+                                            const uint32_t *str, size_t len);
+
+/**
+ * Gets the engine that was chosen for a compiled regex pattern.
+ *
+ * @note The engine is chosen by tsm_regex_compile(). It is useful for diagnostics.
+ *       All the engines return the same results for valid utf-8 strings.
+ *
+ * @param compiled A compiled regex pattern.
+ * @returns A TsmStrategy value. TSM_STRATEGY_BACKTRACK for null pointers.
+ */
+_TSM_EXTERN TsmStrategy tsm_regex_strategy(const TsmRegex *compiled);
+
+/**
+ * Estimates how the time of a match attempt grows with the string length.
+ *
+ * @note The pattern is analyzed without strings. Repeated atoms that can take the same
+ *       characters, such as "\\w*\\w*!", make the backtracking engines try each way to split
+ *       a run between them. A chain of k of them takes O(n^k) steps for n characters.
+ *       {n,m} doesn't count, and possessive quantifiers only end chains because they don't
+ *       give characters back. Exponential time needs groups, which the syntax doesn't have.
+ *       Searches try each start position. TSM_FLAG_MEMOIZE skips the states that already
+ *       failed, so a search takes O(n^2) steps at most.
+ *       Reject patterns over a degree, or compile them with TSM_FLAG_SAFE to memoize them.
+ *
+ * @param compiled A compiled regex pattern.
+ * @returns The degree k of O(n^k) steps. One for linear time. Zero for null pointers.
+ */
+_TSM_EXTERN int tsm_regex_complexity(const TsmRegex *compiled);
+
+/**
+ * Gets the profiling counters of a compiled regex pattern.
+ *
+ * @note The counters are available only when the library is built with "-Dprofile=true".
+ *       They are updated atomically, so threads can share the pattern.
+ *
+ * @param compiled A compiled regex pattern.
+ * @param stats Receives the counters.
+ * @returns Zero when succeeded. One for null pointers or builds without profiling.
+ */
+_TSM_EXTERN TsmResult tsm_regex_stats(const TsmRegex *compiled, TsmStats *stats);
+
+/**
+ * Resets the profiling counters of a compiled regex pattern to zero.
+ *
+ * @param compiled A compiled regex pattern.
+ * @returns Zero when succeeded. One for null pointers or builds without profiling.
+ */
+_TSM_EXTERN TsmResult tsm_regex_stats_reset(TsmRegex *compiled);
+
+/**
+ * Sets a callback that receives each step of the backtracker and the VM.
+ *
+ * @note The literal and bit-parallel engines don't call it.
+ *       The callback slows down matching a lot. Use it only for debugging.
+ *
+ * @param compiled A compiled regex pattern.
+ * @param trace A callback, or NULL to remove it.
+ * @param user A pointer that is passed to the callback.
+ * @returns Zero when succeeded. One for null pointers or builds without profiling.
+ */
+_TSM_EXTERN TsmResult tsm_regex_set_trace(TsmRegex *compiled, TsmTraceFn trace, void *user);
+
+/**
+ * Finds the leftmost match of a compiled regex pattern in a buffer.
+ *
+ * @note The buffer doesn't need to be null-terminated. "^" matches only at str[0],
+ *       and "$" matches only at str[len].
+ *
+ * @param compiled A compiled regex pattern.
+ * @param str A buffer.
+ * @param len The size of the buffer in bytes.
+ * @param offset Where to start the search. It should be the first byte of a character.
+ * @param match Receives the byte range of the match.
+ * @returns Zero when found the regex pattern. One when not found or got invalid utf-8.
+ */
+_TSM_EXTERN TsmResult tsm_regex_search(const TsmRegex *compiled, const char *str, size_t len,
+                                       size_t offset, TsmMatch *match);
+
+/**
+ * Replaces matches of a compiled regex pattern in a buffer with a literal string.
+ *
+ * @note Matches are found from left to right like tsm_regex_count_parallel().
+ *       Each match is replaced with the replacement as is. It has no references to groups.
+ *       Call it with a null output buffer to get the size of the result.
+ *       The output buffer shouldn't overlap the input buffer.
+ *
+ * @param compiled A compiled regex pattern.
+ * @param str A buffer.
+ * @param len The size of the buffer in bytes.
+ * @param replacement A null-terminated string for matches.
+ * @param all Non-zero to replace all the matches. Zero to replace the first match only.
+ * @param out A buffer that receives the null-terminated result. It can be NULL.
+ * @param out_size The size of the output buffer in bytes.
+ * @param out_len Receives the length of the result without the null terminator.
+ * @returns Zero when got the result. It's a copy of the input when nothing matched.
+ *          One for null pointers or invalid utf-8,
+ *          or when the output buffer is smaller than *out_len + 1.
+ */
+_TSM_EXTERN TsmResult tsm_regex_replace(const TsmRegex *compiled, const char *str, size_t len,
+                                        const char *replacement, int all,
+                                        char *out, size_t out_size, size_t *out_len);
+
+/**
+ * Starts splitting a buffer at matches of a compiled regex pattern.
+ *
+ * @note Fields are the parts between matches. Matches are found from left to right
+ *       like tsm_regex_count_parallel(), so n matches make n + 1 fields.
+ *       Empty matches also split the buffer. "x*" splits "ab" into "", "a", "b", and "".
+ *
+ * @param split An iterator to initialize.
+ * @param compiled A compiled regex pattern. It should live until the iteration ends.
+ * @param str A buffer. It should live until the iteration ends.
+ * @param len The size of the buffer in bytes.
+ * @returns Zero when initialized. One for null pointers.
+ */
+_TSM_EXTERN TsmResult tsm_regex_split_init(TsmSplit *split, const TsmRegex *compiled,
+                                           const char *str, size_t len);
+
+/**
+ * Gets the next field of a split buffer.
+ *
+ * @note The field points into the buffer. Nothing is copied or allocated.
+ *
+ * @param split An iterator initialized with tsm_regex_split_init().
+ * @param field Receives the first byte of the field.
+ * @param field_len Receives the size of the field in bytes.
+ * @returns Zero when got a field. One after the last field, for null pointers,
+ *          or when got invalid utf-8.
+ */
+_TSM_EXTERN TsmResult tsm_regex_split_next(TsmSplit *split, const char **field,
+                                           size_t *field_len);
+
+/**
+ * Creates an incremental matcher for a compiled regex pattern.
+ *
+ * @note The matcher keeps a state for each character, so adding and removing characters
+ *       at the end doesn't match the whole text again.
+ *       It supports patterns that the bytecode VM supports (See TSM_STRATEGY_VM)
+ *       without possessive quantifiers, and {n,m} counts up to about a thousand positions
+ *       in total.
+ *
+ * @param compiled A compiled regex pattern. It should live until the matcher is freed.
+ * @param full Non-zero to match the whole text like tsm_regex_fullmatch_compiled().
+ *             Zero to find the pattern in the text like tsm_regex_match_compiled().
+ * @param inc Receives the matcher for empty text. NULL when failed.
+ * @returns Zero when created. One for null pointers or patterns that aren't supported.
+ *          Three when failed to allocate memory.
+ */
+_TSM_EXTERN TsmResult tsm_regex_incremental_new(const TsmRegex *compiled, int full,
+                                                TsmIncremental **inc);
+
+/**
+ * Adds characters to the end of the text of an incremental matcher.
+ *
+ * @note Each byte of invalid utf-8 sequences and incomplete characters is a character.
+ *       After one, the text is complete when a match ended before the character
+ *       in front of it, and dead otherwise. tsm_regex_match_compiled() also fails
+ *       when a repetition reads the invalid sequence, so it can fail where
+ *       the text is complete (e.g. "b+" for "bb\xff").
+ *
+ * @param inc An incremental matcher.
+ * @param str Characters to add. It doesn't need a null terminator.
+ * @param len The size of the characters in bytes.
+ * @returns Zero when added. One for null pointers. Three when failed to allocate memory.
+ */
+_TSM_EXTERN TsmResult tsm_regex_incremental_push(TsmIncremental *inc, const char *str,
+                                                 size_t len);
+
+/**
+ * Removes characters from the end of the text of an incremental matcher.
+ *
+ * @param inc An incremental matcher.
+ * @param count The number of characters to remove.
+ * @returns Zero when removed. One for null pointers, or when the text has fewer characters.
+ */
+_TSM_EXTERN TsmResult tsm_regex_incremental_pop(TsmIncremental *inc, size_t count);
+
+/**
+ * Removes all the characters of an incremental matcher.
+ *
+ * @param inc An incremental matcher. It can be NULL.
+ */
+_TSM_EXTERN void tsm_regex_incremental_reset(TsmIncremental *inc);
+
+/**
+ * Gets the number of characters in an incremental matcher.
+ *
+ * @param inc An incremental matcher.
+ * @returns The number of characters. Zero for null pointers.
+ */
+_TSM_EXTERN size_t tsm_regex_incremental_length(const TsmIncremental *inc);
+
+/**
+ * Checks if the text of an incremental matcher matches, or can match with more characters.
+ *
+ * @param inc An incremental matcher.
+ * @returns A TsmPrefixStatus value. TSM_PREFIX_DEAD for null pointers.
+ */
+_TSM_EXTERN TsmPrefixStatus tsm_regex_incremental_status(const TsmIncremental *inc);
+
+/**
+ * Frees an incremental matcher.
+ *
+ * @param inc An incremental matcher. It can be NULL.
+ */
+_TSM_EXTERN void tsm_regex_incremental_free(TsmIncremental *inc);
+
+/**
+ * Finds the leftmost match of a compiled regex pattern in a large buffer with threads.
+ *
+ * @note The result is the same as tsm_regex_search() with zero offset.
+ *       Small buffers are searched with fewer threads.
+ *
+ * @param compiled A compiled regex pattern.
+ * @param str A buffer.
+ * @param len The size of the buffer in bytes.
+ * @param threads The maximum number of threads. Zero or less to use all the processors.
+ * @param match Receives the byte range of the match.
+ * @returns Zero when found the regex pattern. One when not found or got invalid utf-8.
+ *          Three when failed to allocate memory.
+ */
+_TSM_EXTERN TsmResult tsm_regex_search_parallel(const TsmRegex *compiled, const char *str,
+                                                size_t len, int threads, TsmMatch *match);
+
+/**
+ * Counts non-overlapping matches of a compiled regex pattern in a buffer.
+ *
+ * @note Matches are counted from left to right like repeated tsm_regex_search() calls.
+ *       The next search starts at the end of the previous match,
+ *       or at the next character after an empty match.
+ *       Literal patterns and short fixed-length patterns are counted without finding match ranges.
+ *
+ * @param compiled A compiled regex pattern.
+ * @param str A buffer.
+ * @param len The size of the buffer in bytes.
+ * @param count Receives the number of matches.
+ * @returns Zero when counted. One for null pointers or invalid utf-8.
+ */
+_TSM_EXTERN TsmResult tsm_regex_count(const TsmRegex *compiled, const char *str, size_t len,
+                                      size_t *count);
+
+/**
+ * Counts non-overlapping matches of a compiled regex pattern in a large buffer with threads.
+ *
+ * @note Matches are counted from left to right like repeated tsm_regex_search() calls.
+ *       The next search starts at the end of the previous match,
+ *       or at the next character after an empty match.
+ *
+ * @param compiled A compiled regex pattern.
+ * @param str A buffer.
+ * @param len The size of the buffer in bytes.
+ * @param threads The maximum number of threads. Zero or less to use all the processors.
+ * @param count Receives the number of matches.
+ * @returns Zero when counted. One for null pointers or invalid utf-8.
+ *          Three when failed to allocate memory.
+ */
+_TSM_EXTERN TsmResult tsm_regex_count_parallel(const TsmRegex *compiled, const char *str,
+                                               size_t len, int threads, size_t *count);
+
+/**
+ * Frees a compiled regex pattern.
+ *
+ * @param compiled A compiled regex pattern. It can be NULL.
+ */
+_TSM_EXTERN void tsm_regex_free(TsmRegex *compiled);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,264 @@
+/*
+ * Bit-parallel matching for short patterns.
+ * See "Flexible Pattern Matching in Strings" by Gonzalo Navarro and Mathieu Raffinot
+ * for the details of the extended Shift-And and BNDM algorithms.
+ */
+
+#include <string.h>
+#include "str_match.h"
+#include "utf.h"
+#include "re.h"
+#include "bitpar.h"
+
+#define BIT(i) ((uint64_t)1 << (i))
+
+/* Positions that match a byte in byte mode */
+#define byte_mask(bp, c) ((c) <= ASCII_MAX ? (bp)->ascii[c] : (bp)->latin1[(c) - ASCII_MAX - 1])
+
+/* Checks if an object can match multi-byte characters. */
+static void add_mbmask(bitpar_t* bp, const regex_t* obj, uint64_t bit) {
+    switch (re_multibyte(obj)) {
+        case RE_MB_ANY:
+            bp->mb_fixed |= bit;
+            break;
+        case RE_MB_TEST:
+            bp->mb_var |= bit;
+            break;
+        default:
+            break;
+    }
+}
+
+static int add_position(bitpar_t* bp, const regex_t* objs, int idx, int optional, int repeat) {
+    int i;
+    char c;
+    uint64_t bit;
+    if (bp->len >= BP_MAX_POSITIONS)
+        return 0;
+    bp->src[bp->len++] = (uint32_t)idx;
+    bit = BIT(bp->len);
+    /* NUL also has an entry for buffers with lengths. */
+    for (i = 0; i <= ASCII_MAX; i++) {
+        c = (char)i;
+        if (re_matchone(&objs[idx], &c, 1))
+            bp->ascii[i] |= bit;
+    }
+    for (i = ASCII_MAX + 1; bp->bytes && i <= 0xFF; i++) {
+        c = (char)i;
+        if (re_matchone(&objs[idx], &c, 1))
+            bp->latin1[i - ASCII_MAX - 1] |= bit;
+    }
+    add_mbmask(bp, &objs[idx], bit);
+    if (optional)
+        bp->optional |= bit;
+    if (repeat)
+        bp->repeat |= bit;
+    return 1;
+}
+
+int bp_compile_regex(bitpar_t* bp, const regex_t* objs) {
+    int i = 0, j, k;
+    memset(bp, 0, sizeof(bitpar_t));
+    bp->bytes = (objs[0].flags & RE_BYTES) != 0;
+
+    if (objs[0].type == BEGIN) {
+        bp->anchored_begin = 1;
+        i++;
+    }
+
+    while (objs[i].type != UNUSED) {
+        int atom = i;
+        if (objs[i].type == END && objs[i + 1].type == UNUSED) {
+            bp->anchored_end = 1;
+            break;
+        }
+        if (!re_isatom(objs[i].type))
+            return 0;  /* branches, misplaced anchors, or quantifiers without atoms */
+
+        i++;
+        if (objs[i].flags & RE_POSSESSIVE)
+            return 0;  /* Positions can't give up a choice. */
+        switch (objs[i].type) {
+            case QUESTIONMARK:
+                if (!add_position(bp, objs, atom, 1, 0)) return 0;
+                i++;
+                break;
+            case STAR:
+                if (!add_position(bp, objs, atom, 1, 1)) return 0;
+                i++;
+                break;
+            case PLUS:
+                if (!add_position(bp, objs, atom, 0, 1)) return 0;
+                i++;
+                break;
+            case TIMES:
+            {
+                /* Unroll {n,m} to n required positions and (m - n) optional positions. */
+                uint16_t n = objs[i].u.times.n;
+                uint16_t m = objs[i].u.times.m;
+                if (m == MAX_USHORT) {
+                    if (n == 0) {
+                        if (!add_position(bp, objs, atom, 1, 1)) return 0;
+                    }
+                    for (k = 0; k < n; k++) {
+                        if (!add_position(bp, objs, atom, 0, k == n - 1)) return 0;
+                    }
+                } else {
+                    if (m > BP_MAX_POSITIONS) return 0;
+                    for (k = 0; k < m; k++) {
+                        if (!add_position(bp, objs, atom, k >= n, 0)) return 0;
+                    }
+                }
+                i++;
+            }   break;
+            default:
+                if (!add_position(bp, objs, atom, 0, 0)) return 0;
+                break;
+        }
+    }
+    if (bp->len == 0)
+        return 0;
+
+    /* Mark blocks of optional positions. */
+    for (j = 1; j <= bp->len; j++) {
+        if (!(bp->optional & BIT(j)))
+            continue;
+        bp->opt_begin |= BIT(j - 1);
+        while (j < bp->len && (bp->optional & BIT(j + 1)))
+            j++;
+        bp->opt_end |= BIT(j);
+    }
+    bp->accept = BIT(bp->len);
+    bp->use_bndm = !bp->anchored_begin && !bp->anchored_end &&
+                   !bp->optional && !bp->repeat &&
+                   (bp->bytes || (!bp->mb_fixed && !bp->mb_var)) && bp->len >= 2;
+    return 1;
+}
+
+static uint64_t regex_mbmask(const bitpar_t* bp, const void* ctx, uint64_t mask,
+                             const char* c, int c_size) {
+    const regex_t* objs = (const regex_t*)ctx;
+    uint64_t found = 0;
+    int i;
+    for (i = 1; i <= bp->len; i++) {
+        if ((mask & BIT(i)) && re_matchone(&objs[bp->src[i - 1]], c, c_size))
+            found |= BIT(i);
+    }
+    return found;
+}
+
+/* Epsilon closure for optional positions. */
+static uint64_t closure(const bitpar_t* bp, uint64_t d) {
+    uint64_t df = d | bp->opt_end;
+    return d | (bp->optional & ~((df - bp->opt_begin) ^ df));
+}
+
+static int shift_and(const bitpar_t* bp, const regex_t* objs, const char* text, int full) {
+    const uint64_t init = (bp->anchored_begin || full) ? 0 : 1;
+    const int anchored_end = bp->anchored_end || full;
+    uint64_t d = closure(bp, 1);
+    for (;;) {
+        uint64_t b;
+        int size;
+        if (*text == '\0')
+            return (d & bp->accept) != 0;
+        size = bp->bytes ? 1 : tsm_rune_size(text);
+        if (!size)
+            return 0;  /* failed to parse utf-8 characters. */
+        if (!anchored_end && (d & bp->accept))
+            return 1;
+        if (!d)
+            return 0;  /* no active positions with '^' */
+        if (bp->bytes)
+            b = byte_mask(bp, (uint8_t)*text);
+        else if (size == 1)
+            b = bp->ascii[(uint8_t)*text];
+        else
+            b = bp->mb_fixed | (bp->mb_var ? regex_mbmask(bp, objs, bp->mb_var, text, size) : 0);
+        d = ((d << 1) & b) | (d & bp->repeat & b) | init;
+        if (bp->optional)
+            d = closure(bp, d);
+        text += size;
+    }
+}
+
+/* Finds the leftmost occurrence in text[pos, n). Returns n when not found. */
+static size_t bndm_find(const bitpar_t* bp, const char* text, size_t n, size_t pos) {
+    const size_t m = (size_t)bp->len;
+    while (pos + m <= n) {
+        size_t j = m, last = m;
+        uint64_t d = BIT(m) - 1;
+        while (j > 0 && d) {
+            uint8_t c = (uint8_t)text[pos + j - 1];
+            if (bp->bytes)
+                d &= byte_mask(bp, c) >> 1;
+            else
+                d &= (c <= ASCII_MAX) ? bp->ascii[c] >> 1 : 0;
+            j--;
+            if (d & 1) {
+                if (j == 0)
+                    return pos;
+                last = j;
+            }
+            d >>= 1;
+        }
+        pos += last;
+    }
+    return n;
+}
+
+static int bndm(const bitpar_t* bp, const char* text) {
+    const size_t n = strlen(text);
+    const size_t pos = bndm_find(bp, text, n, 0);
+    if (pos == n)
+        return 0;
+    if (bp->bytes)
+        return 1;
+    /* Found the leftmost occurrence. Check runes around it. */
+    return tsm_utf8_valid(text, pos) && tsm_rune_size(text + pos + (size_t)bp->len);
+}
+
+int bp_match_regex(const bitpar_t* bp, const regex_t* objs, const char* text) {
+    if (bp->use_bndm)
+        return bndm(bp, text);
+    return shift_and(bp, objs, text, 0);
+}
+
+int bp_fullmatch_regex(const bitpar_t* bp, const regex_t* objs, const char* text) {
+    return shift_and(bp, objs, text, 1);
+}
+
+size_t bp_count_bndm(const bitpar_t* bp, const char* text, size_t n) {
+    size_t count = 0;
+    size_t pos = bndm_find(bp, text, n, 0);
+    while (pos != n) {
+        count++;
+        pos = bndm_find(bp, text, n, pos + (size_t)bp->len);
+    }
+    return count;
+}
+
+const char* bp_find_segment(const bitpar_t* bp, int first, int last,
+                            const char* text, const char* limit,
+                            bp_mbmask_fn mbmask, const void* ctx) {
+    const uint64_t start = BIT(first);
+    const uint64_t accept = BIT(last);
+    const uint64_t seg = (~(uint64_t)0 >> (63 - last)) & ~(start - 1);
+    const uint64_t mb_var = bp->mb_var & seg;
+    uint64_t d = 0;
+    while (text < limit) {
+        uint64_t b;
+        int size = bp->bytes ? 1 : tsm_rune_size(text);
+        if (bp->bytes)
+            b = byte_mask(bp, (uint8_t)*text);
+        else if (size == 1)
+            b = bp->ascii[(uint8_t)*text];
+        else
+            b = bp->mb_fixed | (mb_var ? mbmask(bp, ctx, mb_var, text, size) : 0);
+        d = ((d << 1) | start) & b & seg;
+        text += size;
+        if (d & accept)
+            return text;
+    }
+    return NULL;
+}
@@ -0,0 +1,73 @@
+/*
+ * Bit-parallel matching for short patterns.
+ *
+ * Each position of a pattern is a bit of a machine word.
+ * Bit 0 is the initial state, and bit i (1 <= i <= len) is the i-th position.
+ *
+ *   Shift-And   Forward scan. Supports optional (?) and repeatable (+, *) positions
+ *               with the extended Shift-And algorithm by Navarro and Raffinot.
+ *   BNDM        Backward scan that skips windows.
+ *               Used for fixed-length patterns that match only ASCII characters.
+ *
+ * In byte mode, each byte is a character and has an entry in the tables.
+ *
+ */
+
+#ifndef __TINY_STR_MATCH_INCLUDE_BITPAR_H__
+#define __TINY_STR_MATCH_INCLUDE_BITPAR_H__
+
+#include <stdint.h>
+
+#define BP_MAX_POSITIONS 63
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct bitpar_t {
+    uint64_t ascii[128];  /* positions that match each ASCII character */
+    uint64_t latin1[128]; /* positions that match each byte 0x80 ~ 0xFF in byte mode */
+    uint64_t mb_fixed;    /* positions that match any multi-byte character */
+    uint64_t mb_var;      /* positions that should be tested for each multi-byte character */
+    uint64_t repeat;      /* repeatable positions (+ and *) */
+    uint64_t optional;    /* optional positions (? and *) */
+    uint64_t opt_begin;   /* positions just before each block of optional positions */
+    uint64_t opt_end;     /* last positions of each block of optional positions */
+    uint64_t accept;      /* the last position */
+    int len;              /* number of positions */
+    int anchored_begin;   /* has '^' */
+    int anchored_end;     /* has '$' */
+    int use_bndm;         /* fixed-length, and ASCII-only or in byte mode */
+    int bytes;            /* byte mode: each byte is a Latin-1 character (TSM_FLAG_BYTES) */
+    uint32_t src[BP_MAX_POSITIONS];  /* where each position comes from */
+} bitpar_t;
+
+/* Computes positions in `mask` that match a multi-byte character. */
+typedef uint64_t (*bp_mbmask_fn)(const bitpar_t* bp, const void* ctx, uint64_t mask,
+                                 const char* c, int c_size);
+
+/* Compiles regex objects. Returns zero when the pattern can't be bit-parallel. */
+struct regex_t;
+int bp_compile_regex(bitpar_t* bp, const struct regex_t* objs);
+
+/* Searches the regex pattern. Returns non-zero when the text has the pattern. */
+int bp_match_regex(const bitpar_t* bp, const struct regex_t* objs, const char* text);
+
+/* Checks if the whole text matches the regex pattern. */
+int bp_fullmatch_regex(const bitpar_t* bp, const struct regex_t* objs, const char* text);
+
+/* Counts non-overlapping occurrences of a BNDM pattern in the first n bytes of the text.
+ * The text should be valid UTF-8 unless in byte mode. */
+size_t bp_count_bndm(const bitpar_t* bp, const char* text, size_t n);
+
+/* Finds the end of the first occurrence of positions [first, last] in [text, limit).
+ * Returns NULL when not found. The text should be valid UTF-8 unless in byte mode. */
+const char* bp_find_segment(const bitpar_t* bp, int first, int last,
+                            const char* text, const char* limit,
+                            bp_mbmask_fn mbmask, const void* ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __TINY_STR_MATCH_INCLUDE_BITPAR_H__
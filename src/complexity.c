@@ -0,0 +1,187 @@
+/*
+ * Static analysis of backtracking time. (See complexity.h)
+ */
+
+#include <string.h>
+#include "str_match.h"
+#include "utf.h"
+#include "re.h"
+#include "complexity.h"
+
+/* All bytes in byte mode. ASCII, samples, and pattern characters fit in utf-8 mode. */
+#define MAX_WITNESSES 256
+#define WITNESS_WORDS (MAX_WITNESSES / 64)
+
+/* Characters to compare atoms with */
+typedef struct witnesses_t {
+    char c[MAX_WITNESSES][4];
+    int size[MAX_WITNESSES];
+    int count;
+} witnesses_t;
+
+/* An atom of a branch and its quantifier */
+typedef struct item_t {
+    uint64_t set[WITNESS_WORDS];  /* witnesses that the atom matches */
+    int required;    /* takes at least one character */
+    int loop;        /* unbounded */
+    int possessive;  /* never gives characters back */
+    int blocks;      /* misplaced anchors and quantifiers without atoms */
+} item_t;
+
+static void add_witness(witnesses_t* w, const char* c, int size) {
+    int i;
+    for (i = 0; i < w->count; i++) {
+        if (w->size[i] == size && memcmp(w->c[i], c, (size_t)size) == 0)
+            return;
+    }
+    if (w->count == MAX_WITNESSES)
+        return;
+    memcpy(w->c[w->count], c, (size_t)size);
+    w->size[w->count++] = size;
+}
+
+static void add_rune(witnesses_t* w, uint32_t cp) {
+    char buf[4];
+    add_witness(w, buf, tsm_rune_encode(cp, buf));
+}
+
+static void collect(witnesses_t* w, const regex_t* objs) {
+    /* A letter, a digit, spaces, and a symbol for \w, \d, and \s with RE_UNICODE */
+    static const uint32_t samples[] = { 0xE9, 0x663, 0xA0, 0x3000, 0x2603 };
+    const uint8_t* s;
+    size_t i;
+    int size;
+
+    w->count = 0;
+    for (i = 0; i <= ASCII_MAX; i++)
+        add_rune(w, (uint32_t)i);
+    if (objs[0].flags & RE_BYTES) {
+        /* Latin-1 characters are stored as utf-8. */
+        for (i = ASCII_MAX + 1; i <= 0xFF; i++)
+            add_rune(w, (uint32_t)i);
+        return;
+    }
+    for (i = 0; i < sizeof(samples) / sizeof(samples[0]); i++)
+        add_rune(w, samples[i]);
+    for (; objs->type != UNUSED; objs++) {
+        if (objs->type == CHAR) {
+            add_witness(w, (const char*)objs->u.ch, objs->ch_size);
+        } else if (objs->type == ICASE_CHAR) {
+            uint32_t cp = objs->u.cp[0];
+            do {
+                add_rune(w, cp);
+                cp = tsm_rune_orbit(cp);
+            } while (cp != objs->u.cp[0]);
+        } else if (objs->type == CHAR_CLASS || objs->type == INV_CHAR_CLASS) {
+            /* Ends of ranges. Ranges that overlap share one of them. */
+            for (s = objs->u.ccl->str; s != NULL && *s; s += size) {
+                size = tsm_rune_size((const char*)s);
+                if (!size)
+                    break;
+                if (size > 1)
+                    add_witness(w, (const char*)s, size);
+            }
+        }
+    }
+}
+
+static int intersects(const uint64_t* a, const uint64_t* b) {
+    int i;
+    for (i = 0; i < WITNESS_WORDS; i++) {
+        if (a[i] & b[i])
+            return 1;
+    }
+    return 0;
+}
+
+/* Reads the items of the branch at *pos, and moves it to the following '|' or the end. */
+static int read_branch(const witnesses_t* w, const regex_t* objs, item_t* items, int* pos) {
+    const regex_t* q;
+    int i = *pos, n = 0, k;
+
+    if (objs[i].type == BEGIN)
+        i++;
+    for (; objs[i].type != UNUSED && objs[i].type != BRANCH; i++) {
+        item_t* it = &items[n];
+        if (objs[i].type == END && (objs[i + 1].type == UNUSED || objs[i + 1].type == BRANCH))
+            continue;
+        memset(it, 0, sizeof(item_t));
+        n++;
+        if (!re_isatom(objs[i].type)) {
+            it->blocks = 1;
+            continue;
+        }
+        for (k = 0; k < w->count; k++) {
+            if (re_matchone(&objs[i], w->c[k], w->size[k]))
+                it->set[k >> 6] |= (uint64_t)1 << (k & 63);
+        }
+        q = &objs[i + 1];
+        switch (q->type) {
+            case QUESTIONMARK:
+                break;
+            case STAR:
+                it->loop = 1;
+                break;
+            case PLUS:
+                it->required = 1;
+                it->loop = 1;
+                break;
+            case TIMES:
+                it->required = q->u.times.n > 0;
+                it->loop = q->u.times.m == MAX_USHORT;
+                break;
+            default:
+                it->required = 1;
+                continue;
+        }
+        it->possessive = (q->flags & RE_POSSESSIVE) != 0;
+        i++;
+    }
+    *pos = i;
+    return n;
+}
+
+/* Checks if repetitions p and q can take the same characters,
+ * and the items between them can match some of those characters. */
+static int overlaps(const item_t* items, int p, int q) {
+    uint64_t shared[WITNESS_WORDS];
+    int i;
+    for (i = 0; i < WITNESS_WORDS; i++)
+        shared[i] = items[p].set[i] & items[q].set[i];
+    if (!intersects(shared, shared))
+        return 0;
+    for (i = p + 1; i < q; i++) {
+        if (items[i].blocks || (items[i].required && !intersects(items[i].set, shared)))
+            return 0;
+    }
+    return 1;
+}
+
+int re_complexity(const regex_t* objs) {
+    witnesses_t w;
+    item_t items[MAX_REGEXP_OBJECTS];
+    int chain[MAX_REGEXP_OBJECTS];
+    int worst = 1, pos = 0, n, p, q;
+
+    collect(&w, objs);
+    for (;;) {
+        /* The longest chain of repetitions where each one overlaps the previous one.
+         * Possessive ones scan their run each time, but have no choices for the rest. */
+        n = read_branch(&w, objs, items, &pos);
+        for (q = 0; q < n; q++) {
+            if (!items[q].loop)
+                continue;
+            chain[q] = 1;
+            for (p = 0; p < q; p++) {
+                if (items[p].loop && !items[p].possessive && chain[p] >= chain[q] &&
+                    overlaps(items, p, q))
+                    chain[q] = chain[p] + 1;
+            }
+            if (chain[q] > worst)
+                worst = chain[q];
+        }
+        if (objs[pos].type == UNUSED)
+            return worst;
+        pos++;
+    }
+}
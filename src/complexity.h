@@ -0,0 +1,37 @@
+/*
+ * Static analysis of backtracking time for regex patterns.
+ *
+ * The backtracking engines (re.c, the VM, and the JIT) try the repetitions of each quantifier
+ * one by one. Two repetitions that can take the same characters, such as "\w*\w*!",
+ * split a run of n characters in n ways before '!' fails, so an attempt takes O(n^2) steps.
+ * A chain of k such repetitions takes O(n^k) steps.
+ *
+ * Repetitions overlap when both atoms match a common character, and the atoms between them
+ * can match characters of both. The atoms are compared with sample characters:
+ * all ASCII characters (all bytes in byte mode), non-ASCII characters of the pattern,
+ * and some letters, digits, and spaces for TSM_FLAG_UNICODE.
+ * Only unbounded repetitions count. {n,m} takes constant time.
+ * Possessive quantifiers never give characters back, so they can only end a chain:
+ * "\w*\w*+!" scans the rest of the run after each backtrack of "\w*".
+ *
+ * Exponential time needs a repetition inside another repetition, such as "(a+)+",
+ * or a group of branches that can take the same text. The pattern syntax has no groups.
+ *
+ */
+
+#ifndef __TINY_STR_MATCH_INCLUDE_COMPLEXITY_H__
+#define __TINY_STR_MATCH_INCLUDE_COMPLEXITY_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Finds the degree k of the worst O(n^k) steps of a match attempt. One means linear. */
+struct regex_t;
+int re_complexity(const struct regex_t* objs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __TINY_STR_MATCH_INCLUDE_COMPLEXITY_H__
@@ -0,0 +1,371 @@
+/*
+ * Incremental matching for text that grows or shrinks at the end. (See TsmIncremental)
+ *
+ * The bytecode (See vm.h) is turned into positions of a bit-parallel automaton
+ * like the extended Shift-And in bitpar.c. Each branch has a start bit and its positions:
+ *
+ *   "ab?|^c"   bit 0: start of "ab?"   bit 3: start of "^c"
+ *              bit 1: a                bit 4: c
+ *              bit 2: b (optional)
+ *
+ * Bit i is set when a match attempt has consumed the text up to position i.
+ * Start bits are set again after each character unless the branch starts with '^',
+ * so attempts can start anywhere. {n,m} is unrolled to n positions and m - n optional ones.
+ * A character takes a few operations for each word, and multi-byte characters test each atom.
+ *
+ * The state after each character is kept, so removing characters only drops states.
+ * Whether a match exists doesn't depend on the order that matchers try things,
+ * so the results are the same as tsm_regex_match_compiled() and tsm_regex_fullmatch_compiled().
+ * After an invalid utf-8 character, the text stays complete when a match ended
+ * before the character in front of it, and is dead otherwise. Those functions also fail
+ * when they read the invalid character, so they fail on "bb\xff" for "b+" where
+ * the text is complete here.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "str_match.h"
+#include "utf.h"
+#include "re.h"
+
+#define INC_MAX_WORDS 16  /* up to 1024 bits */
+
+/* Flags after the bits of each state */
+#define INC_FOUND   1  /* a match ended, and longer text still has it */
+#define INC_INVALID 2  /* got an invalid utf-8 character */
+
+#define bit_set(set, i) ((set)[(i) >> 6] |= (uint64_t)1 << ((i) & 63))
+#define bit_get(set, i) (((set)[(i) >> 6] >> ((i) & 63)) & 1)
+
+struct TsmIncremental {
+    const TsmRegex* compiled;
+    int words;             /* words for each bit set */
+    int bytes;             /* each byte is a Latin-1 character (RE_BYTES) */
+    uint64_t* table;       /* positions that match each single-byte character */
+    uint64_t* atoms;       /* positions of each instruction */
+    uint64_t* repeat;      /* positions that can repeat */
+    uint64_t* optional;    /* positions that can be skipped */
+    uint64_t* starts;      /* start bits that are set after each character */
+    uint64_t* accept_end;  /* last bits of branches that should reach the end ('$' or full) */
+    uint64_t* accept_any;  /* last bits of other branches */
+    uint64_t* live;        /* bits that can reach the last bit of the branch */
+    uint64_t* row;         /* positions that match a multi-byte character */
+    uint64_t* history;     /* states for 0 to len characters. Each has words + 1 (flags) */
+    size_t len;            /* number of characters */
+    size_t cap;            /* number of states that history can hold */
+};
+
+/* Counts bits for the program. Returns zero when it needs too many. */
+static int count_bits(const vm_prog_t* prog) {
+    size_t bits = 0;
+    int b, pc;
+    for (b = 0; b < prog->branch_count; b++) {
+        bits++;
+        for (pc = prog->entries[b];
+             prog->insts[pc].op != VM_JMP && prog->insts[pc].op != VM_MATCH; pc++) {
+            const vm_inst_t* inst = &prog->insts[pc];
+            if (inst->op == VM_BEGIN || inst->op == VM_END)
+                continue;
+            if (inst->possessive)
+                return 0;  /* Sets of states can't give up a choice. */
+            if (inst->op != VM_RANGE)
+                bits++;
+            else if (inst->y != MAX_USHORT)
+                bits += inst->y;
+            else
+                bits += inst->x ? inst->x : 1;
+            if (bits > INC_MAX_WORDS * 64)
+                return 0;
+        }
+    }
+    return (int)bits;
+}
+
+/* Same as the atom tests of the VM. Bytes over 0x7F are encoded in byte mode. */
+static int test(const vm_inst_t* inst, const regex_t* objs, const char* c, int c_size) {
+    if (inst->op == VM_CHAR)
+        return c_size == 1 && (uint8_t)*c == inst->ch;
+    if (c_size == 1)
+        return (inst->ascii[(uint8_t)*c >> 5] >> (*c & 31)) & 1;
+    if (inst->mb == RE_MB_TEST)
+        return re_matchone(&objs[inst->obj], c, c_size);
+    return inst->mb == RE_MB_ANY;
+}
+
+static int can_match(const vm_inst_t* inst) {
+    return inst->op == VM_CHAR || inst->mb != RE_MB_NONE ||
+           inst->ascii[0] || inst->ascii[1] || inst->ascii[2] || inst->ascii[3];
+}
+
+static uint64_t* state(const TsmIncremental* inc, size_t len) {
+    return inc->history + len * (size_t)(inc->words + 1);
+}
+
+static int intersects(const TsmIncremental* inc, const uint64_t* a, const uint64_t* b) {
+    int i;
+    for (i = 0; i < inc->words; i++) {
+        if (a[i] & b[i])
+            return 1;
+    }
+    return 0;
+}
+
+/* Skips optional positions. Runs of them take a pass for each position. */
+static void closure(const TsmIncremental* inc, uint64_t* d) {
+    int changed = 1, i;
+    while (changed) {
+        uint64_t carry = 0;
+        changed = 0;
+        for (i = 0; i < inc->words; i++) {
+            uint64_t next = d[i] | (((d[i] << 1) | carry) & inc->optional[i]);
+            carry = next >> 63;
+            if (next != d[i]) {
+                d[i] = next;
+                changed = 1;
+            }
+        }
+    }
+}
+
+static void step(const TsmIncremental* inc, const uint64_t* cur, uint64_t* next,
+                 const uint64_t* row) {
+    uint64_t carry = 0;
+    int i;
+    for (i = 0; i < inc->words; i++) {
+        uint64_t d = cur[i];
+        next[i] = (((d << 1) | carry) & row[i]) | (d & inc->repeat[i] & row[i]) | inc->starts[i];
+        carry = d >> 63;
+    }
+    closure(inc, next);
+    next[inc->words] = cur[inc->words];
+    if (intersects(inc, next, inc->accept_any))
+        next[inc->words] |= INC_FOUND;
+}
+
+static void build(TsmIncremental* inc, int full) {
+    const vm_prog_t* prog = &inc->compiled->vm;
+    const regex_t* objs = inc->compiled->objs;
+    const int words = inc->words;
+    const int rows = inc->bytes ? 256 : ASCII_MAX + 1;
+    uint64_t passable[INC_MAX_WORDS];  /* positions that can be matched or skipped */
+    uint64_t* init = state(inc, 0);
+    char buf[4];
+    int bit = 0, b, pc, k, c, i;
+
+    memset(passable, 0, sizeof(passable));
+    for (b = 0; b < prog->branch_count; b++) {
+        int start = bit++, anchored = full, end_anchored = full;
+        for (pc = prog->entries[b];
+             prog->insts[pc].op != VM_JMP && prog->insts[pc].op != VM_MATCH; pc++) {
+            const vm_inst_t* inst = &prog->insts[pc];
+            int unbounded = inst->op == VM_RANGE && inst->y == MAX_USHORT;
+            int count = 1;
+            if (inst->op == VM_BEGIN) {
+                anchored = 1;
+                continue;
+            }
+            if (inst->op == VM_END) {
+                end_anchored = 1;
+                continue;
+            }
+            if (inst->op == VM_RANGE)
+                count = unbounded ? (inst->x ? inst->x : 1) : inst->y;
+            for (k = 0; k < count; k++, bit++) {
+                bit_set(&inc->atoms[pc * words], bit);
+                if (can_match(inst))
+                    bit_set(passable, bit);
+                if (inst->op == VM_QUEST || inst->op == VM_STAR ||
+                    (inst->op == VM_RANGE && k >= inst->x)) {
+                    bit_set(inc->optional, bit);
+                    bit_set(passable, bit);
+                }
+                if (inst->op == VM_STAR || inst->op == VM_PLUS || (unbounded && k == count - 1))
+                    bit_set(inc->repeat, bit);
+            }
+        }
+        bit_set(init, start);
+        if (!anchored)
+            bit_set(inc->starts, start);
+        bit_set(end_anchored ? inc->accept_end : inc->accept_any, bit - 1);
+        bit_set(inc->live, bit - 1);
+        for (k = bit - 1; k > start && bit_get(passable, k); k--)
+            bit_set(inc->live, k - 1);
+    }
+
+    for (pc = 0; pc < prog->len; pc++) {
+        const uint64_t* mask = &inc->atoms[pc * words];
+        if (!intersects(inc, mask, mask))
+            continue;
+        for (c = 0; c < rows; c++) {
+            int size = 1;
+            buf[0] = (char)c;
+            if (c > ASCII_MAX)
+                size = tsm_rune_encode((uint32_t)c, buf);
+            if (!test(&prog->insts[pc], objs, buf, size))
+                continue;
+            for (i = 0; i < words; i++)
+                inc->table[c * words + i] |= mask[i];
+        }
+    }
+
+    closure(inc, init);
+    init[words] = intersects(inc, init, inc->accept_any) ? INC_FOUND : 0;
+}
+
+TsmResult tsm_regex_incremental_new(const TsmRegex *compiled, int full, TsmIncremental **inc) {
+    TsmIncremental* res;
+    uint64_t* block;
+    int bits, words, rows;
+    size_t size;
+
+    if (inc == NULL)
+        return TSM_FAIL;
+    *inc = NULL;
+    if (compiled == NULL || !compiled->vm.len)
+        return TSM_FAIL;
+    bits = count_bits(&compiled->vm);
+    if (!bits)
+        return TSM_FAIL;
+
+    words = (bits + 63) / 64;
+    rows = compiled->bytes ? 256 : ASCII_MAX + 1;
+    res = (TsmIncremental*)malloc(sizeof(TsmIncremental));
+    if (res == NULL)
+        return TSM_OUT_OF_MEMORY;
+    /* The table, the atoms, and 7 sets */
+    size = (size_t)(rows + compiled->vm.len + 7) * (size_t)words;
+    block = (uint64_t*)calloc(size, sizeof(uint64_t));
+    res->cap = 16;
+    res->history = (uint64_t*)calloc(res->cap * (size_t)(words + 1), sizeof(uint64_t));
+    if (block == NULL || res->history == NULL) {
+        free(block);
+        free(res->history);
+        free(res);
+        return TSM_OUT_OF_MEMORY;
+    }
+    res->compiled = compiled;
+    res->words = words;
+    res->bytes = compiled->bytes;
+    res->table = block;
+    res->atoms = res->table + rows * words;
+    res->repeat = res->atoms + compiled->vm.len * words;
+    res->optional = res->repeat + words;
+    res->starts = res->optional + words;
+    res->accept_end = res->starts + words;
+    res->accept_any = res->accept_end + words;
+    res->live = res->accept_any + words;
+    res->row = res->live + words;
+    res->len = 0;
+    build(res, full);
+    *inc = res;
+    return TSM_OK;
+}
+
+/* Keeps the matches before an invalid character at the end of the text.
+ * Like the other engines, a match can't end right before the invalid character. */
+static uint64_t found_before(const TsmIncremental* inc) {
+    if (inc->len == 0)
+        return 0;
+    return state(inc, inc->len - 1)[inc->words] & INC_FOUND;
+}
+
+/* Makes room for n states. */
+static int reserve(TsmIncremental* inc, size_t n) {
+    const size_t state_size = (size_t)(inc->words + 1) * sizeof(uint64_t);
+    size_t cap = inc->cap;
+    uint64_t* history;
+    if (n <= cap)
+        return 1;
+    while (cap < n) {
+        if (cap > SIZE_MAX / 2 / state_size)
+            return 0;
+        cap *= 2;
+    }
+    history = (uint64_t*)realloc(inc->history, cap * state_size);
+    if (history == NULL)
+        return 0;
+    inc->history = history;
+    inc->cap = cap;
+    return 1;
+}
+
+TsmResult tsm_regex_incremental_push(TsmIncremental *inc, const char *str, size_t len) {
+    const regex_t* objs;
+    const vm_prog_t* prog;
+    int words, pc, i;
+
+    if (inc == NULL || (str == NULL && len))
+        return TSM_FAIL;
+    /* Each character has one byte or more. */
+    if (len > SIZE_MAX - inc->len - 1 || !reserve(inc, inc->len + 1 + len))
+        return TSM_OUT_OF_MEMORY;
+
+    objs = inc->compiled->objs;
+    prog = &inc->compiled->vm;
+    words = inc->words;
+    while (len) {
+        const uint64_t* cur = state(inc, inc->len);
+        uint64_t* next = state(inc, inc->len + 1);
+        int size = inc->bytes ? 1 : tsm_rune_size_n(str, len);
+        if (!size || (cur[words] & INC_INVALID)) {
+            memset(next, 0, (size_t)words * sizeof(uint64_t));
+            next[words] = INC_INVALID | (cur[words] & INC_INVALID ? cur[words] : found_before(inc));
+            size = size ? size : 1;
+        } else if (size == 1) {
+            step(inc, cur, next, &inc->table[(uint8_t)*str * words]);
+        } else {
+            memset(inc->row, 0, (size_t)words * sizeof(uint64_t));
+            for (pc = 0; pc < prog->len; pc++) {
+                const uint64_t* mask = &inc->atoms[pc * words];
+                if (!intersects(inc, mask, mask) || !test(&prog->insts[pc], objs, str, size))
+                    continue;
+                for (i = 0; i < words; i++)
+                    inc->row[i] |= mask[i];
+            }
+            step(inc, cur, next, inc->row);
+        }
+        inc->len++;
+        str += size;
+        len -= (size_t)size;
+    }
+    return TSM_OK;
+}
+
+TsmResult tsm_regex_incremental_pop(TsmIncremental *inc, size_t count) {
+    if (inc == NULL || count > inc->len)
+        return TSM_FAIL;
+    inc->len -= count;
+    return TSM_OK;
+}
+
+void tsm_regex_incremental_reset(TsmIncremental *inc) {
+    if (inc != NULL)
+        inc->len = 0;
+}
+
+size_t tsm_regex_incremental_length(const TsmIncremental *inc) {
+    return inc == NULL ? 0 : inc->len;
+}
+
+TsmPrefixStatus tsm_regex_incremental_status(const TsmIncremental *inc) {
+    const uint64_t* cur;
+    if (inc == NULL)
+        return TSM_PREFIX_DEAD;
+    cur = state(inc, inc->len);
+    if (cur[inc->words] & INC_INVALID)
+        return (cur[inc->words] & INC_FOUND) ? TSM_PREFIX_COMPLETE : TSM_PREFIX_DEAD;
+    if ((cur[inc->words] & INC_FOUND) || intersects(inc, cur, inc->accept_end))
+        return TSM_PREFIX_COMPLETE;
+    if (intersects(inc, cur, inc->live))
+        return TSM_PREFIX_VIABLE;
+    return TSM_PREFIX_DEAD;
+}
+
+void tsm_regex_incremental_free(TsmIncremental *inc) {
+    if (inc == NULL)
+        return;
+    free(inc->table);
+    free(inc->history);
+    free(inc);
+}
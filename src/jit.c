@@ -0,0 +1,708 @@
+/*
+ * x86-64 JIT compiler for the regex bytecode. (See jit.h)
+ *
+ * Registers while the code runs:
+ *
+ *   rbx  arguments (jit_args_t)
+ *   rbp  the beginning of the text
+ *   r12  the current position
+ *   r13  the end of the text
+ *   r14  the next backtracking frame
+ *   r15  the first backtracking frame
+ *
+ * They are callee-saved in the System V ABI, so calls to C functions keep them.
+ * A frame has the resume address, the position, the start of VM_STAR and VM_PLUS,
+ * and the number of repetitions of VM_RANGE, in the same way as the VM.
+ *
+ * The main blocks of the instructions are laid out in order, so they fall through.
+ * The blocks that resume frames follow them.
+ */
+
+#if defined(__linux__) && !defined(_DEFAULT_SOURCE)
+#define _DEFAULT_SOURCE  /* MAP_ANONYMOUS */
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include "str_match.h"
+#include "utf.h"
+#include "re.h"
+#include "jit.h"
+
+#if defined(__x86_64__) && defined(__linux__) && \
+    !defined(TSM_NO_JIT) && !defined(TSM_PROFILE)
+#define JIT_X64
+#include <sys/mman.h>
+#endif
+
+typedef struct jit_args_t {
+    const char* begin;
+    const char* end;
+    const char* text;
+    const char* match_end;  /* set when matched */
+    void* frames;
+    size_t full;
+} jit_args_t;
+
+typedef int (*jit_fn_t)(jit_args_t* args);
+
+struct jit_code_t {
+    void* mem;
+    size_t size;
+    jit_fn_t fn;
+};
+
+#define FRAME_SIZE 32
+
+int jit_run(const jit_code_t* jit, const char* begin, const char* end,
+            const char* text, int full, const char** match_end) {
+    uint64_t frames[VM_MAX_INSTS * FRAME_SIZE / 8];
+    jit_args_t args;
+    args.begin = begin;
+    args.end = end;
+    args.text = text;
+    args.match_end = NULL;
+    args.frames = frames;
+    args.full = (size_t)full;
+    if (!jit->fn(&args))
+        return 0;
+    *match_end = args.match_end;
+    return 1;
+}
+
+#ifdef JIT_X64
+
+#define JIT_DATA_SIZE (VM_MAX_INSTS * 32)  /* a 256-bit table for each instruction */
+#define JIT_CODE_SIZE 65536                /* including the tables */
+#define JIT_MAX_LABELS 1024
+#define JIT_MAX_FIXUPS 2048
+
+enum { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R12 = 12, R13, R14, R15 };
+#define REG_ARGS   RBX
+#define REG_BEGIN  RBP
+#define REG_TEXT   R12
+#define REG_END    R13
+#define REG_FP     R14
+#define REG_FRAMES R15
+
+/* Offsets of jit_args_t and frames */
+#define ARG_BEGIN     0
+#define ARG_END       8
+#define ARG_TEXT      16
+#define ARG_MATCH_END 24
+#define ARG_FRAMES    32
+#define ARG_FULL      40
+#define FRAME_RESUME  0
+#define FRAME_TEXT    8
+#define FRAME_LOW     16
+#define FRAME_COUNT   24
+
+/* Condition codes */
+enum { CC_B = 0x2, CC_AE = 0x3, CC_E = 0x4, CC_NE = 0x5, CC_BE = 0x6, CC_A = 0x7 };
+
+typedef struct asm_t {
+    uint8_t* code;
+    size_t len;
+    int error;  /* the code or the labels didn't fit */
+    size_t labels[JIT_MAX_LABELS];
+    int label_count;
+    size_t fixups[JIT_MAX_FIXUPS];  /* positions of rel32 operands */
+    int fixup_labels[JIT_MAX_FIXUPS];
+    int fixup_count;
+    /* Program */
+    const vm_prog_t* prog;
+    const regex_t* objs;
+    int entries[VM_MAX_INSTS];  /* labels of the main blocks */
+    int resumes[VM_MAX_INSTS];  /* labels of the resume blocks */
+    int fail;
+} asm_t;
+
+static void byte(asm_t* a, int b) {
+    if (a->len >= JIT_CODE_SIZE) {
+        a->error = 1;
+        return;
+    }
+    a->code[a->len++] = (uint8_t)b;
+}
+
+static void imm32(asm_t* a, uint32_t v) {
+    int i;
+    for (i = 0; i < 4; i++)
+        byte(a, (int)(v >> (i * 8)) & 0xFF);
+}
+
+static void imm64(asm_t* a, uint64_t v) {
+    imm32(a, (uint32_t)v);
+    imm32(a, (uint32_t)(v >> 32));
+}
+
+static int new_label(asm_t* a) {
+    if (a->label_count >= JIT_MAX_LABELS) {
+        a->error = 1;
+        return 0;
+    }
+    a->labels[a->label_count] = 0;
+    return a->label_count++;
+}
+
+static void bind(asm_t* a, int label) {
+    a->labels[label] = a->len;
+}
+
+/* A 32-bit displacement to a label. It's patched after all the labels are bound. */
+static void rel32(asm_t* a, int label) {
+    if (a->fixup_count >= JIT_MAX_FIXUPS) {
+        a->error = 1;
+        return;
+    }
+    a->fixups[a->fixup_count] = a->len;
+    a->fixup_labels[a->fixup_count++] = label;
+    imm32(a, 0);
+}
+
+static void rex(asm_t* a, int w, int reg, int rm) {
+    int r = 0x40 | (w << 3) | ((reg >> 3) << 2) | (rm >> 3);
+    if (r != 0x40)
+        byte(a, r);
+}
+
+/* ModRM for [base + disp8]. */
+static void modrm(asm_t* a, int reg, int base, int disp) {
+    byte(a, 0x40 | (reg & 7) << 3 | (base & 7));
+    if ((base & 7) == RSP)
+        byte(a, 0x24);  /* SIB for rsp and r12 */
+    byte(a, disp & 0xFF);
+}
+
+static void op_mem(asm_t* a, int w, int op, int reg, int base, int disp) {
+    rex(a, w, reg, base);
+    byte(a, op);
+    modrm(a, reg, base, disp);
+}
+
+static void op_reg(asm_t* a, int w, int op, int reg, int rm) {
+    rex(a, w, reg, rm);
+    byte(a, op);
+    byte(a, 0xC0 | (reg & 7) << 3 | (rm & 7));
+}
+
+#define load(a, dst, base, disp)       op_mem(a, 1, 0x8B, dst, base, disp)
+#define store(a, base, disp, src)      op_mem(a, 1, 0x89, src, base, disp)
+#define mov(a, dst, src)               op_reg(a, 1, 0x89, src, dst)
+#define cmp(a, x, y)                   op_reg(a, 1, 0x39, y, x)
+#define cmp_mem(a, r, base, disp)      op_mem(a, 1, 0x3B, r, base, disp)
+#define add(a, dst, src)               op_reg(a, 1, 0x01, src, dst)
+#define inc_mem(a, base, disp)         op_mem(a, 1, 0xFF, 0, base, disp)
+#define jmp_mem(a, base, disp)         op_mem(a, 0, 0xFF, 4, base, disp)
+#define test_rax(a)                    op_reg(a, 1, 0x85, RAX, RAX)
+
+static void add_imm(asm_t* a, int r, int v) {
+    op_reg(a, 1, 0x83, 0, r);
+    byte(a, v & 0xFF);
+}
+
+static void cmp_mem_imm(asm_t* a, int base, int disp, uint32_t v) {
+    op_mem(a, 1, 0x81, 7, base, disp);
+    imm32(a, v);
+}
+
+static void store_imm(asm_t* a, int base, int disp, uint32_t v) {
+    op_mem(a, 1, 0xC7, 0, base, disp);
+    imm32(a, v);
+}
+
+static void mov_imm(asm_t* a, int r, uint64_t v) {
+    rex(a, 1, 0, r);
+    byte(a, 0xB8 + (r & 7));
+    imm64(a, v);
+}
+
+/* movzx eax, byte [base] */
+static void load_byte(asm_t* a, int base) {
+    rex(a, 0, RAX, base);
+    byte(a, 0x0F);
+    byte(a, 0xB6);
+    modrm(a, RAX, base, 0);
+}
+
+static void cmp_eax(asm_t* a, uint32_t v) {
+    byte(a, 0x3D);
+    imm32(a, v);
+}
+
+static void and_eax(asm_t* a, uint32_t v) {
+    byte(a, 0x25);
+    imm32(a, v);
+}
+
+/* bt [rcx], eax. CF is the bit. */
+static void bt_rcx(asm_t* a) {
+    byte(a, 0x0F);
+    byte(a, 0xA3);
+    byte(a, 0x01);
+}
+
+static void call(asm_t* a, uintptr_t fn) {
+    mov_imm(a, RAX, fn);
+    byte(a, 0xFF);
+    byte(a, 0xD0);
+}
+
+static void jmp(asm_t* a, int label) {
+    byte(a, 0xE9);
+    rel32(a, label);
+}
+
+static void jcc(asm_t* a, int cc, int label) {
+    byte(a, 0x0F);
+    byte(a, 0x80 | cc);
+    rel32(a, label);
+}
+
+/* lea r, [rip + label] */
+static void lea_label(asm_t* a, int r, int label) {
+    rex(a, 1, r, 0);
+    byte(a, 0x8D);
+    byte(a, 0x05 | (r & 7) << 3);
+    rel32(a, label);
+}
+
+static void push(asm_t* a, int r) {
+    rex(a, 0, 0, r);
+    byte(a, 0x50 + (r & 7));
+}
+
+static void pop(asm_t* a, int r) {
+    rex(a, 0, 0, r);
+    byte(a, 0x58 + (r & 7));
+}
+
+/* Functions for slow paths. The text starts with a multi-byte character. */
+static size_t jit_runesize(const char* text, const char* end) {
+    return (size_t)tsm_rune_size_n(text, (size_t)(end - text));
+}
+
+static size_t jit_test(const vm_inst_t* inst, const regex_t* objs,
+                       const char* text, const char* end) {
+    size_t size = jit_runesize(text, end);
+    if (inst->mb == RE_MB_TEST)
+        return re_matchone(&objs[inst->obj], text, (int)size) ? size : 0;
+    return size;  /* RE_MB_ANY */
+}
+
+static const span_t* inst_span(const asm_t* a, const vm_inst_t* inst) {
+    const span_t* sp;
+    if (!a->prog->spans)
+        return NULL;
+    sp = &a->prog->spans[inst->obj];
+    return sp->kind == SPAN_NONE ? NULL : sp;
+}
+
+/* Matches the atom at r12 and moves over the character. Jumps to nomatch otherwise. */
+static void emit_atom(asm_t* a, const vm_inst_t* inst, const uint8_t* table, int nomatch) {
+    int mb = -1, done = -1;
+    cmp(a, REG_TEXT, REG_END);
+    jcc(a, CC_E, nomatch);
+    load_byte(a, REG_TEXT);
+    if (inst->op == VM_CHAR) {
+        cmp_eax(a, inst->ch);
+        jcc(a, CC_NE, nomatch);
+        add_imm(a, REG_TEXT, 1);
+        return;
+    }
+    if (!a->prog->bytes) {
+        cmp_eax(a, 0x80);
+        if (inst->mb == RE_MB_NONE) {
+            jcc(a, CC_AE, nomatch);
+        } else {
+            mb = new_label(a);
+            done = new_label(a);
+            jcc(a, CC_AE, mb);
+        }
+    }
+    mov_imm(a, RCX, (uintptr_t)table);
+    bt_rcx(a);
+    jcc(a, CC_AE, nomatch);
+    add_imm(a, REG_TEXT, 1);
+    if (mb < 0)
+        return;
+    jmp(a, done);
+    bind(a, mb);
+    mov_imm(a, RDI, (uintptr_t)inst);
+    mov_imm(a, RSI, (uintptr_t)a->objs);
+    mov(a, RDX, REG_TEXT);
+    mov(a, RCX, REG_END);
+    call(a, (uintptr_t)jit_test);
+    test_rax(a);
+    jcc(a, CC_E, nomatch);
+    add(a, REG_TEXT, RAX);
+    bind(a, done);
+}
+
+/* Checks that r12 starts with a valid character. Byte mode has no invalid characters. */
+static void emit_valid(asm_t* a, int invalid) {
+    int ok;
+    if (a->prog->bytes)
+        return;
+    ok = new_label(a);
+    cmp(a, REG_TEXT, REG_END);
+    jcc(a, CC_E, ok);
+    load_byte(a, REG_TEXT);
+    cmp_eax(a, 0x80);
+    jcc(a, CC_B, ok);
+    mov(a, RDI, REG_TEXT);
+    mov(a, RSI, REG_END);
+    call(a, (uintptr_t)jit_runesize);
+    test_rax(a);
+    jcc(a, CC_E, invalid);
+    bind(a, ok);
+}
+
+/* Calls the span scanner and moves over the run. Jumps to found when the run isn't empty. */
+static void emit_span(asm_t* a, const span_t* sp, int found) {
+    mov_imm(a, RDI, (uintptr_t)sp);
+    mov(a, RSI, REG_TEXT);
+    mov(a, RDX, REG_END);
+    call(a, (uintptr_t)span_scan);
+    test_rax(a);
+    jcc(a, CC_NE, found);
+}
+
+/* Pushes a frame that resumes at the label. The other fields should be set before. */
+static void emit_push(asm_t* a, int resume) {
+    lea_label(a, RAX, resume);
+    store(a, REG_FP, FRAME_RESUME, RAX);
+    store(a, REG_FP, FRAME_TEXT, REG_TEXT);
+    add_imm(a, REG_FP, FRAME_SIZE);
+}
+
+static void emit_repeat(asm_t* a, int pc, const vm_inst_t* inst, const uint8_t* table) {
+    const span_t* sp = inst_span(a, inst);
+    int loop = new_label(a), consumed = new_label(a), invalid = new_label(a);
+    int done = new_label(a), keep = new_label(a);
+    int next = a->entries[pc + 1];
+
+    store(a, REG_FP, FRAME_LOW, REG_TEXT);
+    bind(a, loop);
+    if (sp) {
+        int run = new_label(a);
+        cmp(a, REG_TEXT, REG_END);
+        jcc(a, CC_E, done);
+        emit_span(a, sp, run);
+        emit_atom(a, inst, table, done);
+        jmp(a, consumed);
+        bind(a, run);
+        add(a, REG_TEXT, RAX);
+    } else {
+        emit_atom(a, inst, table, done);
+    }
+    bind(a, consumed);
+    emit_valid(a, invalid);
+    jmp(a, loop);
+
+    /* The backtracker gives up all the repetitions at invalid characters. */
+    bind(a, invalid);
+    if (inst->op == VM_PLUS)
+        jmp(a, a->fail);
+    else
+        load(a, REG_TEXT, REG_FP, FRAME_LOW);
+
+    bind(a, done);
+    cmp_mem(a, REG_TEXT, REG_FP, FRAME_LOW);
+    jcc(a, CC_NE, keep);
+    jmp(a, inst->op == VM_PLUS ? a->fail : next);
+    bind(a, keep);
+    emit_push(a, a->resumes[pc]);
+    jmp(a, next);
+}
+
+static void emit_range(asm_t* a, int pc, const vm_inst_t* inst, const uint8_t* table) {
+    const span_t* sp = inst->x ? inst_span(a, inst) : NULL;
+    int loop = new_label(a), done = new_label(a);
+
+    store_imm(a, REG_FP, FRAME_COUNT, 0);
+    if (sp) {
+        int run = new_label(a), clamp = new_label(a);
+        emit_span(a, sp, run);
+        jmp(a, loop);
+        bind(a, run);
+        mov_imm(a, RCX, inst->x);
+        cmp(a, RAX, RCX);
+        jcc(a, CC_BE, clamp);
+        mov(a, RAX, RCX);
+        bind(a, clamp);
+        add(a, REG_TEXT, RAX);
+        store(a, REG_FP, FRAME_COUNT, RAX);
+        emit_valid(a, a->fail);
+    }
+    bind(a, loop);
+    cmp_mem_imm(a, REG_FP, FRAME_COUNT, inst->x);
+    jcc(a, CC_AE, done);
+    emit_atom(a, inst, table, a->fail);
+    emit_valid(a, a->fail);
+    inc_mem(a, REG_FP, FRAME_COUNT);
+    jmp(a, loop);
+    bind(a, done);
+    emit_push(a, a->resumes[pc]);
+    jmp(a, a->entries[pc + 1]);
+}
+
+static void emit_main(asm_t* a, int pc, const uint8_t* table) {
+    const vm_inst_t* inst = &a->prog->insts[pc];
+    int ok;
+    bind(a, a->entries[pc]);
+    switch (inst->op) {
+        case VM_CHAR:
+        case VM_CLASS:
+            emit_atom(a, inst, table, a->fail);
+            emit_valid(a, a->fail);
+            break;
+        case VM_QUEST:
+            /* Try without the atom first. */
+            emit_push(a, a->resumes[pc]);
+            break;
+        case VM_STAR:
+        case VM_PLUS:
+            emit_repeat(a, pc, inst, table);
+            break;
+        case VM_RANGE:
+            emit_range(a, pc, inst, table);
+            break;
+        case VM_BEGIN:
+            cmp(a, REG_TEXT, REG_BEGIN);
+            jcc(a, CC_NE, a->fail);
+            break;
+        case VM_END:
+            cmp(a, REG_TEXT, REG_END);
+            jcc(a, CC_NE, a->fail);
+            break;
+        case VM_SPLIT:
+            emit_push(a, a->resumes[pc]);
+            jmp(a, a->entries[inst->x]);
+            break;
+        case VM_JMP:
+            jmp(a, a->entries[inst->x]);
+            break;
+        default:  /* VM_MATCH */
+            ok = new_label(a);
+            cmp_mem_imm(a, REG_ARGS, ARG_FULL, 0);
+            jcc(a, CC_E, ok);
+            cmp(a, REG_TEXT, REG_END);
+            jcc(a, CC_NE, a->fail);
+            bind(a, ok);
+            store(a, REG_ARGS, ARG_MATCH_END, REG_TEXT);
+            byte(a, 0xB8);  /* mov eax, 1 */
+            imm32(a, 1);
+            break;
+    }
+}
+
+/* Code for popped frames. r14 points to the frame, and r12 has its position. */
+static void emit_resume(asm_t* a, int pc, const uint8_t* table) {
+    const vm_inst_t* inst = &a->prog->insts[pc];
+    int next = a->entries[pc + 1];
+    int back, stop, keep;
+    bind(a, a->resumes[pc]);
+    switch (inst->op) {
+        case VM_SPLIT:
+            jmp(a, a->entries[inst->y]);
+            break;
+        case VM_QUEST:
+            /* Then with the atom. */
+            emit_atom(a, inst, table, a->fail);
+            emit_valid(a, a->fail);
+            jmp(a, next);
+            break;
+        case VM_RANGE:
+            /* One more repetition. */
+            if (inst->y != MAX_USHORT) {
+                cmp_mem_imm(a, REG_FP, FRAME_COUNT, inst->y);
+                jcc(a, CC_AE, a->fail);
+            }
+            emit_atom(a, inst, table, a->fail);
+            emit_valid(a, a->fail);
+            inc_mem(a, REG_FP, FRAME_COUNT);
+            emit_push(a, a->resumes[pc]);
+            jmp(a, next);
+            break;
+        default:
+            /* VM_STAR and VM_PLUS: one less repetition. */
+            back = new_label(a);
+            stop = new_label(a);
+            keep = new_label(a);
+            load(a, RCX, REG_FP, FRAME_LOW);
+            bind(a, back);
+            add_imm(a, REG_TEXT, -1);
+            if (!a->prog->bytes) {
+                cmp(a, REG_TEXT, RCX);
+                jcc(a, CC_BE, stop);
+                load_byte(a, REG_TEXT);
+                and_eax(a, 0xC0);
+                cmp_eax(a, 0x80);
+                jcc(a, CC_E, back);
+            }
+            bind(a, stop);
+            cmp(a, REG_TEXT, RCX);
+            jcc(a, CC_NE, keep);
+            jmp(a, inst->op == VM_PLUS ? a->fail : next);
+            bind(a, keep);
+            /* The frame stays with the new position. */
+            store(a, REG_FP, FRAME_TEXT, REG_TEXT);
+            add_imm(a, REG_FP, FRAME_SIZE);
+            jmp(a, next);
+            break;
+    }
+}
+
+/* Fills the 256-bit table of an atom. Utf-8 programs only look up ASCII characters. */
+static void build_table(const asm_t* a, const vm_inst_t* inst, uint8_t* table) {
+    char buf[4];
+    int b;
+    memset(table, 0, 32);
+    memcpy(table, inst->ascii, sizeof(inst->ascii));
+    if (!a->prog->bytes)
+        return;
+    for (b = ASCII_MAX + 1; b <= 0xFF; b++) {
+        int match = inst->mb == RE_MB_ANY;
+        if (inst->mb == RE_MB_TEST)
+            match = re_matchone(&a->objs[inst->obj], buf, tsm_rune_encode((uint32_t)b, buf));
+        if (match)
+            table[b >> 3] |= (uint8_t)(1 << (b & 7));
+    }
+}
+
+static void emit_program(asm_t* a) {
+    const vm_prog_t* prog = a->prog;
+    uint8_t* tables = a->code;
+    int ret = new_label(a), ret0 = new_label(a);
+    int pc;
+
+    a->fail = new_label(a);
+    for (pc = 0; pc < prog->len; pc++) {
+        a->entries[pc] = new_label(a);
+        a->resumes[pc] = new_label(a);
+        build_table(a, &prog->insts[pc], tables + pc * 32);
+    }
+    a->len = JIT_DATA_SIZE;
+
+    /* int fn(jit_args_t* args) */
+    push(a, RBX);
+    push(a, RBP);
+    push(a, R12);
+    push(a, R13);
+    push(a, R14);
+    push(a, R15);
+    add_imm(a, RSP, -8);  /* align the stack for calls */
+    mov(a, REG_ARGS, RDI);
+    load(a, REG_BEGIN, REG_ARGS, ARG_BEGIN);
+    load(a, REG_END, REG_ARGS, ARG_END);
+    load(a, REG_TEXT, REG_ARGS, ARG_TEXT);
+    load(a, REG_FRAMES, REG_ARGS, ARG_FRAMES);
+    mov(a, REG_FP, REG_FRAMES);
+
+    for (pc = 0; pc < prog->len; pc++)
+        emit_main(a, pc, tables + pc * 32);
+    jmp(a, ret);  /* VM_MATCH */
+
+    for (pc = 0; pc < prog->len; pc++) {
+        uint8_t op = prog->insts[pc].op;
+        if (op == VM_SPLIT || op == VM_QUEST || op == VM_STAR || op == VM_PLUS || op == VM_RANGE)
+            emit_resume(a, pc, tables + pc * 32);
+    }
+
+    /* Pop a frame and jump to its resume address. */
+    bind(a, a->fail);
+    cmp(a, REG_FP, REG_FRAMES);
+    jcc(a, CC_E, ret0);
+    add_imm(a, REG_FP, -FRAME_SIZE);
+    load(a, REG_TEXT, REG_FP, FRAME_TEXT);
+    jmp_mem(a, REG_FP, FRAME_RESUME);
+
+    bind(a, ret0);
+    byte(a, 0x31);  /* xor eax, eax */
+    byte(a, 0xC0);
+    bind(a, ret);
+    add_imm(a, RSP, 8);
+    pop(a, R15);
+    pop(a, R14);
+    pop(a, R13);
+    pop(a, R12);
+    pop(a, RBP);
+    pop(a, RBX);
+    byte(a, 0xC3);  /* ret */
+}
+
+jit_code_t* jit_compile(const vm_prog_t* prog, const regex_t* objs) {
+    jit_code_t* jit;
+    asm_t* a;
+    void* mem;
+    int i;
+
+    if (prog->len == 0)
+        return NULL;
+    for (i = 0; i < prog->len; i++) {
+        if (prog->insts[i].possessive)
+            return NULL;  /* The interpreter runs possessive quantifiers. */
+    }
+    mem = mmap(NULL, JIT_CODE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED)
+        return NULL;
+    a = (asm_t*)calloc(1, sizeof(asm_t));
+    jit = (jit_code_t*)malloc(sizeof(jit_code_t));
+    if (a == NULL || jit == NULL)
+        goto error;
+
+    a->code = (uint8_t*)mem;
+    a->prog = prog;
+    a->objs = objs;
+    emit_program(a);
+    if (a->error)
+        goto error;
+    for (i = 0; i < a->fixup_count; i++) {
+        size_t pos = a->fixups[i];
+        int64_t disp = (int64_t)a->labels[a->fixup_labels[i]] - (int64_t)(pos + 4);
+        uint32_t v = (uint32_t)(int32_t)disp;
+        memcpy(a->code + pos, &v, 4);
+    }
+
+    /* Writable or executable, but not both. */
+    if (mprotect(mem, JIT_CODE_SIZE, PROT_READ | PROT_EXEC) != 0)
+        goto error;
+    __builtin___clear_cache((char*)mem, (char*)mem + a->len);
+    jit->mem = mem;
+    jit->size = JIT_CODE_SIZE;
+    /* ISO C doesn't convert object pointers to function pointers. */
+    {
+        uint8_t* entry = (uint8_t*)mem + JIT_DATA_SIZE;
+        memcpy(&jit->fn, &entry, sizeof(jit->fn));
+    }
+    free(a);
+    return jit;
+
+error:
+    munmap(mem, JIT_CODE_SIZE);
+    free(a);
+    free(jit);
+    return NULL;
+}
+
+void jit_free(jit_code_t* jit) {
+    if (jit == NULL)
+        return;
+    munmap(jit->mem, jit->size);
+    free(jit);
+}
+
+#else  // JIT_X64
+
+jit_code_t* jit_compile(const vm_prog_t* prog, const regex_t* objs) {
+    (void)prog;
+    (void)objs;
+    return NULL;
+}
+
+void jit_free(jit_code_t* jit) {
+    (void)jit;
+}
+
+#endif  // JIT_X64
@@ -0,0 +1,44 @@
+/*
+ * JIT compiler for the regex bytecode. (See vm.h)
+ *
+ * Programs are translated to x86-64 machine code on Linux.
+ * Each instruction becomes a block of code. ASCII tests are inlined as bitmap lookups,
+ * and multi-byte characters, utf-8 validation, and span scans call small C functions.
+ * Backtracking frames hold the address of the code that resumes them.
+ *
+ * The code is written to an anonymous mapping, which is made executable
+ * only after it's written (W^X). Other platforms, builds with TSM_NO_JIT or TSM_PROFILE,
+ * and systems that refuse executable mappings run the VM instead.
+ *
+ */
+
+#ifndef __TINY_STR_MATCH_INCLUDE_JIT_H__
+#define __TINY_STR_MATCH_INCLUDE_JIT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct vm_prog_t;
+struct regex_t;
+typedef struct jit_code_t jit_code_t;
+
+/* Compiles a utf-8 or byte-mode program. Returns NULL when the JIT isn't available.
+ * The code refers to the program and the objects, so they shouldn't move. */
+jit_code_t* jit_compile(const struct vm_prog_t* prog, const struct regex_t* objs);
+
+/* Same as the matching loop of the VM. (See vm_run.h) */
+int jit_run(const jit_code_t* jit, const char* begin, const char* end,
+            const char* text, int full, const char** match_end);
+
+/* Frees the code. jit can be NULL. */
+void jit_free(jit_code_t* jit);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __TINY_STR_MATCH_INCLUDE_JIT_H__
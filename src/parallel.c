@@ -0,0 +1,396 @@
+/*
+ * Parallel search over a single large buffer.
+ *
+ * The buffer is split into chunks at utf-8 character boundaries.
+ * Each worker finds matches that start in its chunk.
+ * Matches can end beyond the chunk because all workers share the whole buffer,
+ * so a match that crosses a boundary is found by the worker of the chunk where it starts.
+ *
+ * Search: the first chunk that stopped at a match or at invalid utf-8 decides the result.
+ *         Workers search their chunk in blocks and record the earliest chunk that stopped.
+ *         A worker gives up when an earlier chunk has stopped, because its result is unused.
+ * Count:  each worker counts matches as if the previous chunk ended without a match.
+ *         The merge step carries the real resume point from chunk to chunk.
+ *         When a match of the previous chunk runs into the next chunk,
+ *         the next chunk is rescanned from the resume point
+ *         until the rescan meets a match that the worker also found.
+ *         Invalid utf-8 fails the count only when the resume point reaches it.
+ *
+ * Patterns that have '^' in all branches only match at the start, so they use one worker.
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <limits.h>
+#include <stdlib.h>
+#include "str_match.h"
+#include "utf.h"
+#include "re.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#define MAX_THREADS 64
+#ifndef TSM_MIN_CHUNK_SIZE
+#define TSM_MIN_CHUNK_SIZE 65536  /* don't use threads for small buffers */
+#endif
+#define MIN_CHUNK_SIZE ((size_t)TSM_MIN_CHUNK_SIZE)
+#define MAX_STARTS 64  /* match positions recorded for the merge step */
+#define SEARCH_BLOCK ((size_t)1 << 20)  /* searches check for cancellation after each block */
+
+/* Search position after the whole buffer. It means no more searches. */
+#define POS_DONE(len) ((len) + 1)
+
+typedef struct Worker {
+    const TsmRegex* re;
+    const char* str;
+    size_t len;
+    size_t begin;  /* the chunk is [begin, end) */
+    size_t end;
+    int count_mode;
+    long index;  /* the chunk number */
+    long* stopped;  /* the earliest chunk that stopped at a match or at invalid utf-8 */
+
+    /* Results */
+    int status;  /* 1: found, 0: not found, -1: invalid utf-8 */
+    TsmMatch match;  /* the first match */
+    size_t count;
+    size_t starts[MAX_STARTS];  /* start positions of the first matches */
+    size_t next;  /* where to resume after the last match */
+} Worker;
+
+/* Atomic access to Worker::stopped. Other compilers don't cancel workers. */
+static long load_stopped(const long* stopped) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __atomic_load_n(stopped, __ATOMIC_RELAXED);
+#elif defined(_WIN32)
+    return InterlockedCompareExchange((volatile LONG*)stopped, 0, 0);
+#else
+    return *stopped;
+#endif
+}
+
+static void lower_stopped(long* stopped, long index) {
+#if defined(__GNUC__) || defined(__clang__)
+    long old = __atomic_load_n(stopped, __ATOMIC_RELAXED);
+    while (index < old &&
+           !__atomic_compare_exchange_n(stopped, &old, index, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+#elif defined(_WIN32)
+    long old = load_stopped(stopped);
+    while (index < old) {
+        long prev = InterlockedCompareExchange((volatile LONG*)stopped, index, old);
+        if (prev == old)
+            break;
+        old = prev;
+    }
+#else
+    (void)stopped;
+    (void)index;
+#endif
+}
+
+/* Checks if a match can start at pos. The last chunk also has the end of the buffer. */
+static int in_chunk(const Worker* w, size_t pos) {
+    return pos < w->end || (pos == w->len && w->end == w->len);
+}
+
+/* Finds the leftmost match that starts in [from, limit). */
+static int search_range(const Worker* w, size_t from, size_t limit, TsmMatch* match) {
+    const char* found;
+    size_t matchlength;
+    int res = re_search((re_t)w->re, w->str, w->str + w->len,
+                        w->str + from, w->str + limit, &found, &matchlength);
+    if (res == 1) {
+        match->start = (size_t)(found - w->str);
+        match->end = match->start + matchlength;
+    }
+    return res;
+}
+
+/* Where to resume after a match. Empty matches move to the next character. */
+static size_t resume_pos(const Worker* w, const TsmMatch* match) {
+    if (match->end > match->start)
+        return match->end;
+    if (match->start == w->len)
+        return POS_DONE(w->len);
+    return match->start + (size_t)re_runesize((re_t)w->re, w->str + match->start, w->str + w->len);
+}
+
+/* Finds the first match of the chunk block by block. Stops when an earlier chunk has stopped. */
+static int search_chunk(Worker* w) {
+    size_t from = w->begin;
+    for (;;) {
+        size_t limit = w->end - from > SEARCH_BLOCK ? from + SEARCH_BLOCK : w->end;
+        int res;
+        /* Move the boundary to the first byte of a character. */
+        while (limit < w->end && !w->re->bytes && is_multibyte_seq(w->str[limit]))
+            limit++;
+        if (load_stopped(w->stopped) < w->index)
+            return 0;  /* the result is unused */
+        res = search_range(w, from, limit, &w->match);
+        if (res != 0) {
+            lower_stopped(w->stopped, w->index);
+            return res;
+        }
+        if (limit == w->end)
+            return 0;
+        from = limit;
+    }
+}
+
+static void run_worker(Worker* w) {
+    size_t pos = w->begin;
+    TsmMatch match;
+
+    w->count = 0;
+    w->next = w->end;
+    if (!w->count_mode) {
+        w->status = search_chunk(w);
+        return;
+    }
+
+    w->status = 0;
+    while (in_chunk(w, pos)) {
+        int res = search_range(w, pos, w->end, &match);
+        if (res == -1)
+            w->status = -1;
+        if (res != 1)
+            return;
+        if (w->count < MAX_STARTS)
+            w->starts[w->count] = match.start;
+        w->count++;
+        pos = w->next = resume_pos(w, &match);
+    }
+}
+
+#ifdef _WIN32
+typedef HANDLE thread_t;
+
+static DWORD WINAPI worker_main(LPVOID arg) {
+    run_worker((Worker*)arg);
+    return 0;
+}
+
+static int thread_start(thread_t* th, Worker* w) {
+    *th = CreateThread(NULL, 0, worker_main, w, 0, NULL);
+    return *th != NULL;
+}
+
+static void thread_join(thread_t th) {
+    WaitForSingleObject(th, INFINITE);
+    CloseHandle(th);
+}
+
+static int cpu_count(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+}
+#else
+typedef pthread_t thread_t;
+
+static void* worker_main(void* arg) {
+    run_worker((Worker*)arg);
+    return NULL;
+}
+
+static int thread_start(thread_t* th, Worker* w) {
+    return pthread_create(th, NULL, worker_main, w) == 0;
+}
+
+static void thread_join(thread_t th) {
+    pthread_join(th, NULL);
+}
+
+static int cpu_count(void) {
+#ifdef _SC_NPROCESSORS_ONLN
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#else
+    return 1;
+#endif
+}
+#endif
+
+/* Checks if all branches start with '^'. */
+static int is_anchored(const TsmRegex* re) {
+    int i;
+    for (i = 0; i < re->branch_count; i++) {
+        if (re->objs[re->branches[i]].type != BEGIN)
+            return 0;
+    }
+    return 1;
+}
+
+/* Splits the buffer into chunks and runs workers. Returns the number of workers. */
+static int run_workers(const TsmRegex* re, const char* str, size_t len,
+                       int threads, int count_mode, Worker** workers) {
+    size_t chunk_size;
+    size_t begin = 0;
+    int count = 0;
+    int i;
+    thread_t* th;
+    int* started;
+    long stopped = LONG_MAX;
+
+    if (threads <= 0)
+        threads = cpu_count();
+    if (threads > MAX_THREADS)
+        threads = MAX_THREADS;
+    if ((size_t)threads > len / MIN_CHUNK_SIZE)
+        threads = (int)(len / MIN_CHUNK_SIZE);
+    if (threads < 1 || is_anchored(re))
+        threads = 1;
+    chunk_size = len / (size_t)threads;
+
+    *workers = (Worker*)malloc(sizeof(Worker) * (size_t)threads);
+    th = (thread_t*)malloc(sizeof(thread_t) * (size_t)threads);
+    started = (int*)calloc((size_t)threads, sizeof(int));
+    if (*workers == NULL || th == NULL || started == NULL) {
+        free(*workers);
+        free(th);
+        free(started);
+        *workers = NULL;
+        return 0;
+    }
+
+    for (i = 0; i < threads; i++) {
+        Worker* w = &(*workers)[count];
+        size_t end = (i == threads - 1) ? len : chunk_size * (size_t)(i + 1);
+        /* Move the boundary to the first byte of a character. */
+        while (end < len && !re->bytes && is_multibyte_seq(str[end]))
+            end++;
+        if (end <= begin && end < len)
+            continue;
+        w->re = re;
+        w->str = str;
+        w->len = len;
+        w->begin = begin;
+        w->end = end;
+        w->count_mode = count_mode;
+        w->index = count;
+        w->stopped = &stopped;
+        count++;
+        begin = end;
+        if (end == len)
+            break;
+    }
+
+    /* The first chunk runs on this thread. */
+    for (i = 1; i < count; i++)
+        started[i] = thread_start(&th[i], &(*workers)[i]);
+    run_worker(&(*workers)[0]);
+    for (i = 1; i < count; i++) {
+        if (started[i])
+            thread_join(th[i]);
+        else
+            run_worker(&(*workers)[i]);
+    }
+
+    free(th);
+    free(started);
+    return count;
+}
+
+TsmResult tsm_regex_search_parallel(const TsmRegex *compiled, const char *str,
+                                    size_t len, int threads, TsmMatch *match) {
+    Worker* workers;
+    TsmResult result = TSM_FAIL;
+    int count, i;
+
+    if (compiled == NULL || str == NULL || match == NULL)
+        return TSM_FAIL;
+
+    count = run_workers(compiled, str, len, threads, 0, &workers);
+    if (count == 0)
+        return TSM_OUT_OF_MEMORY;
+
+    for (i = 0; i < count; i++) {
+        if (workers[i].status == 0)
+            continue;
+        if (workers[i].status == 1) {
+            *match = workers[i].match;
+            result = TSM_OK;
+        }
+        break;
+    }
+    free(workers);
+    return result;
+}
+
+/* Finds the index of a match position in the worker's list. Returns -1 when not found. */
+static long find_start(const Worker* w, size_t start) {
+    size_t n = w->count < MAX_STARTS ? w->count : MAX_STARTS;
+    size_t i;
+    for (i = 0; i < n && w->starts[i] <= start; i++) {
+        if (w->starts[i] == start)
+            return (long)i;
+    }
+    return -1;
+}
+
+TsmResult tsm_regex_count_parallel(const TsmRegex *compiled, const char *str,
+                                   size_t len, int threads, size_t *count) {
+    Worker* workers;
+    size_t total = 0;
+    size_t pos = 0;  /* where the sequential search resumes */
+    int status = 0;  /* -1 when the sequential search gets invalid utf-8 */
+    int worker_count, i;
+
+    if (compiled == NULL || str == NULL || count == NULL)
+        return TSM_FAIL;
+
+    worker_count = run_workers(compiled, str, len, threads, 1, &workers);
+    if (worker_count == 0)
+        return TSM_OUT_OF_MEMORY;
+
+    for (i = 0; i < worker_count && pos <= len && status != -1; i++) {
+        const Worker* w = &workers[i];
+        if (!in_chunk(w, pos))
+            continue;  /* a match of the previous chunk covers this chunk */
+        if (pos == w->begin) {
+            total += w->count;
+            pos = w->next;
+            status = w->status;
+            continue;
+        }
+
+        /* Rescan until we meet the matches of the worker. */
+        for (;;) {
+            TsmMatch match;
+            long idx;
+            status = search_range(w, pos, w->end, &match);
+            if (status == -1)
+                break;
+            if (status == 0) {
+                pos = w->end;
+                break;
+            }
+            idx = find_start(w, match.start);
+            if (idx >= 0) {
+                total += w->count - (size_t)idx;
+                pos = w->next;
+                status = w->status;
+                break;
+            }
+            total++;
+            pos = resume_pos(w, &match);
+            if (!in_chunk(w, pos))
+                break;
+        }
+    }
+
+    free(workers);
+    if (status == -1)
+        return TSM_FAIL;  /* the resume point reached invalid utf-8 */
+    *count = total;
+    return TSM_OK;
+}
@@ -0,0 +1,287 @@
+/*
+ * Engine selection for compiled regex patterns.
+ *
+ *   "abc"      Literal.  Substring search with strstr.
+ *   "^abc"     Prefix.   strncmp at the beginning.
+ *   "abc$"     Suffix.   memcmp at the end.
+ *   "^abc$"    Exact.    strcmp.
+ *   "a[bc]+d"  Short patterns without '|' use the bit-parallel engines. (See bitpar.h)
+ *   "ab|c+"    Bytecode VM for other compiled patterns. (See vm.h)
+ *              TSM_FLAG_JIT compiles the bytecode to machine code. (See jit.h)
+ *   Others     Backtracking. (See re.c)
+ *
+ * The backtracker fails when it reaches invalid utf-8 characters.
+ * The literal engines check the text around the match,
+ * and let the backtracker decide the result when they find invalid characters.
+ * Byte mode (TSM_FLAG_BYTES) has no invalid characters, so the checks are skipped.
+ *
+ */
+
+#include <string.h>
+#include "str_match.h"
+#include "utf.h"
+#include "re.h"
+#include "jit.h"
+
+/* Builds span scanners for atoms before '*', '+', and {n,m}.
+ * Utf-8 patterns only scan ASCII bytes. Multi-byte characters are matched one by one. */
+static void build_spans(re_t compiled) {
+    const regex_t* objs = compiled->objs;
+    const int max = compiled->bytes ? 0xFF : ASCII_MAX;
+    uint32_t bits[8];
+    int i, b;
+    char c;
+
+    memset(compiled->spans, 0, sizeof(compiled->spans));
+    for (i = 0; objs[i].type != UNUSED; i++) {
+        uint8_t next = objs[i + 1].type;
+        if (!re_isatom(objs[i].type) || (next != STAR && next != PLUS && next != TIMES))
+            continue;
+        memset(bits, 0, sizeof(bits));
+        for (b = 0; b <= max; b++) {
+            c = (char)b;
+            if (re_matchone(&objs[i], &c, 1))
+                bits[b >> 5] |= (uint32_t)1 << (b & 31);
+        }
+        span_init(&compiled->spans[i], bits);
+    }
+    compiled->use_spans = 1;
+}
+
+void re_plan(re_t compiled, int use_tables) {
+    const regex_t* objs = compiled->objs;
+    int begin = 0, end = 0;
+    int i = 0;
+    size_t len = 0;
+
+    compiled->strategy = TSM_STRATEGY_BACKTRACK;
+    compiled->literal_len = 0;
+    compiled->use_spans = 0;
+
+    /* Building tables takes time. Use them only for compiled patterns.
+     * The VM also runs utf-16 and utf-32 strings, so it's compiled for every pattern. */
+    if (!use_tables || !vm_compile(&compiled->vm, objs))
+        compiled->vm.len = 0;
+    compiled->vm.jit = NULL;
+#ifdef TSM_PROFILE
+    compiled->vm.stats = &compiled->stats;
+#endif
+
+    /* Literals: optional '^', characters without quantifiers, and optional '$'. */
+    if (objs[0].type == BEGIN) {
+        begin = 1;
+        i++;
+    }
+    while (objs[i].type == CHAR) {
+        if (compiled->bytes) {
+            /* Back to the Latin-1 byte */
+            compiled->literal[len++] = (char)tsm_rune_decode((const char*)objs[i].u.ch,
+                                                             objs[i].ch_size);
+        } else {
+            memcpy(compiled->literal + len, objs[i].u.ch, (size_t)objs[i].ch_size);
+            len += (size_t)objs[i].ch_size;
+        }
+        i++;
+    }
+    if (objs[i].type == END && objs[i + 1].type == UNUSED) {
+        end = 1;
+        i++;
+    }
+    if (objs[i].type == UNUSED) {
+        compiled->literal[len] = '\0';
+        compiled->literal_len = len;
+        if (begin && end)
+            compiled->strategy = TSM_STRATEGY_EXACT;
+        else if (begin)
+            compiled->strategy = TSM_STRATEGY_PREFIX;
+        else if (end)
+            compiled->strategy = TSM_STRATEGY_SUFFIX;
+        else
+            compiled->strategy = TSM_STRATEGY_LITERAL;
+        return;
+    }
+
+    if (!use_tables)
+        return;
+    build_spans(compiled);
+    compiled->vm.spans = compiled->vm.len ? compiled->spans : NULL;
+    if (bp_compile_regex(&compiled->bp, objs))
+        compiled->strategy = compiled->bp.use_bndm ? TSM_STRATEGY_BNDM : TSM_STRATEGY_SHIFT_AND;
+    else if (!compiled->memoize && compiled->vm.len)
+        compiled->strategy = TSM_STRATEGY_VM;  /* The memo is only for the backtracker. */
+
+    /* The bit-parallel engines still check matches. Searches run the machine code. */
+    if (compiled->use_jit && !compiled->memoize && compiled->vm.len) {
+        compiled->vm.jit = jit_compile(&compiled->vm, objs);
+        if (compiled->vm.jit && compiled->strategy == TSM_STRATEGY_VM)
+            compiled->strategy = TSM_STRATEGY_JIT;
+    }
+}
+
+/* Byte mode has no invalid characters. */
+static int valid(re_t compiled, const char* text, size_t size) {
+    return compiled->bytes || tsm_utf8_valid(text, size);
+}
+
+static int valid_rune(re_t compiled, const char* text) {
+    return compiled->bytes || tsm_rune_size(text);
+}
+
+static int backtrack(re_t compiled, const char* text) {
+    return re_test(compiled, text, text + strlen(text));
+}
+
+/* The literal and bit-parallel engines failed without the backtracker. */
+#define reject(compiled) (PROF_REJECT(&(compiled)->stats), 0)
+
+static int exec(re_t compiled, const char* text) {
+    const char* lit = compiled->literal;
+    const size_t len = compiled->literal_len;
+
+    switch (compiled->strategy) {
+        case TSM_STRATEGY_LITERAL:
+        {
+            const char* found = strstr(text, lit);
+            if (found == NULL)
+                return valid(compiled, text, strlen(text)) ? reject(compiled)
+                                                           : backtrack(compiled, text);
+            if (valid(compiled, text, (size_t)(found - text)) && valid_rune(compiled, found + len))
+                return 1;
+            return backtrack(compiled, text);
+        }
+        case TSM_STRATEGY_PREFIX:
+            if (strncmp(text, lit, len) != 0)
+                return reject(compiled);
+            return valid_rune(compiled, text + len) ? 1 : backtrack(compiled, text);
+        case TSM_STRATEGY_SUFFIX:
+        {
+            size_t size = strlen(text);
+            if (size < len || memcmp(text + size - len, lit, len) != 0)
+                return valid(compiled, text, size) ? reject(compiled) : backtrack(compiled, text);
+            return valid(compiled, text, size - len) ? 1 : backtrack(compiled, text);
+        }
+        case TSM_STRATEGY_EXACT:
+            return strcmp(text, lit) == 0 || reject(compiled);
+        case TSM_STRATEGY_SHIFT_AND:
+        case TSM_STRATEGY_BNDM:
+            return bp_match_regex(&compiled->bp, compiled->objs, text) || reject(compiled);
+        case TSM_STRATEGY_VM:
+        case TSM_STRATEGY_JIT:
+            return vm_exec(&compiled->vm, compiled->objs, text);
+        default:
+            return backtrack(compiled, text);
+    }
+}
+
+static int exec_full(re_t compiled, const char* text) {
+    switch (compiled->strategy) {
+        case TSM_STRATEGY_LITERAL:
+        case TSM_STRATEGY_PREFIX:
+        case TSM_STRATEGY_SUFFIX:
+        case TSM_STRATEGY_EXACT:
+            return strcmp(text, compiled->literal) == 0 || reject(compiled);
+        case TSM_STRATEGY_SHIFT_AND:
+        case TSM_STRATEGY_BNDM:
+            return bp_fullmatch_regex(&compiled->bp, compiled->objs, text) || reject(compiled);
+        case TSM_STRATEGY_VM:
+        case TSM_STRATEGY_JIT:
+            return vm_fullmatch(&compiled->vm, compiled->objs, text);
+        default:
+            return re_fullmatchp(compiled, text);
+    }
+}
+
+int re_exec(re_t compiled, const char* text) {
+    PROF_CALL_BEGIN(&compiled->stats);
+    int res = exec(compiled, text);
+    PROF_CALL_END(&compiled->stats);
+    return res;
+}
+
+int re_exec_full(re_t compiled, const char* text) {
+    PROF_CALL_BEGIN(&compiled->stats);
+    int res = exec_full(compiled, text);
+    PROF_CALL_END(&compiled->stats);
+    return res;
+}
+
+/* Checks characters that start in [from, limit). They can end in [limit, end). */
+static int valid_starts(re_t compiled, const char* from, const char* limit, const char* end) {
+    if (valid(compiled, from, (size_t)(limit - from)))
+        return 1;
+    while (from < limit) {
+        int size = tsm_rune_size_n(from, (size_t)(end - from));
+        if (!size)
+            return 0;
+        from += size;
+    }
+    return 1;
+}
+
+int re_search_literal(re_t compiled, const char* end, const char* from, const char* limit,
+                      const char** match, size_t* matchlength) {
+    const char* lit = compiled->literal;
+    const size_t len = compiled->literal_len;
+    const char* text = from;
+    const char* found = NULL;
+
+    if (compiled->strategy != TSM_STRATEGY_LITERAL || len == 0)
+        return -1;
+
+    /* Find the first occurrence that starts before the limit. */
+    while (text < limit && (size_t)(end - text) >= len) {
+        const char* p = (const char*)memchr(text, lit[0], (size_t)(end - text) - len + 1);
+        if (p == NULL || p >= limit)
+            break;
+        if (memcmp(p, lit, len) == 0) {
+            found = p;
+            break;
+        }
+        text = p + 1;
+    }
+
+    if (found == NULL)
+        return valid_starts(compiled, from, limit, end) ? 0 : -1;
+    if (!valid_starts(compiled, from, found, end))
+        return -1;
+    if (found + len < end && !re_runesize(compiled, found + len, end))
+        return -1;
+    *match = found;
+    *matchlength = len;
+    return 1;
+}
+
+int re_count_fast(re_t compiled, const char* begin, const char* end, size_t* count) {
+    const char* lit = compiled->literal;
+    const size_t len = compiled->literal_len;
+    const char* text = begin;
+    size_t n = 0;
+
+    if (compiled->strategy != TSM_STRATEGY_LITERAL && compiled->strategy != TSM_STRATEGY_BNDM)
+        return -1;
+    if (compiled->strategy == TSM_STRATEGY_LITERAL && len == 0)
+        return -1;  /* empty matches */
+
+    /* Matches of unanchored patterns are valid utf-8, and the search visits
+     * all the other characters. So any invalid character makes the search fail. */
+    if (!valid(compiled, begin, (size_t)(end - begin)))
+        return 0;
+
+    if (compiled->strategy == TSM_STRATEGY_BNDM) {
+        *count = bp_count_bndm(&compiled->bp, begin, (size_t)(end - begin));
+        return 1;
+    }
+    while ((size_t)(end - text) >= len) {
+        const char* p = (const char*)memchr(text, lit[0], (size_t)(end - text) - len + 1);
+        if (p == NULL)
+            break;
+        if (memcmp(p, lit, len) == 0) {
+            n++;
+            text = p + len;
+        } else {
+            text = p + 1;
+        }
+    }
+    *count = n;
+    return 1;
+}
@@ -0,0 +1,145 @@
+/*
+ * Profiling counters and trace hooks. (See profile.h)
+ *
+ * Counters are updated with relaxed atomic operations on GCC, Clang, and MSVC.
+ * Other compilers use plain additions, so threads can lose some counts there.
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <string.h>
+#include "str_match.h"
+#include "re.h"
+
+#ifdef TSM_PROFILE
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+void prof_add(uint64_t* counter, uint64_t n) {
+#if defined(__GNUC__) || defined(__clang__)
+    __atomic_fetch_add(counter, n, __ATOMIC_RELAXED);
+#elif defined(_WIN32)
+    InterlockedExchangeAdd64((volatile LONG64*)counter, (LONG64)n);
+#else
+    *counter += n;
+#endif
+}
+
+static uint64_t load(const uint64_t* counter) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+#elif defined(_WIN32)
+    return (uint64_t)InterlockedCompareExchange64((volatile LONG64*)counter, 0, 0);
+#else
+    return *counter;
+#endif
+}
+
+static void store(uint64_t* counter, uint64_t n) {
+#if defined(__GNUC__) || defined(__clang__)
+    __atomic_store_n(counter, n, __ATOMIC_RELAXED);
+#elif defined(_WIN32)
+    InterlockedExchange64((volatile LONG64*)counter, (LONG64)n);
+#else
+    *counter = n;
+#endif
+}
+
+uint64_t prof_now(void) {
+#ifdef _WIN32
+    LARGE_INTEGER count, freq;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&freq);
+    return (uint64_t)((double)count.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+re_prof_t prof_begin(const re_stats_t* stats, const void* base) {
+    re_prof_t prof;
+    prof.starts = 0;
+    prof.steps = 0;
+    prof.backtracks = 0;
+    prof.trace = stats->trace;
+    prof.user = stats->user;
+    prof.base = base;
+    return prof;
+}
+
+void prof_commit(re_stats_t* stats, const re_prof_t* prof) {
+    if (prof->starts)
+        prof_add(&stats->starts, prof->starts);
+    if (prof->steps)
+        prof_add(&stats->steps, prof->steps);
+    if (prof->backtracks)
+        prof_add(&stats->backtracks, prof->backtracks);
+}
+
+void prof_call(re_stats_t* stats, uint64_t start) {
+    prof_add(&stats->calls, 1);
+    prof_add(&stats->nanos, prof_now() - start);
+}
+
+TsmResult tsm_regex_stats(const TsmRegex *compiled, TsmStats *stats) {
+    if (compiled == NULL || stats == NULL)
+        return TSM_FAIL;
+    stats->calls = load(&compiled->stats.calls);
+    stats->starts = load(&compiled->stats.starts);
+    stats->steps = load(&compiled->stats.steps);
+    stats->backtracks = load(&compiled->stats.backtracks);
+    stats->rejects = load(&compiled->stats.rejects);
+    stats->nanos = load(&compiled->stats.nanos);
+    return TSM_OK;
+}
+
+TsmResult tsm_regex_stats_reset(TsmRegex *compiled) {
+    if (compiled == NULL)
+        return TSM_FAIL;
+    store(&compiled->stats.calls, 0);
+    store(&compiled->stats.starts, 0);
+    store(&compiled->stats.steps, 0);
+    store(&compiled->stats.backtracks, 0);
+    store(&compiled->stats.rejects, 0);
+    store(&compiled->stats.nanos, 0);
+    return TSM_OK;
+}
+
+TsmResult tsm_regex_set_trace(TsmRegex *compiled, TsmTraceFn trace, void *user) {
+    if (compiled == NULL)
+        return TSM_FAIL;
+    compiled->stats.trace = trace;
+    compiled->stats.user = user;
+    return TSM_OK;
+}
+
+#else  // TSM_PROFILE
+
+TsmResult tsm_regex_stats(const TsmRegex *compiled, TsmStats *stats) {
+    (void)compiled;
+    if (stats != NULL)
+        memset(stats, 0, sizeof(TsmStats));
+    return TSM_FAIL;
+}
+
+TsmResult tsm_regex_stats_reset(TsmRegex *compiled) {
+    (void)compiled;
+    return TSM_FAIL;
+}
+
+TsmResult tsm_regex_set_trace(TsmRegex *compiled, TsmTraceFn trace, void *user) {
+    (void)compiled;
+    (void)trace;
+    (void)user;
+    return TSM_FAIL;
+}
+
+#endif  // TSM_PROFILE
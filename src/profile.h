@@ -0,0 +1,100 @@
+/*
+ * Profiling counters and trace hooks for compiled regex patterns.
+ *
+ * Build with TSM_PROFILE (meson option "profile") to enable them.
+ * Without it, the macros expand to nothing and the matchers are the same as before.
+ *
+ * Each match attempt counts events in a local re_prof_t,
+ * and adds them to the counters of the pattern once at the end.
+ * So threads that share a pattern only do a few atomic additions per call.
+ *
+ */
+
+#ifndef __TINY_STR_MATCH_INCLUDE_PROFILE_H__
+#define __TINY_STR_MATCH_INCLUDE_PROFILE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "str_match.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef TSM_PROFILE
+
+/* Counters of a compiled pattern. See TsmStats. */
+typedef struct re_stats_t {
+    uint64_t calls;
+    uint64_t starts;
+    uint64_t steps;
+    uint64_t backtracks;
+    uint64_t rejects;
+    uint64_t nanos;
+    TsmTraceFn trace;
+    void* user;
+} re_stats_t;
+
+/* Counters of a match attempt. */
+typedef struct re_prof_t {
+    uint64_t starts;
+    uint64_t steps;
+    uint64_t backtracks;
+    TsmTraceFn trace;
+    void* user;
+    const void* base;  /* the backtracker reports offsets from here */
+} re_prof_t;
+
+/* Starts counting a match attempt. */
+re_prof_t prof_begin(const re_stats_t* stats, const void* base);
+
+/* Adds the counters of a match attempt to the pattern. */
+void prof_commit(re_stats_t* stats, const re_prof_t* prof);
+
+/* Adds a call and the time since start to the pattern. */
+void prof_call(re_stats_t* stats, uint64_t start);
+
+/* Adds n to a counter atomically. */
+void prof_add(uint64_t* counter, uint64_t n);
+
+/* Monotonic time in nanoseconds. */
+uint64_t prof_now(void);
+
+#define PROF_EVENT(prof, counter, event, obj, offset) do { \
+        (prof)->counter++; \
+        if ((prof)->trace) \
+            (prof)->trace((prof)->user, event, obj, offset); \
+    } while (0)
+
+#define PROF_LOCAL(prof, stats, base) re_prof_t prof = prof_begin(stats, base)
+#define PROF_COMMIT(prof, stats) prof_commit(stats, &(prof))
+#define PROF_PARAM , re_prof_t* prof
+#define PROF_ARG(prof) , prof
+#define PROF_START(prof, offset) PROF_EVENT(prof, starts, TSM_TRACE_START, -1, offset)
+#define PROF_STEP(prof, obj, offset) PROF_EVENT(prof, steps, TSM_TRACE_STEP, obj, offset)
+#define PROF_BACKTRACK(prof, obj, offset) \
+    PROF_EVENT(prof, backtracks, TSM_TRACE_BACKTRACK, obj, offset)
+#define PROF_REJECT(stats) prof_add(&(stats)->rejects, 1)
+#define PROF_CALL_BEGIN(stats) uint64_t prof_start_ = prof_now()
+#define PROF_CALL_END(stats) prof_call(stats, prof_start_)
+
+#else  // TSM_PROFILE
+
+#define PROF_LOCAL(prof, stats, base)
+#define PROF_COMMIT(prof, stats) ((void)0)
+#define PROF_PARAM
+#define PROF_ARG(prof)
+#define PROF_START(prof, offset) ((void)0)
+#define PROF_STEP(prof, obj, offset) ((void)0)
+#define PROF_BACKTRACK(prof, obj, offset) ((void)0)
+#define PROF_REJECT(stats) ((void)0)
+#define PROF_CALL_BEGIN(stats)
+#define PROF_CALL_END(stats) ((void)0)
+
+#endif  // TSM_PROFILE
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __TINY_STR_MATCH_INCLUDE_PROFILE_H__
@@ -23,63 +23,97 @@
  *   '{n}'      Match n times
  *   '{n,}'     Match n or more times
  *   '{n,m}'    Match n to m times
+ *   '*+' '++'  Possessive quantifiers, match as many as possible and never give them back.
+ *   '?+' '{n,m}+'
  *   '|'        Branch Or, e.g. a|A, \w|\s
  *
  */
 
+#include <assert.h>
 #include <stdio.h>
-#include <ctype.h>
 #include <string.h>
 #include "str_match.h"
 #include "utf.h"
 #include "re.h"
+#include "jit.h"
+#include "complexity.h"
 
 
-/* Definitions: */
-#define MAX_REGEXP_OBJECTS      30    /* Max number of regex symbols in expression. */
-#define MAX_CHAR_CLASS_LEN      40    /* Max length of character-class buffer in.   */
-#define MAX_USHORT 0xffff
+/* State of a match attempt. */
+typedef struct re_ctx_t {
+    const char* begin;    /* the first position that can be visited */
+    const char* end;      /* end of the text */
+    const regex_t* objs;  /* the first object of the pattern */
+    uint8_t* memo;        /* bitset of failed (object, position) pairs, or NULL */
+    size_t width;         /* number of positions in a row of the memo */
+    int full;             /* matches should end at the end of the text */
+    int bytes;            /* each byte is a character (RE_BYTES) */
+    int early;            /* boolean tests: stop at the first accepting state */
+    uint32_t nullable;    /* bit i: the rest of the branch from object i can be empty */
+    const span_t* spans;  /* span scanners of the objects, or NULL */
+#ifdef TSM_PROFILE
+    re_prof_t* prof;      /* counters of the attempt */
+#endif
+} re_ctx_t;
 
+/* Choice points of the backtracker. Popping a frame resumes its next alternative. */
 enum {
-    UNUSED, DOT, BEGIN, END, QUESTIONMARK, STAR, PLUS,
-    CHAR, CHAR_CLASS, INV_CHAR_CLASS, DIGIT, NOT_DIGIT,
-    ALPHA, NOT_ALPHA, WHITESPACE, NOT_WHITESPACE, BRANCH,
-    TIMES,
+    FRAME_MEMO,      /* the attempt failed. Remember it. */
+    FRAME_QUESTION,  /* atom?: try with the atom */
+    FRAME_STAR,      /* atom*: one less repetition, then none */
+    FRAME_PLUS,      /* atom+: one less repetition */
+    FRAME_TIMES,     /* atom{n,m}: one more repetition */
 };
 
-typedef struct regex_t {
-    uint8_t  type;   /* CHAR, STAR, etc.                      */
-    union {
-        uint8_t  ch[4];   /*      the character itself             */
-        uint8_t* ccl;  /*  OR  a pointer to characters in class */
-        struct {
-            uint16_t n;
-            uint16_t m;
-        } times;
-    } u;
-    int ch_size;
-} regex_t;
+typedef struct re_frame_t {
+    const regex_t* pattern;  /* the atom */
+    const char* text;        /* where the rest of the pattern was tried */
+    int size;                /* size of the character at text */
+    const char* low;         /* FRAME_STAR and FRAME_PLUS: where the repetitions started */
+    const char* high;        /* the end of the longest run after trying it in early mode */
+    size_t key;              /* FRAME_MEMO: bit of the memo for the attempt */
+    uint16_t count;          /* FRAME_TIMES: number of repetitions */
+    uint8_t kind;
+} re_frame_t;
 
+/* Profiling events at an object and a position. (See profile.h) */
+#define STEP(ctx, obj, text) \
+    PROF_STEP((ctx)->prof, (int)((obj) - (ctx)->objs), prof_offset(ctx, text))
+#define BACKTRACK(ctx, obj, text) \
+    PROF_BACKTRACK((ctx)->prof, (int)((obj) - (ctx)->objs), prof_offset(ctx, text))
+#define prof_offset(ctx, text) ((size_t)((text) - (const char*)(ctx)->prof->base))
 
 /* Private function declarations: */
-static int matchpattern(regex_t* pattern, const char* text, int rune_size, int* matchlength);
-static int matchcharclass(const char* c, int c_size, const char* str);
-static int matchstar(regex_t p, regex_t* pattern,
-                     const char* text, int rune_size, int* matchlength);
-static int matchplus(regex_t p, regex_t* pattern,
-                     const char* text, int rune_size, int* matchlength);
+static int matchpattern(const regex_t* pattern, const char* text, const re_ctx_t* ctx,
+                        int rune_size, size_t* matchlength);
+static int matchcharclass(const char* c, int c_size, const char* str, int flags);
 static int matchone(regex_t p, const char* c, int rune_size);
-static int matchtimes(regex_t p, regex_t* pattern, uint16_t n, uint16_t m,
-                      const char* text, int rune_size, int* matchlength);
-static int matchend(regex_t p, const char* text);
-static int matchdigit(char c);
-static int matchalpha(char c);
-static int matchwhitespace(char c);
-static int matchmetachar(const char* c, int c_size, const char* str, int rune_size);
+static int matchclass(regex_t p, const char* c, int c_size);
+static int matchicase(regex_t p, const char* c, int c_size);
+static int matchend(regex_t p, const char* text, const re_ctx_t* ctx);
+static int matchctype(const char* c, int c_size, int flags, int type);
+static int matchmetachar(const char* c, int c_size, const char* str, int rune_size, int flags);
 static int matchrange(const char* c, int c_size, const char* str, int rune_size);
 static int matchdot(char c);
 
+static void ctx_init(re_ctx_t* ctx, re_t compiled, const char* begin, const char* end);
+static int backtrack(re_t compiled, const char* begin, const char* end, const char* from,
+                     const char* limit, int early, const char** match, size_t* matchlength);
+static uint32_t nullable(const regex_t* objs);
+static int canstart(const regex_t* pattern, const char* text, const re_ctx_t* ctx, int rune_size);
 static int parsetimes(const char* pattern, uint16_t* n, uint16_t* m);
+static void foldchar(regex_t* re);
+static void buildclass(re_ccl_t* ccl, int flags);
+static int patternsize(const char* c, int flags);
+static int copysize(const char* c, int flags);
+static int copychar(uint8_t* out, const char* c, int c_size, int flags);
+
+/* Counts the binary size of a character. The end of the text acts as '\0'. */
+static int runesize(const re_ctx_t* ctx, const char* text) {
+    if (text >= ctx->end || ctx->bytes || (uint8_t)*text <= ASCII_MAX)
+        return 1;
+    return tsm_rune_size_n(text, (size_t)(ctx->end - text));
+}
 
 
 /* Public functions: */
@@ -89,54 +123,108 @@ int re_match(const char* pattern, const char* text, int* matchlength) {
 }
 #endif
 
-int re_matchp(re_t pattern, const char* text, int* matchlength) {
-    if (!pattern) return -1;
+int re_matchp(re_t compiled, const char* text, int* matchlength) {
+    if (!compiled) return -1;
 
-    const char* prepoint = text;
+    const char* match;
+    size_t length;
+    if (backtrack(compiled, text, text + strlen(text), text, NULL, 0, &match, &length) != 1)
+        return -1;
+    *matchlength = (int)length;
+    return (int)(match - text);
+}
 
-    do {
-        text = prepoint;
-        do {
-            *matchlength = 0;
-            int rune_size = tsm_rune_size(text);
-            if (!rune_size) return -1;
-            int has_start_anchor = pattern[0].type == BEGIN;
-            if (matchpattern(pattern + has_start_anchor, text, rune_size, matchlength)) {
-                return (int)(text - prepoint);
-            }
-            if (has_start_anchor || !*text) break;
-            text += rune_size;
-        } while (1);
+int re_test(re_t compiled, const char* begin, const char* end) {
+    const char* match;
+    size_t length;
+    return backtrack(compiled, begin, end, begin, NULL, 1, &match, &length) == 1;
+}
 
-        // move to the next branch
-        while (pattern->type != UNUSED && pattern->type != BRANCH) {
-            pattern++;
-        }
-        if (pattern->type == UNUSED)
-            break;
-        pattern++;
-    } while (1);
-    return -1;
+static int search(re_t compiled, const char* begin, const char* end,
+                  const char* from, const char* limit, const char** match, size_t* matchlength) {
+    int res = re_search_literal(compiled, end, from, limit, match, matchlength);
+    if (res == 0)
+        PROF_REJECT(&compiled->stats);
+    if (res != -1)
+        return res;
+    /* The VM also runs patterns for the bit-parallel engines,
+     * which can't find where matches start. */
+    if (compiled->vm.len && !compiled->memoize)
+        return vm_search(&compiled->vm, compiled->objs, begin, end, from, limit,
+                         match, matchlength);
+    return backtrack(compiled, begin, end, from, limit, 0, match, matchlength);
+}
+
+int re_search(re_t compiled, const char* begin, const char* end,
+              const char* from, const char* limit, const char** match, size_t* matchlength) {
+    PROF_CALL_BEGIN(&compiled->stats);
+    int res = search(compiled, begin, end, from, limit, match, matchlength);
+    PROF_CALL_END(&compiled->stats);
+    return res;
+}
+
+int re_fullmatchp(re_t compiled, const char* text) {
+    size_t length;
+    int res = 0;
+    int i;
+    re_ctx_t ctx;
+    PROF_LOCAL(prof, &compiled->stats, text);
+    ctx_init(&ctx, compiled, text, text + strlen(text));
+    ctx.full = 1;
+#ifdef TSM_PROFILE
+    ctx.prof = &prof;
+    PROF_START(&prof, 0);
+#endif
+
+    /* One attempt at the beginning for each branch */
+    int rune_size = runesize(&ctx, text);
+    for (i = 0; i < compiled->branch_count && rune_size && !res; i++) {
+        regex_t* pattern = &compiled->objs[compiled->branches[i]];
+        length = 0;
+        res = matchpattern(pattern + (pattern[0].type == BEGIN), text, &ctx, rune_size, &length);
+    }
+    free(ctx.memo);
+    PROF_COMMIT(prof, &compiled->stats);
+    return res;
 }
 
 re_t re_compile(const char* pattern) {
-    /* The sizes of the two static arrays below substantiates the static RAM usage of this module.
+    /* The size of the static object below substantiates the static RAM usage of this module.
         MAX_REGEXP_OBJECTS is the max number of symbols in the expression.
         MAX_CHAR_CLASS_LEN determines the size of buffer for chars in all char-classes in the expression. */
-    static regex_t re_compiled[MAX_REGEXP_OBJECTS];
-    static uint8_t ccl_buf[MAX_CHAR_CLASS_LEN];
+    static struct TsmRegex compiled;
+    if (!re_compile_to(&compiled, pattern, 0))
+        return 0;
+    return &compiled;
+}
+
+int re_compile_to(re_t compiled, const char* pattern, int flags) {
+    regex_t* re_compiled = compiled->objs;
+    uint8_t* ccl_buf = compiled->ccl_buf;
     int ccl_bufidx = 1;
+    int ccl_count = 0;
+    compiled->strategy = TSM_STRATEGY_BACKTRACK;
+    compiled->literal_len = 0;
+    compiled->memoize = 0;
+    compiled->use_spans = 0;
+    compiled->use_jit = 0;
+    compiled->bytes = (flags & RE_BYTES) != 0;
+#ifdef TSM_PROFILE
+    memset(&compiled->stats, 0, sizeof(compiled->stats));
+#endif
 
     char c;     /* current char in pattern   */
     int c_size;
     int i = 0;  /* index into pattern        */
     int j = 0;  /* index into re_compiled    */
 
+    ccl_buf[0] = 0;
     while (pattern[i] != '\0') {
         if (j + 1 >= MAX_REGEXP_OBJECTS)
             return 0;
+        re_compiled[j].flags = (uint8_t)flags;
         c = pattern[i];
-        c_size = tsm_rune_size(&pattern[i]);
+        c_size = patternsize(&pattern[i], flags);
         if (!c_size) return 0;  // failed to parse UTF-8 character.
         switch (c) {
         /* Meta-characters: */
@@ -167,11 +255,13 @@ re_t re_compile(const char* pattern) {
                     /* Escaped character, e.g. '.' or '$' */
                     default:
                     {
-                        c_size = tsm_rune_size(&pattern[i]);
+                        c_size = patternsize(&pattern[i], flags);
                         if (!c_size) return 0;
                         re_compiled[j].type = CHAR;
-                        memcpy(re_compiled[j].u.ch, &pattern[i], c_size);
-                        re_compiled[j].ch_size = c_size;
+                        re_compiled[j].ch_size = copychar(re_compiled[j].u.ch, &pattern[i],
+                                                          c_size, flags);
+                        if (flags & RE_ICASE)
+                            foldchar(&re_compiled[j]);
                     } break;
                 }
             } else {
@@ -208,11 +298,12 @@ re_t re_compile(const char* pattern) {
                         return 0;
                     }
                     ccl_buf[ccl_bufidx++] = pattern[i++];
-                } else if (ccl_bufidx >= MAX_CHAR_CLASS_LEN) {
+                }
+                if (ccl_bufidx + copysize(&pattern[i], flags) > MAX_CHAR_CLASS_LEN) {
                     // fputs("exceeded internal buffer!\n", stderr);
                     return 0;
                 }
-                ccl_buf[ccl_bufidx++] = pattern[i];
+                ccl_bufidx += copychar(&ccl_buf[ccl_bufidx], &pattern[i], 1, flags);
             }
             if (ccl_bufidx >= MAX_CHAR_CLASS_LEN || ccl_bufidx == buf_begin) {
                 /* Catches cases such as [00000000000000000000000000000000000000][ */
@@ -221,7 +312,9 @@ re_t re_compile(const char* pattern) {
             }
             /* Null-terminate string end */
             ccl_buf[ccl_bufidx++] = 0;
-            re_compiled[j].u.ccl = &ccl_buf[buf_begin];
+            compiled->ccl[ccl_count].str = &ccl_buf[buf_begin];
+            compiled->ccl[ccl_count].tables = 0;
+            re_compiled[j].u.ccl = &compiled->ccl[ccl_count++];
         } break;
 
         case '{':
@@ -241,8 +334,9 @@ re_t re_compile(const char* pattern) {
         default:
         {
             re_compiled[j].type = CHAR;
-            memcpy(re_compiled[j].u.ch, &pattern[i], c_size);
-            re_compiled[j].ch_size = c_size;
+            re_compiled[j].ch_size = copychar(re_compiled[j].u.ch, &pattern[i], c_size, flags);
+            if (flags & RE_ICASE)
+                foldchar(&re_compiled[j]);
         } break;
         }
         /* no buffer-out-of-bounds access on invalid patterns
@@ -251,22 +345,56 @@ re_t re_compile(const char* pattern) {
         if (pattern[i] == 0)
             return 0;
 
+        /* A '+' after a quantifier makes it possessive. */
+        if ((re_compiled[j].type == STAR || re_compiled[j].type == PLUS ||
+             re_compiled[j].type == QUESTIONMARK || re_compiled[j].type == TIMES) &&
+            pattern[i + c_size] == '+') {
+            re_compiled[j].flags |= RE_POSSESSIVE;
+            i++;
+        }
+
         i += c_size;
         j += 1;
     }
     /* 'UNUSED' is a sentinel used to indicate end-of-pattern */
     re_compiled[j].type = UNUSED;
+    re_compiled[j].flags = (uint8_t)flags;
 
-    return (re_t) re_compiled;
+    /* Remember where each branch starts. */
+    compiled->branch_count = 1;
+    compiled->branches[0] = 0;
+    for (i = 0; i < j; i++) {
+        if (re_compiled[i].type == BRANCH)
+            compiled->branches[compiled->branch_count++] = (uint8_t)(i + 1);
+    }
+
+    return 1;
+}
+
+int re_compile_flags(re_t compiled, const char* pattern, int flags, int allow_jit) {
+    int i;
+    if (!re_compile_to(compiled, pattern, re_flags(flags)))
+        return 0;
+    compiled->memoize = (flags & TSM_FLAG_MEMOIZE) != 0 ||
+                        ((flags & TSM_FLAG_SAFE) && re_complexity(compiled->objs) > 1);
+    compiled->use_jit = allow_jit && (flags & TSM_FLAG_JIT) != 0;
+    for (i = 0; compiled->objs[i].type != UNUSED; i++) {
+        regex_t* p = &compiled->objs[i];
+        if (p->type == CHAR_CLASS || p->type == INV_CHAR_CLASS)
+            buildclass((re_ccl_t*)p->u.ccl, p->flags);
+    }
+    re_plan(compiled, 1);
+    return 1;
 }
 
 #ifdef TSM_USE_ALL_TINY_REGEX
-void re_print(regex_t* pattern) {
+void re_print(re_t compiled) {
+    regex_t* pattern = compiled->objs;
     const char* types[] = {
         "UNUSED", "DOT", "BEGIN", "END", "QUESTIONMARK", "STAR", "PLUS",
         "CHAR", "CHAR_CLASS", "INV_CHAR_CLASS", "DIGIT", "NOT_DIGIT",
         "ALPHA", "NOT_ALPHA", "WHITESPACE", "NOT_WHITESPACE", "BRANCH",
-        "TIMES",
+        "TIMES", "ICASE_CHAR",
     };
 
     int i;
@@ -280,7 +408,7 @@ void re_print(regex_t* pattern) {
         if (pattern[i].type == CHAR_CLASS || pattern[i].type == INV_CHAR_CLASS) {
             printf(" [");
             for (j = 0; j < MAX_CHAR_CLASS_LEN; ++j) {
-                c = pattern[i].u.ccl[j];
+                c = pattern[i].u.ccl->str[j];
                 if ((c == '\0') || (c == ']'))
                     break;
                 printf("%c", c);
@@ -288,6 +416,8 @@ void re_print(regex_t* pattern) {
             printf("]");
         } else if (pattern[i].type == CHAR) {
             printf(" '%c'", pattern[i].u.ch[0]);
+        } else if (pattern[i].type == ICASE_CHAR) {
+            printf(" U+%04X U+%04X", (unsigned)pattern[i].u.cp[0], (unsigned)pattern[i].u.cp[1]);
         } else if (pattern[i].type == TIMES) {
             printf("{%hu,%hu}", pattern[i].u.times.n, pattern[i].u.times.m);
         }
@@ -300,24 +430,414 @@ TsmResult tsm_regex_match(const char *pattern, const char *str) {
     if (pattern == NULL || str == NULL)
         return TSM_FAIL;
 
-    re_t compiled = re_compile(pattern);
-    if (!compiled)
+    struct TsmRegex compiled;
+    if (!re_compile_to(&compiled, pattern, 0))
+        return TSM_SYNTAX_ERROR;
+
+    re_plan(&compiled, 0);
+    return re_exec(&compiled, str) ? TSM_OK : TSM_FAIL;
+}
+
+TsmResult tsm_regex_fullmatch(const char *pattern, const char *str) {
+    if (pattern == NULL || str == NULL)
+        return TSM_FAIL;
+
+    struct TsmRegex compiled;
+    if (!re_compile_to(&compiled, pattern, 0))
+        return TSM_SYNTAX_ERROR;
+
+    re_plan(&compiled, 0);
+    return re_exec_full(&compiled, str) ? TSM_OK : TSM_FAIL;
+}
+
+TsmResult tsm_regex_compile(const char *pattern, int flags, TsmRegex **compiled) {
+    if (compiled == NULL)
+        return TSM_FAIL;
+    *compiled = NULL;
+    if (pattern == NULL)
+        return TSM_FAIL;
+
+    TsmRegex *re = (TsmRegex *)malloc(sizeof(TsmRegex));
+    if (re == NULL)
+        return TSM_OUT_OF_MEMORY;
+    if (!re_compile_flags(re, pattern, flags, 1)) {
+        free(re);
         return TSM_SYNTAX_ERROR;
+    }
+    *compiled = re;
+    return TSM_OK;
+}
+
+TsmResult tsm_regex_match_compiled(const TsmRegex *compiled, const char *str) {
+    if (compiled == NULL || str == NULL)
+        return TSM_FAIL;
+
+    return re_exec((re_t)compiled, str) ? TSM_OK : TSM_FAIL;
+}
+
+TsmResult tsm_regex_fullmatch_compiled(const TsmRegex *compiled, const char *str) {
+    if (compiled == NULL || str == NULL)
+        return TSM_FAIL;
+
+    return re_exec_full((re_t)compiled, str) ? TSM_OK : TSM_FAIL;
+}
+
+/* Matches utf-16 or utf-32 strings. Patterns without the VM match an utf-8 copy. */
+static TsmResult regex_match_units(const TsmRegex *compiled, const void *str, size_t len,
+                                   int unit) {
+    char stack_buf[256];
+    char* buf = stack_buf;
+    const char* found;
+    size_t size, matchlength;
+    int res;
+
+    if (compiled == NULL || str == NULL || compiled->bytes)
+        return TSM_FAIL;
+    if (compiled->vm.len && !compiled->memoize) {
+        PROF_CALL_BEGIN(&((re_t)compiled)->stats);
+        res = (unit == TSM_UNIT_UTF16)
+            ? vm_exec_utf16(&compiled->vm, compiled->objs, (const uint16_t*)str, len)
+            : vm_exec_utf32(&compiled->vm, compiled->objs, (const uint32_t*)str, len);
+        PROF_CALL_END(&((re_t)compiled)->stats);
+        return res ? TSM_OK : TSM_FAIL;
+    }
+
+    if (len > sizeof(stack_buf) / 4) {
+        if (len > SIZE_MAX / 4)
+            return TSM_OUT_OF_MEMORY;
+        buf = (char*)malloc(len * 4);
+        if (buf == NULL)
+            return TSM_OUT_OF_MEMORY;
+    }
+    size = tsm_unit_to_utf8(str, len, unit, buf);
+    res = re_search((re_t)compiled, buf, buf + size, buf, buf + size, &found, &matchlength);
+    if (buf != stack_buf)
+        free(buf);
+    return res == 1 ? TSM_OK : TSM_FAIL;
+}
+
+TsmResult tsm_regex_match_utf16(const TsmRegex *compiled, const uint16_t *str, size_t len) {
+    return regex_match_units(compiled, str, len, TSM_UNIT_UTF16);
+}
+
+TsmResult tsm_regex_match_utf32(const TsmRegex *compiled, const uint32_t *str, size_t len) {
+    return regex_match_units(compiled, str, len, TSM_UNIT_UTF32);
+}
+
+TsmStrategy tsm_regex_strategy(const TsmRegex *compiled) {
+    if (compiled == NULL)
+        return TSM_STRATEGY_BACKTRACK;
+    return compiled->strategy;
+}
+
+int tsm_regex_complexity(const TsmRegex *compiled) {
+    if (compiled == NULL)
+        return 0;
+    return re_complexity(compiled->objs);
+}
+
+TsmResult tsm_regex_search(const TsmRegex *compiled, const char *str, size_t len,
+                           size_t offset, TsmMatch *match) {
+    if (compiled == NULL || str == NULL || match == NULL || offset > len)
+        return TSM_FAIL;
+
+    const char* found;
+    size_t matchlength;
+    int res = re_search((re_t)compiled, str, str + len, str + offset, str + len,
+                        &found, &matchlength);
+    if (res != 1)
+        return TSM_FAIL;
+    match->start = (size_t)(found - str);
+    match->end = match->start + matchlength;
+    return TSM_OK;
+}
+
+/* Where to search after a match. Empty matches move to the next character.
+ * Returns NULL after an empty match at the end. The search has checked the character. */
+static const char* next_search(re_t compiled, const char* found, size_t matchlength,
+                               const char* end) {
+    if (matchlength > 0)
+        return found + matchlength;
+    if (found == end)
+        return NULL;
+    return found + re_runesize(compiled, found, end);
+}
+
+/* Appends bytes when the output has room for them and the null terminator.
+ * The length is counted anyway. */
+static void append(char* out, size_t out_size, size_t* out_len, const char* src, size_t size) {
+    if (out != NULL && *out_len + size < out_size)
+        memcpy(out + *out_len, src, size);
+    *out_len += size;
+}
+
+TsmResult tsm_regex_replace(const TsmRegex *compiled, const char *str, size_t len,
+                            const char *replacement, int all,
+                            char *out, size_t out_size, size_t *out_len) {
+    if (compiled == NULL || str == NULL || replacement == NULL || out_len == NULL)
+        return TSM_FAIL;
 
-    int matchlength;
-    int res = re_matchp(compiled, str, &matchlength);
-    return (res == -1 ? TSM_FAIL : TSM_OK);
+    const char* end = str + len;
+    const char* text = str;  /* the rest of the input that isn't copied yet */
+    const char* from = str;  /* where to search the next match */
+    const size_t replacement_len = strlen(replacement);
+    size_t total = 0;
+    while (from != NULL) {
+        const char* found;
+        size_t matchlength;
+        int res = re_search((re_t)compiled, str, end, from, end, &found, &matchlength);
+        if (res == -1)
+            return TSM_FAIL;
+        if (res == 0)
+            break;
+        append(out, out_size, &total, text, (size_t)(found - text));
+        append(out, out_size, &total, replacement, replacement_len);
+        text = found + matchlength;
+        from = all ? next_search((re_t)compiled, found, matchlength, end) : NULL;
+    }
+    append(out, out_size, &total, text, (size_t)(end - text));
+
+    *out_len = total;
+    if (out == NULL)
+        return TSM_OK;
+    if (total >= out_size)
+        return TSM_FAIL;
+    out[total] = '\0';
+    return TSM_OK;
+}
+
+TsmResult tsm_regex_split_init(TsmSplit *split, const TsmRegex *compiled,
+                               const char *str, size_t len) {
+    if (split == NULL || compiled == NULL || str == NULL)
+        return TSM_FAIL;
+    split->compiled = compiled;
+    split->str = str;
+    split->len = len;
+    split->start = 0;
+    split->next = 0;
+    split->done = 0;
+    return TSM_OK;
+}
+
+TsmResult tsm_regex_split_next(TsmSplit *split, const char **field, size_t *field_len) {
+    if (split == NULL || field == NULL || field_len == NULL || split->done)
+        return TSM_FAIL;
+
+    const char* str = split->str;
+    const char* end = str + split->len;
+    const char* found;
+    const char* next;
+    size_t matchlength;
+    int res = 0;
+    if (split->next <= split->len)
+        res = re_search((re_t)split->compiled, str, end, str + split->next, end,
+                        &found, &matchlength);
+    if (res == -1) {
+        split->done = 1;
+        return TSM_FAIL;
+    }
+    *field = str + split->start;
+    if (res == 0) {
+        /* The last field */
+        *field_len = split->len - split->start;
+        split->done = 1;
+        return TSM_OK;
+    }
+
+    *field_len = (size_t)(found - *field);
+    split->start = (size_t)(found - str) + matchlength;
+    next = next_search((re_t)split->compiled, found, matchlength, end);
+    split->next = next == NULL ? split->len + 1 : (size_t)(next - str);
+    return TSM_OK;
+}
+
+TsmResult tsm_regex_count(const TsmRegex *compiled, const char *str, size_t len,
+                          size_t *count) {
+    if (compiled == NULL || str == NULL || count == NULL)
+        return TSM_FAIL;
+
+    const char* end = str + len;
+    const char* from = str;
+    size_t total = 0;
+    TsmResult result = TSM_OK;
+    /* The whole count is one call for profiling. */
+    PROF_CALL_BEGIN(&((re_t)compiled)->stats);
+    int res = re_count_fast((re_t)compiled, str, end, &total);
+    if (res == 0)
+        result = TSM_FAIL;
+    while (res == -1 && from != NULL) {
+        /* Only the end of each match is needed to resume. */
+        const char* found;
+        size_t matchlength;
+        int found_res = search((re_t)compiled, str, end, from, end, &found, &matchlength);
+        if (found_res == -1)
+            result = TSM_FAIL;
+        if (found_res != 1)
+            break;
+        total++;
+        from = next_search((re_t)compiled, found, matchlength, end);
+    }
+    PROF_CALL_END(&((re_t)compiled)->stats);
+    if (result == TSM_OK)
+        *count = total;
+    return result;
+}
+
+void tsm_regex_free(TsmRegex *compiled) {
+    if (compiled != NULL)
+        jit_free(compiled->vm.jit);
+    free(compiled);
 }
 
 
 /* Private functions: */
+
+/* Finds the leftmost match in one pass. All branches are tried at each position in order.
+ * NULL limit means the end of the text. */
+static int backtrack(re_t compiled, const char* begin, const char* end, const char* from,
+                     const char* limit, int early, const char** match, size_t* matchlength) {
+    const char* text;
+    int anchored = 1;  /* all branches have '^' */
+    int res = 0;
+    int i;
+    re_ctx_t ctx;
+
+    if (limit == NULL)
+        limit = end;
+    for (i = 0; i < compiled->branch_count; i++) {
+        if (compiled->objs[compiled->branches[i]].type != BEGIN)
+            anchored = 0;
+    }
+
+    PROF_LOCAL(prof, &compiled->stats, begin);
+    ctx_init(&ctx, compiled, from, end);
+    if (early) {
+        ctx.early = 1;
+        ctx.nullable = nullable(compiled->objs);
+    }
+#ifdef TSM_PROFILE
+    ctx.prof = &prof;
+#endif
+    for (text = from; text < limit || text == end; ) {
+        int rune_size = runesize(&ctx, text);
+        if (!rune_size) {
+            res = -1;
+            break;
+        }
+        PROF_START(&prof, (size_t)(text - begin));
+        for (i = 0; i < compiled->branch_count && res == 0; i++) {
+            regex_t* pattern = &compiled->objs[compiled->branches[i]];
+            int has_start_anchor = pattern[0].type == BEGIN;
+            if (has_start_anchor && text != begin)
+                continue;
+            if (!canstart(pattern + has_start_anchor, text, &ctx, rune_size))
+                continue;
+            *matchlength = 0;
+            if (matchpattern(pattern + has_start_anchor, text, &ctx, rune_size, matchlength)) {
+                *match = text;
+                res = 1;
+            }
+        }
+        if (res != 0 || text == end || anchored)
+            break;
+        text += rune_size;
+    }
+    if (ctx.memo)
+        free(ctx.memo);
+    PROF_COMMIT(prof, &compiled->stats);
+    return res;
+}
+
+/* Checks the first atom of a branch before trying it. Most positions fail there,
+ * and the test is cheaper than setting up matchpattern(). */
+static int canstart(const regex_t* pattern, const char* text, const re_ctx_t* ctx, int rune_size) {
+    int match;
+    if (!re_isatom(pattern[0].type) || pattern[1].type == QUESTIONMARK ||
+        pattern[1].type == STAR || (pattern[1].type == TIMES && pattern[1].u.times.n == 0))
+        return 1;  /* the atom is optional */
+    if (text == ctx->end)
+        return 0;
+    if (pattern[0].type == CHAR && pattern[0].ch_size == 1)
+        match = *text == (char)pattern[0].u.ch[0];  /* an ASCII character: compare bytes */
+    else
+        match = matchone(pattern[0], text, rune_size);
+    if (!match)
+        STEP(ctx, pattern, text);  /* matchpattern() counts the step of matches */
+    return match;
+}
+
+/* Finds the objects where the rest of the branch can match the empty string.
+ * It's conservative: anchors and misplaced quantifiers need characters. */
+static uint32_t nullable(const regex_t* objs) {
+    uint32_t bits = 0;
+    int i = 0;
+    while (objs[i].type != UNUSED)
+        i++;
+    for (; i >= 0; i--) {
+        const regex_t* p = &objs[i];
+        if (p->type == UNUSED || p->type == BRANCH)
+            bits |= (uint32_t)1 << i;
+        else if (re_isatom(p->type) &&
+                 (p[1].type == STAR || p[1].type == QUESTIONMARK ||
+                  (p[1].type == TIMES && p[1].u.times.n == 0)))
+            bits |= (bits >> 2 & (uint32_t)1 << i);
+    }
+    return bits;
+}
+
+static void ctx_init(re_ctx_t* ctx, re_t compiled, const char* begin, const char* end) {
+    size_t rows = 1;
+    ctx->begin = begin;
+    ctx->end = end;
+    ctx->objs = compiled->objs;
+    ctx->memo = NULL;
+    ctx->width = (size_t)(end - begin) + 1;
+    ctx->full = 0;
+    ctx->bytes = compiled->bytes;
+    ctx->early = 0;
+    ctx->nullable = 0;
+    ctx->spans = compiled->use_spans ? compiled->spans : NULL;
+    if (!compiled->memoize)
+        return;
+
+    /* Patterns can visit objects until the sentinel. */
+    while (compiled->objs[rows - 1].type != UNUSED)
+        rows++;
+    if (ctx->width > RE_MEMO_MAX_BITS / rows)
+        return;  /* too long. Use plain backtracking. */
+    ctx->memo = (uint8_t*)calloc((rows * ctx->width + 7) / 8, 1);
+}
+
+/* Counts the binary size of a pattern character. Each byte is a character with RE_BYTES. */
+static int patternsize(const char* c, int flags) {
+    return ((flags & RE_BYTES) || (uint8_t)*c <= ASCII_MAX) ? 1 : tsm_rune_size(c);
+}
+
+/* Counts the size of a pattern byte in objects. Latin-1 characters take two bytes in utf-8. */
+static int copysize(const char* c, int flags) {
+    return ((flags & RE_BYTES) && (uint8_t)*c > ASCII_MAX) ? 2 : 1;
+}
+
+/* Copies a pattern character to objects. Returns the size of the copy. */
+static int copychar(uint8_t* out, const char* c, int c_size, int flags) {
+    if ((flags & RE_BYTES) && (uint8_t)*c > ASCII_MAX)
+        return tsm_rune_encode((uint8_t)*c, (char*)out);
+    if (c_size == 1) {
+        out[0] = (uint8_t)*c;
+        return 1;
+    }
+    memcpy(out, c, (size_t)c_size);
+    return c_size;
+}
+
 static int parsetimes(const char* pattern, uint16_t* n, uint16_t* m) {
     const char* start = pattern;
     uint16_t i = 0;
     int n_valid = 0, i_valid = 0;
 
     while (*pattern) {
-        if (matchdigit(*pattern)) {
+        if ((uint8_t)*pattern <= ASCII_MAX &&
+            (tsm_ascii_ctype[(uint8_t)*pattern] & TSM_CTYPE_DIGIT)) {
             i_valid = 1;
             i = i * 10 + (uint16_t)(*pattern - '0');
         } else if (*pattern == ',') {
@@ -342,20 +862,13 @@ static int parsetimes(const char* pattern, uint16_t* n, uint16_t* m) {
     return 0;
 }
 
-static int matchdigit(char c) {
-    return isdigit((uint8_t)c);
-}
-
-static int matchalpha(char c) {
-    return isalpha((uint8_t)c);
-}
-
-static int matchwhitespace(char c) {
-    return isspace((uint8_t)c);
-}
-
-static int matchalphanum(char c) {
-    return ((c == '_') || matchalpha(c) || matchdigit(c));
+/* Table-driven \d, \w, and \s. Multi-byte characters match only with RE_UNICODE. */
+static int matchctype(const char* c, int c_size, int flags, int type) {
+    if (c_size == 1)
+        return tsm_ascii_ctype[*c & ASCII_MAX] & type;
+    if (flags & RE_UNICODE)
+        return tsm_uni_isctype(tsm_rune_decode(c, c_size), type);
+    return 0;
 }
 
 static int matchrange(const char* c, int c_size, const char* str, int rune_size) {
@@ -366,6 +879,8 @@ static int matchrange(const char* c, int c_size, const char* str, int rune_size)
         || (str[rune_size + 1] == '\0'))
         return 0;
     const char* str2 = &str[rune_size + 1];
+    if (c_size == 1 && rune_size == 1 && (uint8_t)*str2 <= ASCII_MAX)  /* ASCII range */
+        return (uint8_t)str[0] <= (uint8_t)*c && (uint8_t)*c <= (uint8_t)*str2;
     int rune_size2 = tsm_rune_size(str2);
     if (!rune_size2) return 0;
     return (tsm_rune_cmp(c, c_size, str, rune_size) >= 0 &&
@@ -381,21 +896,24 @@ static int matchdot(char c) {
 #endif
 }
 
-static int matchmetachar(const char* c, int c_size, const char* str, int rune_size) {
+static int matchmetachar(const char* c, int c_size, const char* str, int rune_size, int flags) {
     switch (str[0]) {
-        case 'd': return  matchdigit(*c);
-        case 'D': return !matchdigit(*c);
-        case 'w': return  matchalphanum(*c);
-        case 'W': return !matchalphanum(*c);
-        case 's': return  matchwhitespace(*c);
-        case 'S': return !matchwhitespace(*c);
+        case 'd': return  matchctype(c, c_size, flags, TSM_CTYPE_DIGIT);
+        case 'D': return !matchctype(c, c_size, flags, TSM_CTYPE_DIGIT);
+        case 'w': return  matchctype(c, c_size, flags, TSM_CTYPE_WORD);
+        case 'W': return !matchctype(c, c_size, flags, TSM_CTYPE_WORD);
+        case 's': return  matchctype(c, c_size, flags, TSM_CTYPE_SPACE);
+        case 'S': return !matchctype(c, c_size, flags, TSM_CTYPE_SPACE);
         default:  return !tsm_rune_cmp(c, c_size, str, rune_size);
     }
 }
 
-static int matchcharclass(const char* c, int c_size, const char* str) {
+/* Counts the size of a class character without a call for ASCII. */
+#define classrunesize(str) ((uint8_t)*(str) <= ASCII_MAX ? 1 : tsm_rune_size(str))
+
+static int matchcharclass(const char* c, int c_size, const char* str, int flags) {
     do {
-        int rune_size = tsm_rune_size(str);
+        int rune_size = classrunesize(str);
         if (!rune_size) return 0;
         if (matchrange(c, c_size, str, rune_size)) {
             return 1;
@@ -404,9 +922,9 @@ static int matchcharclass(const char* c, int c_size, const char* str) {
             str += 1;
             rune_size = tsm_rune_size(str);
             if (!rune_size) return 0;
-            if (matchmetachar(c, c_size, str, rune_size))
+            if (matchmetachar(c, c_size, str, rune_size, flags))
                 return 1;
-        } else if (!tsm_rune_cmp(c, c_size, str, rune_size)) {
+        } else if (c_size == rune_size && !memcmp(c, str, (size_t)c_size)) {
             if (*c == '-')
                 return ((str[-1] == '\0') || (str[1] == '\0'));
             return 1;
@@ -419,125 +937,426 @@ static int matchcharclass(const char* c, int c_size, const char* str) {
     return 0;
 }
 
+/* ICASE_CHAR keeps the folded character and its uppercase.
+ * Other characters of the case class, such as the Kelvin sign for 'k', fold to the first one. */
+static void foldchar(regex_t* re) {
+    uint32_t cp = tsm_rune_decode((const char*)re->u.ch, re->ch_size);
+    uint32_t lower = tsm_rune_tolower(cp);
+    if (tsm_rune_orbit(lower) == lower)
+        return;  /* no case; keep it as CHAR */
+    re->type = ICASE_CHAR;
+    re->u.cp[0] = lower;
+    re->u.cp[1] = tsm_rune_toupper(lower);
+}
+
+/* Tests the character and the other characters of its case class. */
+static int matchfoldedclass(const char* c, int c_size, const char* str, int flags) {
+    char buf[4];
+    uint32_t cp = tsm_rune_decode(c, c_size);
+    uint32_t other;
+    if (matchcharclass(c, c_size, str, flags))
+        return 1;
+    for (other = tsm_rune_orbit(cp); other != cp; other = tsm_rune_orbit(other)) {
+        if (matchcharclass(buf, tsm_rune_encode(other, buf), str, flags))
+            return 1;
+    }
+    return 0;
+}
+
+/* Precompute the class for ASCII characters. It takes a test for each of them,
+ * so only compiled patterns build it. */
+static void buildclass(re_ccl_t* ccl, int flags) {
+    const char* str = (const char*)ccl->str;
+    int i;
+    memset(ccl->ascii, 0, sizeof(ccl->ascii));
+    for (i = 1; i <= ASCII_MAX; i++) {
+        char c = (char)i;
+        int match = (flags & RE_ICASE) ? matchfoldedclass(&c, 1, str, flags)
+                                       : matchcharclass(&c, 1, str, flags);
+        if (match)
+            ccl->ascii[i >> 5] |= (uint32_t)1 << (i & 31);
+    }
+    ccl->tables = 1;
+}
+
+static int matchclass(regex_t p, const char* c, int c_size) {
+    if (c_size == 1 && p.u.ccl->tables)
+        return (p.u.ccl->ascii[(*c >> 5) & 3] >> (*c & 31)) & 1;
+    if (p.flags & RE_ICASE)
+        return matchfoldedclass(c, c_size, (const char*)p.u.ccl->str, p.flags);
+    return matchcharclass(c, c_size, (const char*)p.u.ccl->str, p.flags);
+}
+
+static int matchicase(regex_t p, const char* c, int c_size) {
+    uint32_t cp = (c_size == 1) ? (uint8_t)*c : tsm_rune_decode(c, c_size);
+    return cp == p.u.cp[0] || cp == p.u.cp[1] ||
+           (cp > ASCII_MAX && tsm_rune_tolower(cp) == p.u.cp[0]);
+}
+
 static int matchone(regex_t p, const char* c, int c_size) {
+    char buf[2];
+    if ((p.flags & RE_BYTES) && c_size == 1 && (uint8_t)*c > ASCII_MAX) {
+        /* Objects have utf-8 characters. Encode the Latin-1 character. */
+        c_size = tsm_rune_encode((uint8_t)*c, buf);
+        c = buf;
+    }
     switch (p.type) {
         case DOT:            return matchdot(*c);
-        case CHAR_CLASS:     return  matchcharclass(c, c_size, (const char*)p.u.ccl);
-        case INV_CHAR_CLASS: return !matchcharclass(c, c_size, (const char*)p.u.ccl);
-        case DIGIT:          return  matchdigit(*c);
-        case NOT_DIGIT:      return !matchdigit(*c);
-        case ALPHA:          return  matchalphanum(*c);
-        case NOT_ALPHA:      return !matchalphanum(*c);
-        case WHITESPACE:     return  matchwhitespace(*c);
-        case NOT_WHITESPACE: return !matchwhitespace(*c);
+        case CHAR_CLASS:     return  matchclass(p, c, c_size);
+        case INV_CHAR_CLASS: return !matchclass(p, c, c_size);
+        case ICASE_CHAR:     return  matchicase(p, c, c_size);
+        case DIGIT:          return  matchctype(c, c_size, p.flags, TSM_CTYPE_DIGIT);
+        case NOT_DIGIT:      return !matchctype(c, c_size, p.flags, TSM_CTYPE_DIGIT);
+        case ALPHA:          return  matchctype(c, c_size, p.flags, TSM_CTYPE_WORD);
+        case NOT_ALPHA:      return !matchctype(c, c_size, p.flags, TSM_CTYPE_WORD);
+        case WHITESPACE:     return  matchctype(c, c_size, p.flags, TSM_CTYPE_SPACE);
+        case NOT_WHITESPACE: return !matchctype(c, c_size, p.flags, TSM_CTYPE_SPACE);
         case BEGIN:          return 0;
-        default:             return !tsm_rune_cmp(c, c_size, (const char*)p.u.ch, p.ch_size);
+        default:             return c_size == p.ch_size && *c == (char)p.u.ch[0] &&
+                                    (c_size == 1 || !memcmp(c, p.u.ch, (size_t)c_size));
     }
 }
 
-static int matchstar(regex_t p, regex_t* pattern,
-                     const char* text, int rune_size, int* matchlength) {
-    return matchplus(p, pattern, text, rune_size, matchlength) ||
-           matchpattern(pattern, text, rune_size, matchlength);
+int re_matchone(const regex_t* p, const char* c, int c_size) {
+    return matchone(*p, c, c_size);
 }
 
-static int matchplus(regex_t p, regex_t* pattern,
-                     const char* text, int rune_size, int* matchlength) {
-    const char* prepoint = text;
-    while ((text[0] != '\0') && matchone(p, text, rune_size)) {
-        text += rune_size;
-        *matchlength += rune_size;
-        rune_size = tsm_rune_size(text);
-        if (!rune_size) return 0;
-    }
-    while (text > prepoint) {
-        if (matchpattern(pattern, text, rune_size, matchlength)) {
-            *matchlength += (int)(text - prepoint);
+int re_runesize(re_t compiled, const char* text, const char* end) {
+    re_ctx_t ctx;
+    ctx.end = end;
+    ctx.bytes = compiled->bytes;
+    return runesize(&ctx, text);
+}
+
+int re_isatom(uint8_t type) {
+    switch (type) {
+        case DOT: case CHAR: case ICASE_CHAR: case CHAR_CLASS: case INV_CHAR_CLASS:
+        case DIGIT: case NOT_DIGIT: case ALPHA: case NOT_ALPHA:
+        case WHITESPACE: case NOT_WHITESPACE:
             return 1;
-        }
-        do {
-            text--;
-        } while (text > prepoint && is_multibyte_seq(*text));
-        rune_size = tsm_rune_size(text);
-        if (!rune_size) return 0;
+        default:
+            return 0;
     }
-
-    return 0;
 }
 
-static int matchquestion(regex_t p, regex_t* pattern,
-                         const char* text, int rune_size, int* matchlength) {
-    if (p.type == UNUSED || p.type == BRANCH ||
-        matchpattern(pattern, text, rune_size, matchlength))
-        return 1;
-    if (!*text)
-        return 0;
-    int match = matchone(p, text, rune_size);
-    text += rune_size;
-    if (match) {
-        int rune_size2 = tsm_rune_size(text);
-        if (!rune_size2) return 0;
-        if (matchpattern(pattern, text, rune_size2, matchlength)) {
-            *matchlength += rune_size;
-            return 1;
+int re_multibyte(const regex_t* p) {
+    switch (p->type) {
+        case DOT:
+            return RE_MB_ANY;
+        case CHAR:
+            return p->ch_size > 1 ? RE_MB_TEST : RE_MB_NONE;
+        case ICASE_CHAR:
+        {
+            /* Some ASCII letters have non-ASCII cases, such as the Kelvin sign for 'k'. */
+            uint32_t cp = p->u.cp[0];
+            do {
+                if (cp > ASCII_MAX)
+                    return RE_MB_TEST;
+                cp = tsm_rune_orbit(cp);
+            } while (cp != p->u.cp[0]);
+            return RE_MB_NONE;
         }
+        case DIGIT: case ALPHA: case WHITESPACE:
+            return (p->flags & RE_UNICODE) ? RE_MB_TEST : RE_MB_NONE;
+        case NOT_DIGIT: case NOT_ALPHA: case NOT_WHITESPACE:
+            return (p->flags & RE_UNICODE) ? RE_MB_TEST : RE_MB_ANY;
+        default:  /* character classes */
+            return RE_MB_TEST;
     }
-    return 0;
 }
 
-static int matchtimes(regex_t p, regex_t* pattern, uint16_t n, uint16_t m,
-                      const char* text, int rune_size, int* matchlength) {
-    uint16_t i = 0;
-    int pre = *matchlength;
-    /* Match the pattern n to m times */
-    do {
-        if (i >= n && matchpattern(pattern, text, rune_size, matchlength))
-            return 1;
-        if (!*text || !matchone(p, text, rune_size))
-            break;
-        text += rune_size;
-        *matchlength += rune_size;
-        rune_size = tsm_rune_size(text);
-        if (!rune_size) break;
-        i++;
-    } while (i <= m);
-
-    *matchlength = pre;
-    return 0;
+/* Finds the span scanner of a repeated atom. */
+static const span_t* atomspan(const regex_t* atom, const re_ctx_t* ctx) {
+    const span_t* sp;
+    if (!ctx->spans)
+        return NULL;
+    sp = &ctx->spans[atom - ctx->objs];
+    return sp->kind == SPAN_NONE ? NULL : sp;
 }
 
-static int matchend(regex_t p, const char* text) {
+static int matchend(regex_t p, const char* text, const re_ctx_t* ctx) {
     if (p.type == UNUSED || p.type == BRANCH)
-        return (text[0] == '\0');
+        return (text == ctx->end);
     return 0;
 }
 
-static int matchpattern(regex_t* pattern, const char* text, int rune_size, int* matchlength) {
-    int pre = *matchlength;
-    do {
-        if ((pattern[0].type == UNUSED) ||
-            (pattern[0].type == BRANCH) ||
-            (pattern[1].type == QUESTIONMARK))
-            return matchquestion(pattern[0], &pattern[2], text, rune_size, matchlength);
-        else if (pattern[0].type == TIMES)
+/* Bit of the memo for trying the pattern from an object at a position. */
+static size_t memokey(const re_ctx_t* ctx, const regex_t* pattern, const char* text) {
+    return (size_t)(pattern - ctx->objs) * ctx->width + (size_t)(text - ctx->begin);
+}
+
+/* Pushes a frame. The caller sets the other fields of its kind in stack[sp - 1]. */
+#define PUSH(kind_, pattern_, text_) do { \
+        assert(sp < RE_MAX_FRAMES); \
+        stack[sp].kind = (kind_); \
+        stack[sp].pattern = (pattern_); \
+        stack[sp].text = (text_); \
+        stack[sp].size = rune_size; \
+        sp++; \
+    } while (0)
+
+/* Matches the pattern at text. Instead of recursing for each quantifier,
+ * it pushes a choice point and tries the rest. Failures pop the last one and resume it. */
+static int matchpattern(const regex_t* pattern, const char* text, const re_ctx_t* ctx,
+                        int rune_size, size_t* matchlength) {
+    re_frame_t stack[RE_MAX_FRAMES];
+    re_frame_t* f;
+    uint8_t* const memo = ctx->memo;
+    const char* const end = ctx->end;
+    int sp = 0;
+    const char* start = text;
+    const char* low;
+    const span_t* span;
+    size_t run, key, reps, max;
+    uint16_t count;
+
+enter:
+    /* Try the rest of the pattern from the object at text. */
+    if (memo) {
+        /* The result only depends on the object and the position. Skip known failures. */
+        key = memokey(ctx, pattern, text);
+        if (memo[key >> 3] & (1 << (key & 7)))
+            goto fail;
+        assert(sp < RE_MAX_FRAMES);
+        stack[sp].kind = FRAME_MEMO;
+        stack[sp++].key = key;
+    }
+next:
+    if (ctx->early && (ctx->nullable >> (pattern - ctx->objs) & 1))
+        goto matched;  /* The extent of the match doesn't matter. */
+    if (pattern[0].type == UNUSED || pattern[0].type == BRANCH) {
+        if (!ctx->full || text == end)
+            goto matched;
+        goto fail;
+    }
+    if (pattern[1].type == QUESTIONMARK) {
+        if (pattern[1].flags & RE_POSSESSIVE) {
+            /* Take the atom if it matches, and keep it. */
+            if (text != end) {
+                STEP(ctx, pattern, text);
+                if (matchone(pattern[0], text, rune_size) &&
+                    (run = (size_t)runesize(ctx, text + rune_size)) != 0) {
+                    text += rune_size;
+                    rune_size = (int)run;
+                }
+            }
+            pattern += 2;
+            goto enter;
+        }
+        /* Try without the atom first. */
+        PUSH(FRAME_QUESTION, pattern, text);
+        pattern += 2;
+        goto enter;
+    }
+    if (pattern[0].type == TIMES)
+        goto fail;
+    if (pattern[1].type == STAR || pattern[1].type == PLUS) {
+        /* Match as many as possible, then back off. */
+        low = text;
+        span = atomspan(pattern, ctx);
+        while (text != end) {
+            /* Jump over runs of single bytes, then match a multi-byte character. */
+            run = span ? span_scan(span, text, end) : 0;
+            STEP(ctx, pattern, text);
+            if (run)
+                text += run;
+            else if (matchone(pattern[0], text, rune_size))
+                text += rune_size;
+            else
+                break;
+            rune_size = runesize(ctx, text);
+            if (!rune_size) {
+                /* Give up all the repetitions. */
+                text = low;
+                rune_size = runesize(ctx, text);
+                goto none;
+            }
+        }
+        if (text == low)
+            goto none;
+        if (pattern[1].flags & RE_POSSESSIVE) {
+            pattern += 2;  /* No choice to come back to */
+            goto enter;
+        }
+        PUSH(pattern[1].type == STAR ? FRAME_STAR : FRAME_PLUS, pattern, text);
+        stack[sp - 1].low = low;
+        stack[sp - 1].high = NULL;
+        pattern += 2;
+        goto enter;
+    }
+    if (pattern[0].type == END) {
+        if (matchend(pattern[1], text, ctx))
+            goto matched;
+        goto fail;
+    }
+    if (pattern[1].type == TIMES) {
+        if (pattern[1].flags & RE_POSSESSIVE)
+            goto most;
+        count = 0;
+        span = atomspan(pattern, ctx);
+        if (span && pattern[1].u.times.n > 0) {
+            /* The first n repetitions don't need to try the rest of the pattern. */
+            run = span_scan(span, text, end);
+            STEP(ctx, pattern, text);
+            if (run > pattern[1].u.times.n)
+                run = pattern[1].u.times.n;
+            if (run) {
+                text += run;
+                count = (uint16_t)run;
+                rune_size = runesize(ctx, text);
+                if (!rune_size)
+                    goto fail;
+            }
+        }
+        goto times;
+    }
+    if (text == end)
+        goto fail;
+    STEP(ctx, pattern, text);
+    if (!matchone(*pattern++, text, rune_size))
+        goto fail;
+    text += rune_size;
+    rune_size = runesize(ctx, text);
+    if (!rune_size)
+        goto fail;
+    goto next;
+
+times:
+    /* Match the atom n to m times. Try the rest after each of them. */
+    if (count >= pattern[1].u.times.n) {
+        PUSH(FRAME_TIMES, pattern, text);
+        stack[sp - 1].count = count;
+        pattern += 2;
+        goto enter;
+    }
+more:
+    if (text == end)
+        goto fail;
+    STEP(ctx, pattern, text);
+    if (!matchone(pattern[0], text, rune_size))
+        goto fail;
+    text += rune_size;
+    rune_size = runesize(ctx, text);
+    if (!rune_size)
+        goto fail;
+    count++;
+    if (count <= pattern[1].u.times.m)
+        goto times;
+    goto fail;
+
+most:
+    /* Possessive {n,m}: as many repetitions as possible up to m */
+    low = text;
+    reps = 0;
+    max = pattern[1].u.times.m == MAX_USHORT ? (size_t)-1 : pattern[1].u.times.m;
+    span = atomspan(pattern, ctx);
+    while (text != end && reps < max) {
+        run = span ? span_scan(span, text, end) : 0;
+        STEP(ctx, pattern, text);
+        if (run) {
+            if (run > max - reps)
+                run = max - reps;
+            text += run;
+            reps += run;
+        } else if (matchone(pattern[0], text, rune_size)) {
+            text += rune_size;
+            reps++;
+        } else {
             break;
-        else if (pattern[1].type == STAR)
-            return matchstar(pattern[0], &pattern[2], text, rune_size, matchlength);
-        else if (pattern[1].type == PLUS)
-            return matchplus(pattern[0], &pattern[2], text, rune_size, matchlength);
-        else if (pattern[0].type == END)
-            return matchend(pattern[1], text);
-        else if (pattern[1].type == TIMES)
-            return matchtimes(pattern[0], &pattern[2], pattern[1].u.times.n, pattern[1].u.times.m,
-                              text, rune_size, matchlength);
-        *matchlength += rune_size;
-        if ((text[0] == '\0') || !matchone(*pattern++, text, rune_size))
+        }
+        rune_size = runesize(ctx, text);
+        if (!rune_size) {
+            /* Give up all the repetitions like atom* does. */
+            text = low;
+            rune_size = runesize(ctx, text);
+            reps = 0;
             break;
-        text += rune_size;
-        rune_size = tsm_rune_size(text);
-        if (!rune_size) break;
-    } while (1);
+        }
+    }
+    if (reps < pattern[1].u.times.n)
+        goto fail;
+    pattern += 2;
+    goto enter;
+
+none:
+    /* No repetitions of atom* or atom+ */
+    if (pattern[1].type == PLUS)
+        goto fail;
+    BACKTRACK(ctx, pattern, text);
+    pattern += 2;
+    goto enter;
+
+matched:
+    *matchlength = (size_t)(text - start);
+    return 1;
 
-    *matchlength = pre;
+fail:
+    while (sp > 0) {
+        f = &stack[sp - 1];
+        if (f->kind == FRAME_MEMO) {
+            sp--;
+            memo[f->key >> 3] |= (uint8_t)(1 << (f->key & 7));
+            continue;
+        }
+        pattern = f->pattern;
+        text = f->text;
+        switch (f->kind) {
+            case FRAME_QUESTION:
+                /* Then with the atom. */
+                sp--;
+                BACKTRACK(ctx, pattern, text);
+                if (text == end)
+                    continue;
+                rune_size = f->size;
+                STEP(ctx, pattern, text);
+                if (!matchone(pattern[0], text, rune_size))
+                    continue;
+                text += rune_size;
+                rune_size = runesize(ctx, text);
+                if (!rune_size)
+                    continue;
+                pattern += 2;
+                goto enter;
+            case FRAME_TIMES:
+                /* One more repetition. */
+                sp--;
+                BACKTRACK(ctx, pattern, text);
+                count = f->count;
+                rune_size = f->size;
+                goto more;
+            default:
+                /* FRAME_STAR and FRAME_PLUS: one less repetition.
+                 * Positions where the rest is known to fail are skipped here. */
+                low = f->low;
+                do {
+                    if (ctx->early) {
+                        /* Any count proves a match. After the most, try the fewest. */
+                        if (!f->high) {
+                            f->high = text;
+                            text = low;
+                        }
+                        text += runesize(ctx, text);
+                    } else {
+                        do {
+                            text--;
+                        } while (text > low && !ctx->bytes && is_multibyte_seq(*text));
+                    }
+                    rune_size = runesize(ctx, text);
+                    if (text == low || text == f->high || !rune_size) {
+                        sp--;
+                        text = low;
+                        rune_size = runesize(ctx, text);
+                        goto none;
+                    }
+                    BACKTRACK(ctx, pattern, text);
+                    key = memo ? memokey(ctx, pattern + 2, text) : 0;
+                } while (memo && (memo[key >> 3] & (1 << (key & 7))));
+                f->text = text;
+                pattern += 2;
+                goto enter;
+        }
+    }
     return 0;
 }
+
+#undef PUSH
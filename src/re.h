@@ -23,8 +23,13 @@
  *   '{n}'      Match n times
  *   '{n,}'     Match n or more times
  *   '{n,m}'    Match n to m times
+ *   '*+' '++' '?+' '{n,m}+'
+ *              Possessive, match as many as possible and never give them back
  *   '|'        Branch Or, e.g. a|A, \w|\s
  *
+ * '(' and ')' are literal characters. There are no groups, so atomic groups like
+ * '(?>...)' aren't available. Possessive quantifiers only apply to a single atom.
+ *
  */
 
 #ifndef _TINY_REGEX_C
@@ -36,24 +41,177 @@
 #define RE_DOT_MATCHES_NEWLINE 1
 #endif
 
+#include <stddef.h>
+#include <stdint.h>
+#include "bitpar.h"
+#include "profile.h"
+#include "span.h"
+#include "vm.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 
 
+/* Definitions: */
+#define MAX_REGEXP_OBJECTS      30    /* Max number of regex symbols in expression. */
+#define MAX_CHAR_CLASS_LEN      40    /* Max length of character-class buffer in.   */
+#define MAX_CHAR_CLASSES        (MAX_CHAR_CLASS_LEN / 2)  /* Max number of classes. */
+#define MAX_USHORT 0xffff
+
+/* Max size of the memo for TSM_FLAG_MEMOIZE (32 MiB) */
+#define RE_MEMO_MAX_BITS ((size_t)1 << 28)
+
+/* Frames of the backtracker's stack. It doesn't grow with the text:
+ * the first attempt pushes a memo frame, and nested attempts start at least two objects apart,
+ * and each pushes a choice and a memo frame. matchpattern() asserts the size. */
+#define RE_MAX_FRAMES (1 + MAX_REGEXP_OBJECTS)
+
+/* Flags for each regex symbol */
+#define RE_ICASE   0x01  /* Case-insensitive */
+#define RE_UNICODE 0x02  /* Unicode-aware \d, \w, and \s */
+#define RE_BYTES   0x04  /* Each byte is a Latin-1 character. They're stored as utf-8 in objects. */
+#define RE_POSSESSIVE 0x08  /* Quantifiers: never give repetitions back (*+, ++, ?+, {n,m}+) */
+
+/* Convert TsmFlag values to flags for regex symbols */
+#define re_flags(tsm_flags) \
+    ((((tsm_flags) & TSM_FLAG_ICASE) ? RE_ICASE : 0) | \
+     (((tsm_flags) & TSM_FLAG_UNICODE) ? RE_UNICODE : 0) | \
+     (((tsm_flags) & TSM_FLAG_BYTES) ? RE_BYTES : 0))
+
+enum {
+    UNUSED, DOT, BEGIN, END, QUESTIONMARK, STAR, PLUS,
+    CHAR, CHAR_CLASS, INV_CHAR_CLASS, DIGIT, NOT_DIGIT,
+    ALPHA, NOT_ALPHA, WHITESPACE, NOT_WHITESPACE, BRANCH,
+    TIMES, ICASE_CHAR,
+};
+
+typedef struct re_ccl_t {
+    uint32_t ascii[4];    /* bitmap for ASCII characters (folded with RE_ICASE) */
+    const uint8_t* str;   /* characters inside [..] for multi-byte characters */
+    int tables;           /* ascii is built. One-shot matches test str instead. */
+} re_ccl_t;
+
+typedef struct regex_t {
+    uint8_t  type;   /* CHAR, STAR, etc.                      */
+    uint8_t  flags;  /* RE_ICASE, etc.                        */
+    union {
+        uint8_t  ch[4];   /*      the character itself             */
+        uint32_t cp[2];   /*  OR  lower and upper cases of ICASE_CHAR */
+        const re_ccl_t* ccl;  /*  OR  a pointer to the character class */
+        struct {
+            uint16_t n;
+            uint16_t m;
+        } times;
+    } u;
+    int ch_size;
+} regex_t;
+
+/* Compiled pattern. Objects point to classes in the same struct.
+ * tools/tsm_gen.c writes the fields as C initializers, so new fields should be added there. */
+struct TsmRegex {
+    regex_t objs[MAX_REGEXP_OBJECTS];
+    re_ccl_t ccl[MAX_CHAR_CLASSES];
+    uint8_t ccl_buf[MAX_CHAR_CLASS_LEN];
+    uint8_t branches[MAX_REGEXP_OBJECTS];  /* start index of each branch */
+    int branch_count;
+    int strategy;  /* TsmStrategy chosen by re_plan() */
+    int memoize;   /* remember failed states while backtracking */
+    int bytes;     /* RE_BYTES: no utf-8 decoding or validation */
+    int use_spans; /* spans are built for repeated atoms */
+    int use_jit;   /* compile the VM program to machine code (TSM_FLAG_JIT) */
+    size_t literal_len;
+    char literal[MAX_REGEXP_OBJECTS * 4 + 1];  /* the pattern without anchors for literals */
+    bitpar_t bp;
+    vm_prog_t vm;
+    span_t spans[MAX_REGEXP_OBJECTS];  /* scanners for atoms before '*', '+', and {n,m} */
+#ifdef TSM_PROFILE
+    re_stats_t stats;
+#endif
+};
+
 /* Typedef'd pointer to get abstract datatype. */
-typedef struct regex_t* re_t;
+typedef struct TsmRegex* re_t;
 
 
 /* Compile regex string pattern to a regex_t-array. */
 re_t re_compile(const char* pattern);
 
 
-/* Find matches of the compiled pattern inside text. */
+/* Compile regex string pattern to the given object. Returns zero on syntax errors. */
+int re_compile_to(re_t compiled, const char* pattern, int flags);
+
+
+/* Compile a pattern with TsmFlag values and choose its engine like tsm_regex_compile().
+ * TSM_FLAG_JIT is ignored when allow_jit is zero. Returns zero on syntax errors. */
+int re_compile_flags(re_t compiled, const char* pattern, int flags, int allow_jit);
+
+
+/* Choose the cheapest engine for the compiled pattern.
+ * Tables for the bit-parallel engine are built only when use_tables is non-zero. */
+void re_plan(re_t compiled, int use_tables);
+
+
+/* Check if the text has the pattern with the engine chosen by re_plan(). */
+int re_exec(re_t compiled, const char* text);
+
+
+/* Check if the whole text matches the pattern with the engine chosen by re_plan(). */
+int re_exec_full(re_t compiled, const char* text);
+
+
+/* Search the literal pattern like re_search().
+ * Returns -1 when re_search() should decide the result with the backtracker. */
+int re_search_literal(re_t compiled, const char* end, const char* from, const char* limit,
+                      const char** match, size_t* matchlength);
+
+
+/* Count non-overlapping matches in [begin, end) with the literal engine or BNDM.
+ * Returns 1 when counted, 0 when found an invalid utf-8 character,
+ * and -1 when the pattern should be counted with re_search(). */
+int re_count_fast(re_t compiled, const char* begin, const char* end, size_t* count);
+
+
+/* Find the leftmost match of the compiled pattern inside text. Returns its position or -1. */
 int re_matchp(re_t pattern, const char* text, int* matchlength);
 
 
+/* Check if [begin, end) has the compiled pattern with the backtracker.
+ * It stops at the first accepting state without finding where the match ends. */
+int re_test(re_t compiled, const char* begin, const char* end);
+
+
+/* Check if the whole text matches the compiled pattern with the backtracker. */
+int re_fullmatchp(re_t compiled, const char* text);
+
+
+/* Find the leftmost match that starts in [from, limit) inside [begin, end).
+ * It also tries the end of the text when limit == end.
+ * Returns 1 when found, 0 when not found, and -1 when found an invalid utf-8 character. */
+int re_search(re_t compiled, const char* begin, const char* end,
+              const char* from, const char* limit, const char** match, size_t* matchlength);
+
+
+/* Check if a character matches a regex symbol. */
+int re_matchone(const regex_t* p, const char* c, int c_size);
+
+
+/* Count the binary size of a character. Always one with RE_BYTES. The end acts as '\0'. */
+int re_runesize(re_t compiled, const char* text, const char* end);
+
+
+/* Check if a regex symbol matches a character. (Not an anchor, a quantifier, or '|') */
+int re_isatom(uint8_t type);
+
+
+/* How an atom matches multi-byte characters. */
+#define RE_MB_NONE 0  /* never matches them */
+#define RE_MB_ANY  1  /* matches all of them */
+#define RE_MB_TEST 2  /* should call re_matchone() for each character */
+int re_multibyte(const regex_t* p);
+
+
 #ifdef TSM_USE_ALL_TINY_REGEX
 /* Find matches of the txt pattern inside text (will compile automatically first). */
 int re_match(const char* pattern, const char* text, int* matchlength);
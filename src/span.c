@@ -0,0 +1,155 @@
+/*
+ * Span scanners for repeated atoms. (See span.h)
+ *
+ * The SIMD kernels are compiled with target attributes on GCC and Clang,
+ * and chosen at run time, so the library doesn't need -mssse3 or -mavx2.
+ */
+
+#include <string.h>
+#include "span.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__)) && !defined(TSM_NO_SIMD)
+#define SPAN_X86
+#include <immintrin.h>
+#endif
+
+#define in_set(sp, b) (((sp)->bits[(b) >> 5] >> ((b) & 31)) & 1)
+
+/* Fills the nibble tables. Returns zero when the set needs more than 8 buckets. */
+static int build_nibbles(span_t* sp) {
+    uint16_t lows[16];  /* low nibbles of each high nibble */
+    uint16_t buckets[8];
+    int count = 0;
+    int h, l, k;
+
+    memset(sp->lo, 0, sizeof(sp->lo));
+    memset(sp->hi, 0, sizeof(sp->hi));
+    for (h = 0; h < 16; h++) {
+        lows[h] = 0;
+        for (l = 0; l < 16; l++) {
+            if (in_set(sp, h << 4 | l))
+                lows[h] |= (uint16_t)(1 << l);
+        }
+    }
+    for (h = 0; h < 16; h++) {
+        if (!lows[h])
+            continue;
+        for (k = 0; k < count && buckets[k] != lows[h]; k++) {}
+        if (k == count) {
+            if (count == 8)
+                return 0;
+            buckets[count++] = lows[h];
+        }
+        sp->hi[h] = (uint8_t)(1 << k);
+    }
+    for (k = 0; k < count; k++) {
+        for (l = 0; l < 16; l++) {
+            if (buckets[k] & (1 << l))
+                sp->lo[l] |= (uint8_t)(1 << k);
+        }
+    }
+    return 1;
+}
+
+#ifdef SPAN_X86
+/* The fastest kernel on this processor. */
+static int cpu_kind(void) {
+    static int cached = SPAN_DETECT;
+    int kind = __atomic_load_n(&cached, __ATOMIC_RELAXED);
+    if (kind == SPAN_DETECT) {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            kind = SPAN_AVX2;
+        else if (__builtin_cpu_supports("ssse3"))
+            kind = SPAN_SSSE3;
+        else
+            kind = SPAN_SCALAR;
+        __atomic_store_n(&cached, kind, __ATOMIC_RELAXED);
+    }
+    return kind;
+}
+#endif
+
+void span_init(span_t* sp, const uint32_t bits[8]) {
+    int i, empty = 1;
+    memcpy(sp->bits, bits, sizeof(sp->bits));
+    for (i = 0; i < 8; i++) {
+        if (bits[i])
+            empty = 0;
+    }
+    if (empty) {
+        sp->kind = SPAN_NONE;
+        return;
+    }
+    sp->kind = SPAN_SCALAR;
+    if (!build_nibbles(sp))
+        return;
+#ifdef SPAN_X86
+    sp->kind = cpu_kind();
+#endif
+}
+
+static size_t span_scalar(const span_t* sp, const uint8_t* p, const uint8_t* end) {
+    const uint8_t* start = p;
+    while (p < end && in_set(sp, *p))
+        p++;
+    return (size_t)(p - start);
+}
+
+#ifdef SPAN_X86
+__attribute__((target("ssse3")))
+static size_t span_ssse3(const span_t* sp, const uint8_t* p, const uint8_t* end) {
+    const __m128i lo = _mm_loadu_si128((const __m128i*)sp->lo);
+    const __m128i hi = _mm_loadu_si128((const __m128i*)sp->hi);
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i zero = _mm_setzero_si128();
+    const uint8_t* start = p;
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        __m128i l = _mm_shuffle_epi8(lo, _mm_and_si128(v, nibble));
+        __m128i h = _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+        unsigned miss = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(l, h), zero));
+        if (miss)
+            return (size_t)(p - start) + (size_t)__builtin_ctz(miss);
+        p += 16;
+    }
+    return (size_t)(p - start) + span_scalar(sp, p, end);
+}
+
+__attribute__((target("avx2")))
+static size_t span_avx2(const span_t* sp, const uint8_t* p, const uint8_t* end) {
+    /* pshufb looks up each 128-bit lane, so both lanes have the tables. */
+    const __m256i lo = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)sp->lo));
+    const __m256i hi = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)sp->hi));
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i zero = _mm256_setzero_si256();
+    const uint8_t* start = p;
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)p);
+        __m256i l = _mm256_shuffle_epi8(lo, _mm256_and_si256(v, nibble));
+        __m256i h = _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+        unsigned miss = (unsigned)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_and_si256(l, h), zero));
+        if (miss)
+            return (size_t)(p - start) + (size_t)__builtin_ctz(miss);
+        p += 32;
+    }
+    return (size_t)(p - start) + span_ssse3(sp, p, end);
+}
+#endif
+
+size_t span_scan(const span_t* sp, const char* text, const char* end) {
+    const uint8_t* p = (const uint8_t*)text;
+    /* Most runs are short. Check the first byte before loading vectors. */
+    if (text >= end || !in_set(sp, *p))
+        return 0;
+#ifdef SPAN_X86
+    int kind = sp->kind == SPAN_DETECT ? cpu_kind() : sp->kind;
+    if (kind == SPAN_AVX2)
+        return 1 + span_avx2(sp, p + 1, (const uint8_t*)end);
+    if (kind == SPAN_SSSE3)
+        return 1 + span_ssse3(sp, p + 1, (const uint8_t*)end);
+#endif
+    return 1 + span_scalar(sp, p + 1, (const uint8_t*)end);
+}
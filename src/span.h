@@ -0,0 +1,52 @@
+/*
+ * Span scanners for repeated atoms.
+ *
+ * A span is the longest run of bytes in a set, such as [0-9] for "\d+".
+ * Quantifiers jump to the end of the run, and then match the rest one character at a time.
+ * Sets for utf-8 patterns only have ASCII bytes, so runs stop at multi-byte characters.
+ *
+ * A byte b is in the set when lo[b & 15] & hi[b >> 4] is non-zero.
+ * High nibbles with the same set of low nibbles share a bit, so ASCII sets always fit in 8 bits.
+ * The nibble tables are looked up with pshufb on x86 processors with SSSE3 or AVX2.
+ * Other sets and processors use the bitmap.
+ * Define TSM_NO_SIMD to use the bitmap anyway.
+ * Spans generated on another machine don't know the processor, so they use SPAN_DETECT.
+ *
+ */
+
+#ifndef __TINY_STR_MATCH_INCLUDE_SPAN_H__
+#define __TINY_STR_MATCH_INCLUDE_SPAN_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    SPAN_NONE,    /* empty set */
+    SPAN_SCALAR,  /* bitmap */
+    SPAN_SSSE3,   /* nibble tables, 16 bytes at a time */
+    SPAN_AVX2,    /* nibble tables, 32 bytes at a time */
+    SPAN_DETECT,  /* nibble tables, the kernel is chosen when scanning (tsm-gen) */
+};
+
+typedef struct span_t {
+    uint32_t bits[8];  /* bytes in the set */
+    uint8_t lo[16];    /* buckets of each low nibble */
+    uint8_t hi[16];    /* the bucket of each high nibble */
+    int kind;          /* SPAN_* */
+} span_t;
+
+/* Builds a scanner for the bytes in bits. */
+void span_init(span_t* sp, const uint32_t bits[8]);
+
+/* Counts bytes in the set from text. */
+size_t span_scan(const span_t* sp, const char* text, const char* end);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __TINY_STR_MATCH_INCLUDE_SPAN_H__
@@ -0,0 +1,524 @@
+// This file is generated by tools/gen_uctype_tables.py. DO NOT EDIT.
+// Unicode version: 14.0.0
+#ifndef __TINY_STR_MATCH_INCLUDE_UCTYPE_TABLES_H__
+#define __TINY_STR_MATCH_INCLUDE_UCTYPE_TABLES_H__
+
+#include <stdint.h>
+
+#define UCTYPE_MAX_CP 0x40000
+
+static const uint8_t uctype_digit_index[1024] = {
+    0, 1, 1, 1, 1, 1, 2, 3, 1, 4, 4, 4, 4, 4, 5, 6,
+    7, 1, 1, 1, 1, 1, 1, 8, 9, 10, 11, 12, 13, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 6, 1, 14, 15, 16, 17, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 9,
+    1, 1, 1, 1, 18, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 1,
+    19, 20, 17, 1, 5, 1, 21, 0, 8, 16, 1, 1, 16, 22, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 23, 16, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 24, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 25, 17, 1, 1, 1, 1, 1, 1, 16, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 17, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+};
+
+static const uint32_t uctype_digit_blocks[26][8] = {
+    { 0x00000000, 0x03FF0000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x00000000, 0x000003FF,
+      0x00000000, 0x00000000, 0x00000000, 0x03FF0000 },
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x000003FF, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x00000000, 0x0000FFC0,
+      0x00000000, 0x00000000, 0x00000000, 0x0000FFC0 },
+    { 0x00000000, 0x00000000, 0x03FF0000, 0x00000000,
+      0x00000000, 0x00000000, 0x03FF0000, 0x00000000 },
+    { 0x00000000, 0x000003FF, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x000003FF, 0x00000000,
+      0x03FF0000, 0x00000000, 0x00000000, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x000003FF },
+    { 0x03FF0000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x0000FFC0, 0x00000000,
+      0x00000000, 0x00000000, 0x03FF0000, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x03FF03FF, 0x00000000, 0x00000000, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x03FF0000, 0x00000000,
+      0x00000000, 0x03FF0000, 0x00000000, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x03FF03FF, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x03FF0000, 0x00000000 },
+    { 0x000003FF, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x03FF0000, 0x03FF0000 },
+    { 0x00000000, 0x00000000, 0x03FF0000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x03FF0000 },
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x000003FF, 0x00000000, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x00000000, 0x0000FFC0,
+      0x00000000, 0x00000000, 0x00000000, 0x03FF0000 },
+    { 0x00000000, 0xFFC00000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x03FF0000, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x03FF0000, 0x00000000,
+      0x00000000, 0x00000000, 0x000003FF, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x03FF0000, 0x00000000,
+      0x00000000, 0x000003FF, 0x00000000, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x00000000, 0x000003FF,
+      0x00000000, 0x00000000, 0x000003FF, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0xFFFFC000, 0xFFFFFFFF },
+    { 0x00000000, 0x00000000, 0x000003FF, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+};
+
+static const uint8_t uctype_word_index[1024] = {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+    16, 1, 17, 18, 19, 1, 20, 21, 22, 23, 24, 25, 26, 1, 1, 27,
+    28, 29, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 31, 32, 33, 30,
+    34, 35, 30, 30, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 36, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 37, 1, 38, 39, 40, 41, 42, 43, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 44, 30, 30, 30, 30, 30, 30, 30, 30,
+    30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30,
+    30, 30, 30, 30, 30, 30, 30, 30, 30, 1, 45, 46, 1, 47, 48, 49,
+    50, 51, 52, 53, 54, 55, 1, 56, 57, 58, 59, 60, 61, 62, 63, 64,
+    65, 66, 67, 68, 69, 70, 71, 72, 73, 74, 75, 30, 76, 77, 78, 79,
+    1, 1, 1, 80, 81, 82, 30, 30, 30, 30, 30, 30, 30, 30, 30, 83,
+    1, 1, 1, 1, 84, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30,
+    30, 30, 30, 30, 1, 1, 85, 30, 30, 30, 30, 30, 30, 30, 30, 30,
+    30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30,
+    30, 30, 30, 30, 30, 30, 30, 30, 1, 1, 86, 87, 30, 30, 88, 89,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 90, 1, 1, 1, 1, 91, 92, 30, 30,
+    30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30,
+    30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 93,
+    1, 94, 95, 30, 30, 30, 30, 30, 30, 30, 30, 30, 96, 30, 30, 30,
+    30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 97,
+    30, 98, 99, 30, 100, 101, 102, 103, 30, 30, 104, 30, 30, 30, 30, 105,
+    106, 107, 108, 30, 30, 30, 30, 109, 110, 111, 30, 30, 30, 30, 112, 30,
+    30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 113, 30, 30, 30, 30,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 114, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 115, 116, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 117, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 118, 30, 30, 30, 30,
+    30, 30, 30, 30, 30, 30, 30, 30, 1, 1, 119, 30, 30, 30, 30, 30,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 120, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30,
+    30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30,
+    30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30,
+    30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30,
+    30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30,
+    30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30,
+    30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30,
+    30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30,
+    30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30,
+    30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30,
+    30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30,
+    30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30,
+    30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30,
+    30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30,
+    30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30,
+};
+
+static const uint32_t uctype_word_blocks[121][8] = {
+    { 0x00000000, 0x03FF0000, 0x87FFFFFE, 0x07FFFFFE,
+      0x00000000, 0x04200400, 0xFF7FFFFF, 0xFF7FFFFF },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+      0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+      0xFFFFFFFF, 0xFFFFFFFF, 0x0003FFC3, 0x0000501F },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xBCDFFFFF,
+      0xFFFFD740, 0xFFFFFFFB, 0xFFFFFFFF, 0xFFBFFFFF },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+      0xFFFFFCFB, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF },
+    { 0xFFFFFFFF, 0xFFFEFFFF, 0x027FFFFF, 0xFFFFFFFF,
+      0xFFFE01FF, 0xBFFFFFFF, 0xFFFF00B6, 0x000787FF },
+    { 0x07FF0000, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFC3FF,
+      0xFFFFFFFF, 0xFFFFFFFF, 0x9FEFFFFF, 0x9FFFFDFF },
+    { 0xFFFF0000, 0xFFFFFFFF, 0xFFFFE7FF, 0xFFFFFFFF,
+      0xFFFFFFFF, 0x0003FFFF, 0xFFFFFFFF, 0x243FFFFF },
+    { 0xFFFFFFFF, 0x00003FFF, 0x0FFFFFFF, 0xFFFF07FF,
+      0xFF007EFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFB },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFEFFCF,
+      0xFFF99FEF, 0xF3C5FDFF, 0xB080799F, 0x5003FFCF },
+    { 0xFFF987EE, 0xD36DFDFF, 0x5E023987, 0x003FFFC0,
+      0xFFFBBFEE, 0xF3EDFDFF, 0x00013BBF, 0xFE00FFCF },
+    { 0xFFF99FEE, 0xF3EDFDFF, 0xB0E0399F, 0x0002FFCF,
+      0xD63DC7EC, 0xC3FFC718, 0x00813DC7, 0x0000FFC0 },
+    { 0xFFFDDFFF, 0xF3FFFDFF, 0x27603DDF, 0x0000FFCF,
+      0xFFFDDFEF, 0xF3EFFDFF, 0x60603DDF, 0x0006FFCF },
+    { 0xFFFDDFFF, 0xFFFFFFFF, 0x80F07DDF, 0xFC00FFCF,
+      0xFC7FFFEE, 0x2FFBFFFF, 0xFF5F847F, 0x000CFFC0 },
+    { 0xFFFFFFFE, 0x07FFFFFF, 0x03FF7FFF, 0x00000000,
+      0xFFFFF7D6, 0x3FFFFFAF, 0xF3FF3F5F, 0x00000000 },
+    { 0x03000001, 0xC2A003FF, 0xFFFFFEFF, 0xFFFE1FFF,
+      0xFEFFFFDF, 0x1FFFFFFF, 0x00000040, 0x00000000 },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFF03FF, 0xFFFFFFFF,
+      0x3FFFFFFF, 0xFFFFFFFF, 0xFFFF20BF, 0xF7FFFFFF },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0x3D7F3DFF, 0xFFFFFFFF,
+      0xFFFF3DFF, 0x7F3DFFFF, 0xFF7FFF3D, 0xFFFFFFFF },
+    { 0xFF3DFFFF, 0xFFFFFFFF, 0xE7FFFFFF, 0x00000000,
+      0x0000FFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0x3F3FFFFF },
+    { 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+      0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFF9FFF,
+      0x07FFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0x01FE07FF },
+    { 0x803FFFFF, 0x001FFFFF, 0x000FFFFF, 0x000DDFFF,
+      0xFFFFFFFF, 0xFFFFFFFF, 0x308FFFFF, 0x000003FF },
+    { 0x03FFB800, 0xFFFFFFFF, 0xFFFFFFFF, 0x01FFFFFF,
+      0xFFFFFFFF, 0xFFFF07FF, 0xFFFFFFFF, 0x003FFFFF },
+    { 0x7FFFFFFF, 0x0FFF0FFF, 0xFFFFFFC0, 0x001F3FFF,
+      0xFFFFFFFF, 0xFFFF0FFF, 0x03FF03FF, 0x00000000 },
+    { 0x0FFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF, 0x9FFFFFFF,
+      0x03FF03FF, 0xBFFF0080, 0x00007FFF, 0x00000000 },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0x03FF1FFF, 0x000FF800,
+      0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0x000FFFFF },
+    { 0xFFFFFFFF, 0x00FFFFFF, 0xFFFFE3FF, 0x3FFFFFFF,
+      0xFFFF01FF, 0xE7FFFFFF, 0xFFF70000, 0x07FFFFFF },
+    { 0x3F3FFFFF, 0xFFFFFFFF, 0xAAFF3F3F, 0x3FFFFFFF,
+      0xFFFFFFFF, 0x5FDFFFFF, 0x0FCF1FDC, 0x1FDC1FFF },
+    { 0x00000000, 0x80000000, 0x00100001, 0x80020000,
+      0x1FFF0000, 0x00000000, 0x1FFF0000, 0x0001FFE2 },
+    { 0x3E2FFC84, 0xF3FFBD50, 0x000043E0, 0x00000000,
+      0x00000018, 0x00000000, 0x00000000, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+      0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0x000FF81F },
+    { 0xFFFFFFFF, 0xFFFF20BF, 0xFFFFFFFF, 0x800080FF,
+      0x007FFFFF, 0x7F7F7F7F, 0x7F7F7F7F, 0xFFFFFFFF },
+    { 0x00000000, 0x00008000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { 0x00000060, 0x183EFC00, 0xFFFFFFFE, 0xFFFFFFFF,
+      0xE67FFFFF, 0xFFFFFFFE, 0xFFFFFFFF, 0xF7FFFFFF },
+    { 0xFFFFFFE0, 0xFFFEFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+      0x00007FFF, 0xFFFFFFFF, 0x00000000, 0xFFFF0000 },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+      0xFFFFFFFF, 0xFFFFFFFF, 0x00000000, 0x00000000 },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+      0x00001FFF, 0x00000000, 0xFFFF0000, 0x3FFFFFFF },
+    { 0xFFFF1FFF, 0x00000FFF, 0xFFFFFFFF, 0xBFF0FFFF,
+      0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0x0003003F },
+    { 0xFF800000, 0xFFFFFFFC, 0xFFFFFFFF, 0xFFFFFFFF,
+      0xFFFFF9FF, 0xFFFFFFFF, 0x03EB07FF, 0xFFFC0000 },
+    { 0xFFFFFFFF, 0x000010FF, 0xFFFFFFFF, 0x000FFFFF,
+      0xFFFFFFFF, 0xFFFFFFFF, 0x03FF003F, 0xE8FFFFFF },
+    { 0xFFFFFFFF, 0xFFFF3FFF, 0x000FFFFF, 0x1FFFFFFF,
+      0xFFFFFFFF, 0xFFFFFFFF, 0x03FF8001, 0x7FFFFFFF },
+    { 0xFFFFFFFF, 0x007FFFFF, 0x03FF3FFF, 0xFC7FFFFF,
+      0xFFFFFFFF, 0xFFFFFFFF, 0x38000007, 0x007CFFFF },
+    { 0x007E7E7E, 0xFFFF7F7F, 0xF7FFFFFF, 0xFFFF03FF,
+      0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0x03FF37FF },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+      0xFFFFFFFF, 0xFFFF000F, 0xFFFFF87F, 0x0FFFFFFF },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFF3FFF,
+      0xFFFFFFFF, 0xFFFFFFFF, 0x03FFFFFF, 0x00000000 },
+    { 0xE0F8007F, 0x5F7FFDFF, 0xFFFFFFDB, 0xFFFFFFFF,
+      0xFFFFFFFF, 0x0003FFFF, 0xFFF80000, 0xFFFFFFFF },
+    { 0xFFFFFFFF, 0x3FFFFFFF, 0xFFFF0000, 0xFFFFFFFF,
+      0xFFFCFFFF, 0xFFFFFFFF, 0x000000FF, 0x0FFF0000 },
+    { 0x0000FFFF, 0x0018FFFF, 0x0000E000, 0xFFDF0000,
+      0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0x1FFFFFFF },
+    { 0x03FF0000, 0x87FFFFFE, 0x07FFFFFE, 0xFFFFFFC0,
+      0xFFFFFFFF, 0x7FFFFFFF, 0x1CFCFCFC, 0x00000000 },
+    { 0xFFFFEFFF, 0xB7FFFF7F, 0x3FFF3FFF, 0x00000000,
+      0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0x07FFFFFF },
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x20000000 },
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x1FFFFFFF, 0xFFFFFFFF, 0x0001FFFF, 0x00000001 },
+    { 0xFFFFFFFF, 0xFFFFE000, 0xFFFF03FD, 0x07FFFFFF,
+      0x3FFFFFFF, 0xFFFFFFFF, 0x0000FF0F, 0x00000000 },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+      0x3FFFFFFF, 0xFFFF03FF, 0xFF0FFFFF, 0x0FFFFFFF },
+    { 0xFFFFFFFF, 0xFFFF00FF, 0xFFFFFFFF, 0xF7FF000F,
+      0xFFB7F7FF, 0x1BFBFFFB, 0x00000000, 0x00000000 },
+    { 0xFFFFFFFF, 0x007FFFFF, 0x003FFFFF, 0x000000FF,
+      0xFFFFFFBF, 0x07FDFFFF, 0x00000000, 0x00000000 },
+    { 0xFFFFFD3F, 0x91BFFFFF, 0x003FFFFF, 0x007FFFFF,
+      0x7FFFFFFF, 0x00000000, 0x00000000, 0x0037FFFF },
+    { 0x003FFFFF, 0x03FFFFFF, 0x00000000, 0x00000000,
+      0xFFFFFFFF, 0xC0FFFFFF, 0x00000000, 0x00000000 },
+    { 0xFEEFF06F, 0x873FFFFF, 0x00000000, 0x1FFFFFFF,
+      0x1FFFFFFF, 0x00000000, 0xFFFFFEFF, 0x0000007F },
+    { 0xFFFFFFFF, 0x003FFFFF, 0x003FFFFF, 0x0007FFFF,
+      0x0003FFFF, 0x00000000, 0x00000000, 0x00000000 },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0x000001FF, 0x00000000,
+      0xFFFFFFFF, 0x0007FFFF, 0xFFFFFFFF, 0x0007FFFF },
+    { 0xFFFFFFFF, 0x03FF00FF, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0xFFFFFFFF, 0x00031BFF, 0x00000000, 0x00000000 },
+    { 0x1FFFFFFF, 0xFFFF0080, 0x0001FFFF, 0xFFFF0000,
+      0x0000003F, 0xFFFF0000, 0x0000001F, 0x007FFFFF },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0x0000007F, 0x803FFFC0,
+      0xFFFFFFFF, 0x07FFFFFF, 0xFFFF0004, 0x03FF01FF },
+    { 0xFFFFFFFF, 0xFFDFFFFF, 0xFFFF00F0, 0x004FFFFF,
+      0xFFFFFFFF, 0xFFFFFFFF, 0x17FFDE1F, 0x00000000 },
+    { 0xFFFBFFFF, 0x40FFFFFF, 0x00000000, 0x00000000,
+      0xBFFFBD7F, 0xFFFF01FF, 0xFFFFFFFF, 0x03FF07FF },
+    { 0xFFF99FEF, 0xFBEDFDFF, 0xE081399F, 0x001F1FCF,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xC3FF07FF, 0x00000003,
+      0xFFFFFFFF, 0xFFFFFFFF, 0x03FF00BF, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0xFFFFFFFF, 0xFF3FFFFF, 0x3F000001, 0x00000000 },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0x03FF0011, 0x00000000,
+      0xFFFFFFFF, 0x01FFFFFF, 0x000003FF, 0x00000000 },
+    { 0xE7FFFFFF, 0x03FF0FFF, 0x0000007F, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { 0xFFFFFFFF, 0x07FFFFFF, 0x00000000, 0x00000000,
+      0x00000000, 0xFFFFFFFF, 0xFFFFFFFF, 0x800003FF },
+    { 0xFF6FF27F, 0xF9BFFFFF, 0x03FF000F, 0x00000000,
+      0x00000000, 0xFFFFFCFF, 0xFCFFFFFF, 0x0000001B },
+    { 0xFFFFFFFF, 0x7FFFFFFF, 0xFFFF0080, 0xFFFFFFFF,
+      0x23FFFFFF, 0xFFFF0000, 0xFFFFFFFF, 0x01FFFFFF },
+    { 0xFFFFFDFF, 0xFF7FFFFF, 0x03FF0001, 0xFFFC0000,
+      0xFFFCFFFF, 0x007FFEFF, 0x00000000, 0x00000000 },
+    { 0xFFFFFB7F, 0xB47FFFFF, 0x03FF00FF, 0xFFFFFDBF,
+      0x01FB7FFF, 0x000003FF, 0x00000000, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x007FFFFF },
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00010000, 0x00000000, 0x00000000 },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+      0x03FFFFFF, 0x00000000, 0x00000000, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0x0000000F, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0xFFFF0000, 0xFFFFFFFF, 0xFFFFFFFF, 0x0001FFFF },
+    { 0xFFFFFFFF, 0x00007FFF, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0x0000007F, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { 0xFFFFFFFF, 0x01FFFFFF, 0x7FFFFFFF, 0xFFFF03FF,
+      0xFFFFFFFF, 0x7FFFFFFF, 0xFFFF03FF, 0x001F3FFF },
+    { 0xFFFFFFFF, 0x007FFFFF, 0x03FF000F, 0xE0FFFFF8,
+      0x0000FFFF, 0x00000000, 0x00000000, 0x00000000 },
+    { 0x00000000, 0x00000000, 0xFFFFFFFF, 0xFFFFFFFF,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFF87FF, 0xFFFFFFFF,
+      0xFFFF80FF, 0x00000000, 0x00000000, 0x0003001B },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+      0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0x00FFFFFF },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+      0xFFFFFFFF, 0xFFFFFFFF, 0x003FFFFF, 0x00000000 },
+    { 0x000001FF, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x6FEF0000 },
+    { 0xFFFFFFFF, 0x00000007, 0x00070000, 0xFFFF00F0,
+      0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+      0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0x0FFFFFFF },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0x1FFF07FF,
+      0x63FF01FF, 0x00000000, 0x00000000, 0x00000000 },
+    { 0xFFFFFFFF, 0xFFFF3FFF, 0x0000007F, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x00000000, 0xF807E3E0,
+      0x00000FE7, 0x00003C00, 0x00000000, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x0000001C, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFDFFFFF, 0xFFFFFFFF,
+      0xDFFFFFFF, 0xEBFFDE64, 0xFFFFFFEF, 0xFFFFFFFF },
+    { 0xDFDFE7BF, 0x7BFFFFFF, 0xFFFDFC5F, 0xFFFFFFFF,
+      0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+      0xFFFFFFFF, 0xFFFFFF3F, 0xF7FFFFFD, 0xF7FFFFFF },
+    { 0xFFDFFFFF, 0xFFDFFFFF, 0xFFFF7FFF, 0xFFFF7FFF,
+      0xFFFFFDFF, 0xFFFFFDFF, 0xFFFFCFF7, 0xFFFFFFFF },
+    { 0xFFFFFFFF, 0xF87FFFFF, 0xFFFFFFFF, 0x00201FFF,
+      0xF8000010, 0x0000FFFE, 0x00000000, 0x00000000 },
+    { 0x7FFFFFFF, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { 0xF9FFFF7F, 0x000007DB, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { 0xFFFFFFFF, 0x3FFF1FFF, 0x000043FF, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0xFFFF0000, 0x00007FFF, 0xFFFFFFFF, 0x03FFFFFF },
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x7FFF6F7F },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+      0xFFFFFFFF, 0xFFFFFFFF, 0x007F001F, 0x00000000 },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0x03FF0FFF, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { 0xFFFFFFEF, 0x0AF7FE96, 0xAA96EA84, 0x5EF7F796,
+      0x0FFFFBFF, 0x0FFFFBEE, 0x00000000, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x03FF0000 },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+      0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0x00000000 },
+    { 0xFFFFFFFF, 0x01FFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+      0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF },
+    { 0x3FFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+      0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+      0xFFFFFFFF, 0xFFFF0003, 0xFFFFFFFF, 0xFFFFFFFF },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+      0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0x00000001 },
+    { 0x3FFFFFFF, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { 0xFFFFFFFF, 0xFFFFFFFF, 0x000007FF, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+};
+
+static const uint8_t uctype_space_index[1024] = {
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    4, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+};
+
+static const uint32_t uctype_space_blocks[5][8] = {
+    { 0x00003E00, 0x00000001, 0x00000000, 0x00000000,
+      0x00000020, 0x00000001, 0x00000000, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+      0x00000001, 0x00000000, 0x00000000, 0x00000000 },
+    { 0x000007FF, 0x00008300, 0x80000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+    { 0x00000001, 0x00000000, 0x00000000, 0x00000000,
+      0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+};
+
+#endif  // __TINY_STR_MATCH_INCLUDE_UCTYPE_TABLES_H__
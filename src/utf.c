@@ -1,5 +1,8 @@
+#include <string.h>
 #include "str_match.h"
 #include "utf.h"
+#include "uctype_tables.h"
+#include "casefold_tables.h"
 
 // Counts the binary size of an utf-8 character.
 int tsm_rune_size(const char *c) {
@@ -30,6 +33,25 @@ int tsm_rune_size(const char *c) {
     return 0;  // bad rune
 }
 
+// Counts the binary size of an utf-8 character in a buffer that has n bytes.
+int tsm_rune_size_n(const char *c, size_t n) {
+    const uint8_t first = *c;
+    size_t size;
+    if (first <= ASCII_MAX)
+        return 1;
+    else if (first <= MULTIBYTE_SEQ_MAX)
+        return 0;
+    else if (first <= TWO_BYTE_MAX)
+        size = 2;
+    else if (first <= THREE_BYTE_MAX)
+        size = 3;
+    else
+        size = 4;
+    if (size > n)
+        return 0;  // bad rune
+    return tsm_rune_size(c);
+}
+
 #define num_cmp(i, j) 2 * ((i) > (j)) - 1
 
 // Compares two utf-8 characters.
@@ -46,3 +68,210 @@ int tsm_rune_cmp(const char *c1, int size1, const char *c2, int size2) {
     }
     return 0;
 }
+
+// Checks if the first `size` bytes are valid utf-8 characters.
+int tsm_utf8_valid(const char *str, size_t size) {
+    size_t i = 0;
+    while (i < size) {
+        // Skip eight ASCII characters at once.
+        if (i + 8 <= size) {
+            uint64_t chunk;
+            memcpy(&chunk, str + i, 8);
+            if (!(chunk & 0x8080808080808080ULL)) {
+                i += 8;
+                continue;
+            }
+        }
+        int rs = tsm_rune_size_n(str + i, size - i);
+        if (!rs)
+            return 0;
+        i += rs;
+    }
+    return 1;
+}
+
+// Decodes an utf-8 character of the given size to a code point.
+uint32_t tsm_rune_decode(const char *c, int size) {
+    const uint8_t *u = (const uint8_t *)c;
+    switch (size) {
+        case 1: return u[0];
+        case 2: return ((uint32_t)(u[0] & 0x1F) << 6) | (u[1] & 0x3F);
+        case 3: return ((uint32_t)(u[0] & 0x0F) << 12) | ((uint32_t)(u[1] & 0x3F) << 6) |
+                       (u[2] & 0x3F);
+        default: return ((uint32_t)(u[0] & 0x07) << 18) | ((uint32_t)(u[1] & 0x3F) << 12) |
+                        ((uint32_t)(u[2] & 0x3F) << 6) | (u[3] & 0x3F);
+    }
+}
+
+// Decodes a character from code units of the given size (TSM_UNIT_*).
+int tsm_unit_decode(const void *str, size_t n, int unit, uint32_t *cp) {
+    int size;
+    switch (unit) {
+        case TSM_UNIT_UTF16:
+        {
+            const uint16_t *u = (const uint16_t *)str;
+            size = tsm_utf16_size(u, n);
+            if (size)
+                *cp = tsm_utf16_decode(u, size);
+            return size;
+        }
+        case TSM_UNIT_UTF32:
+            *cp = *(const uint32_t *)str;
+            return tsm_utf32_valid(*cp);
+        case TSM_UNIT_LATIN1:
+            *cp = *(const uint8_t *)str;
+            return 1;
+        default:
+            size = tsm_rune_size_n((const char *)str, n);
+            if (size)
+                *cp = tsm_rune_decode((const char *)str, size);
+            return size;
+    }
+}
+
+// Encodes code units of the given size (TSM_UNIT_*) to utf-8. Returns the binary size.
+size_t tsm_unit_to_utf8(const void *str, size_t len, int unit, char *out) {
+    const char *units = (const char *)str;
+    size_t i = 0, size = 0;
+    while (i < len) {
+        uint32_t cp;
+        int n = tsm_unit_decode(units + i * tsm_unit_width(unit), len - i, unit, &cp);
+        if (n) {
+            size += (size_t)tsm_rune_encode(cp, out + size);
+            i += (size_t)n;
+        } else {
+            out[size++] = (char)0xFF;
+            i++;
+        }
+    }
+    return size;
+}
+
+// Encodes a code point to utf-8. Returns the binary size.
+int tsm_rune_encode(uint32_t cp, char *buf) {
+    if (cp <= ASCII_MAX) {
+        buf[0] = (char)cp;
+        return 1;
+    }
+    if (cp <= 0x7FF) {
+        buf[0] = (char)(0xC0 | (cp >> 6));
+        buf[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp <= 0xFFFF) {
+        buf[0] = (char)(0xE0 | (cp >> 12));
+        buf[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        buf[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    buf[0] = (char)(0xF0 | (cp >> 18));
+    buf[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    buf[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    buf[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+const uint8_t tsm_ascii_lower[128] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F,
+    0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F,
+    0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F,
+    0x40, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F,
+    0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x5B, 0x5C, 0x5D, 0x5E, 0x5F,
+    0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x6B, 0x6C, 0x6D, 0x6E, 0x6F,
+    0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x7B, 0x7C, 0x7D, 0x7E, 0x7F,
+};
+
+// Finds the range that has a code point. Ranges are sorted and don't overlap.
+static uint32_t fold_lookup(const FoldRange *ranges, size_t count, uint32_t cp) {
+    size_t lo = 0, hi = count;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        const FoldRange *r = &ranges[mid];
+        if (cp < r->first) {
+            hi = mid;
+        } else if (cp > r->last) {
+            lo = mid + 1;
+        } else {
+            if ((cp - r->first) % r->stride == 0)
+                return (uint32_t)((int32_t)cp + r->delta);
+            break;
+        }
+    }
+    return cp;
+}
+
+#define COUNT_OF(a) (sizeof(a) / sizeof((a)[0]))
+
+uint32_t tsm_rune_tolower(uint32_t cp) {
+    if (cp <= ASCII_MAX)
+        return tsm_ascii_lower[cp];
+    return fold_lookup(casefold_lower, COUNT_OF(casefold_lower), cp);
+}
+
+uint32_t tsm_rune_toupper(uint32_t cp) {
+    if (cp <= ASCII_MAX)
+        return ('a' <= cp && cp <= 'z') ? cp - ('a' - 'A') : cp;
+    return fold_lookup(casefold_upper, COUNT_OF(casefold_upper), cp);
+}
+
+uint32_t tsm_rune_orbit(uint32_t cp) {
+    size_t lo = 0, hi = COUNT_OF(casefold_orbit);
+    uint32_t lower;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (cp == casefold_orbit[mid][0])
+            return casefold_orbit[mid][1];
+        if (cp < casefold_orbit[mid][0])
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    // Other classes have two characters.
+    lower = tsm_rune_tolower(cp);
+    return lower != cp ? lower : tsm_rune_toupper(cp);
+}
+
+#define D (TSM_CTYPE_DIGIT | TSM_CTYPE_WORD)
+#define W TSM_CTYPE_WORD
+#define S TSM_CTYPE_SPACE
+
+// Character types for ASCII characters. (same as the "C" locale)
+const uint8_t tsm_ascii_ctype[128] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, S, S, S, S, S, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    S, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    D, D, D, D, D, D, D, D, D, D, 0, 0, 0, 0, 0, 0,
+    0, W, W, W, W, W, W, W, W, W, W, W, W, W, W, W,
+    W, W, W, W, W, W, W, W, W, W, W, 0, 0, 0, 0, W,
+    0, W, W, W, W, W, W, W, W, W, W, W, W, W, W, W,
+    W, W, W, W, W, W, W, W, W, W, W, 0, 0, 0, 0, 0,
+};
+
+#undef D
+#undef W
+#undef S
+
+// Checks character types with Unicode properties.
+// TSM_CTYPE_DIGIT: Nd
+// TSM_CTYPE_WORD: L*, Mn, Mc, Nd, and Pc
+// TSM_CTYPE_SPACE: White_Space
+int tsm_uni_isctype(uint32_t cp, int type) {
+    const uint8_t *index;
+    const uint32_t (*blocks)[8];
+    if (cp <= ASCII_MAX)
+        return tsm_ascii_ctype[cp] & type;
+    if (cp >= UCTYPE_MAX_CP)
+        return 0;
+    if (type == TSM_CTYPE_DIGIT) {
+        index = uctype_digit_index;
+        blocks = uctype_digit_blocks;
+    } else if (type == TSM_CTYPE_WORD) {
+        index = uctype_word_index;
+        blocks = uctype_word_blocks;
+    } else {
+        index = uctype_space_index;
+        blocks = uctype_space_blocks;
+    }
+    return (blocks[index[cp >> 8]][(cp >> 5) & 7] >> (cp & 31)) & 1;
+}
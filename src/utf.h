@@ -1,6 +1,7 @@
 #ifndef __TINY_STR_MATCH_INCLUDE_UTF_H__
 #define __TINY_STR_MATCH_INCLUDE_UTF_H__
 
+#include <stddef.h>
 #include <stdint.h>
 
 #define ASCII_MAX 0x7F  // ascii 0x00 ~ 0x7F
@@ -21,12 +22,86 @@ extern "C" {
 // Counts the binary size of an utf-8 character.
 extern int tsm_rune_size(const char *c);
 
+// Counts the binary size of an utf-8 character in a buffer that has n bytes.
+extern int tsm_rune_size_n(const char *c, size_t n);
+
 // Compares two utf-8 characters.
 // -1 when c1 < c2
 //  0 when c1 == c2
 //  1 when c1 > c2
 extern int tsm_rune_cmp(const char *c1, int size1, const char *c2, int size2);
 
+// Checks if the first `size` bytes are valid utf-8 characters.
+extern int tsm_utf8_valid(const char *str, size_t size);
+
+// Decodes an utf-8 character of the given size to a code point.
+extern uint32_t tsm_rune_decode(const char *c, int size);
+
+// Code unit sizes of encodings. Latin-1 has one-byte units.
+#define TSM_UNIT_UTF8 1
+#define TSM_UNIT_UTF16 2
+#define TSM_UNIT_LATIN1 3
+#define TSM_UNIT_UTF32 4
+
+#define tsm_unit_width(unit) ((unit) == TSM_UNIT_LATIN1 ? 1 : (size_t)(unit))
+
+#define is_low_surrogate(u) (((u) & 0xFC00) == 0xDC00)
+
+// Counts code units of an utf-16 character in a buffer that has n units.
+// Returns zero for unpaired surrogates.
+#define tsm_utf16_size(c, n) \
+    (((c)[0] & 0xF800) != 0xD800 ? 1 \
+     : ((c)[0] < 0xDC00 && (n) >= 2 && is_low_surrogate((c)[1])) ? 2 : 0)
+
+// Decodes an utf-16 character of the given size to a code point.
+#define tsm_utf16_decode(c, size) \
+    ((size) == 1 ? (uint32_t)(c)[0] \
+                 : 0x10000 + (((uint32_t)(c)[0] - 0xD800) << 10) + ((c)[1] - 0xDC00))
+
+// Checks if an utf-32 code unit is a valid character (not a surrogate and not too large.)
+#define tsm_utf32_valid(u) ((u) < 0xD800 || (0xE000 <= (u) && (u) <= 0x10FFFF))
+
+// Decodes a character from code units of the given size (TSM_UNIT_*).
+// n is the number of units in the buffer. Returns the number of units, or zero for bad sequences.
+extern int tsm_unit_decode(const void *str, size_t n, int unit, uint32_t *cp);
+
+// Encodes code units of the given size (TSM_UNIT_*) to utf-8. Returns the binary size.
+// Bad sequences become 0xFF, which is invalid in utf-8. The buffer should have len * 4 bytes.
+extern size_t tsm_unit_to_utf8(const void *str, size_t len, int unit, char *out);
+
+// Encodes a code point to utf-8. Returns the binary size.
+// The buffer should have four bytes at least.
+extern int tsm_rune_encode(uint32_t cp, char *buf);
+
+// Simple case folding (CaseFolding.txt status C and S), and the uppercase of folded characters.
+// Characters without case are returned as-is.
+extern uint32_t tsm_rune_tolower(uint32_t cp);
+extern uint32_t tsm_rune_toupper(uint32_t cp);
+
+// Returns the next character of the same case class, such as k -> K -> U+212A (Kelvin) -> k.
+// Characters without case are returned as-is.
+extern uint32_t tsm_rune_orbit(uint32_t cp);
+
+// ASCII lowercase table.
+extern const uint8_t tsm_ascii_lower[128];
+
+// Character types
+#define TSM_CTYPE_DIGIT 0x01  // [0-9]
+#define TSM_CTYPE_WORD 0x02  // [a-zA-Z0-9_]
+#define TSM_CTYPE_SPACE 0x04  // [\t\n\v\f\r ]
+
+// Character types for ASCII characters.
+extern const uint8_t tsm_ascii_ctype[128];
+
+// Checks character types with Unicode properties.
+// Returns non-zero when the code point has the type.
+extern int tsm_uni_isctype(uint32_t cp, int type);
+
+// Lowercases an utf-8 character without decoding ASCII characters.
+#define tsm_rune_fold(c, size) \
+    ((size) == 1 ? (uint32_t)tsm_ascii_lower[(uint8_t)*(c) & ASCII_MAX] \
+                 : tsm_rune_tolower(tsm_rune_decode((c), (size))))
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,365 @@
+/*
+ * Backtracking VM for the regex bytecode. (See vm.h)
+ *
+ * Instructions are dispatched with computed goto on GCC and Clang,
+ * and with a switch statement on other compilers.
+ * Define TSM_VM_NO_COMPUTED_GOTO to use the switch statement anyway.
+ *
+ * Each instruction pushes at most one frame,
+ * and frames are updated in place while backtracking into repetitions.
+ * Jumps only go forward, so the stack never gets deeper than the program.
+ * Boolean tests stop where the rest of the program can match the empty string,
+ * and try the fewest repetitions after the most, since any match will do.
+ *
+ * The loop is instantiated for utf-8, bytes (TSM_FLAG_BYTES), utf-16, and utf-32 strings.
+ * Repetitions jump over runs of matching bytes with span scanners in utf-8 and bytes.
+ * Programs compiled to machine code run it for utf-8 and bytes instead. (See jit.h)
+ */
+
+#include <string.h>
+#include "str_match.h"
+#include "utf.h"
+#include "re.h"
+#include "vm.h"
+#include "jit.h"
+
+#if defined(__GNUC__) && !defined(TSM_VM_NO_COMPUTED_GOTO)
+#define VM_COMPUTED_GOTO
+#endif
+
+typedef struct vm_frame_t {
+    const void* text;  /* where to resume */
+    const void* low;   /* VM_STAR and VM_PLUS: where the repetition started */
+    uint32_t count;    /* VM_RANGE: number of repetitions */
+    int pc;            /* the instruction that pushed the frame */
+} vm_frame_t;
+
+/* Counts the binary size of an utf-8 character. The end of the text acts as '\0'. */
+static int runesize(const char* text, const char* end) {
+    if (text >= end)
+        return 1;
+    return tsm_rune_size_n(text, (size_t)(end - text));
+}
+
+static void set_atom(vm_inst_t* inst, const regex_t* objs, int idx) {
+    int i;
+    char c;
+    for (i = 0; i <= ASCII_MAX; i++) {
+        c = (char)i;
+        if (re_matchone(&objs[idx], &c, 1))
+            inst->ascii[i >> 5] |= (uint32_t)1 << (i & 31);
+    }
+    inst->mb = (uint8_t)re_multibyte(&objs[idx]);
+    inst->obj = (uint8_t)idx;
+}
+
+#define nullable(prog, pc) (((prog)->nullable >> (pc)) & 1)
+
+int vm_compile(vm_prog_t* prog, const regex_t* objs) {
+    vm_inst_t* insts = prog->insts;
+    int i = 0, b, pc;
+
+    memset(prog, 0, sizeof(vm_prog_t));
+    prog->bytes = (objs[0].flags & RE_BYTES) != 0;
+    prog->branch_count = 1;
+    for (i = 0; objs[i].type != UNUSED; i++) {
+        if (objs[i].type == BRANCH)
+            prog->branch_count++;
+    }
+
+    /* SPLITs try the branches in order. */
+    pc = prog->branch_count - 1;
+    i = 0;
+    prog->anchored = 1;
+    for (b = 0; b < prog->branch_count; b++) {
+        prog->entries[b] = (uint8_t)pc;
+        if (objs[i].type == BEGIN) {
+            insts[pc++].op = VM_BEGIN;
+            i++;
+        } else {
+            prog->anchored = 0;
+        }
+        while (objs[i].type != UNUSED && objs[i].type != BRANCH) {
+            int atom = i;
+            vm_inst_t* inst = &insts[pc++];
+            if (pc >= VM_MAX_INSTS)
+                return 0;
+            if (objs[i].type == END) {
+                if (objs[i + 1].type != UNUSED && objs[i + 1].type != BRANCH)
+                    return 0;  /* '$' never matches here. */
+                inst->op = VM_END;
+                i++;
+                continue;
+            }
+            if (!re_isatom(objs[i].type))
+                return 0;  /* misplaced anchors, or quantifiers without atoms */
+
+            i++;
+            inst->possessive = (uint8_t)((objs[i].flags & RE_POSSESSIVE) != 0);
+            switch (objs[i].type) {
+                case QUESTIONMARK: inst->op = VM_QUEST; i++; break;
+                case STAR:         inst->op = VM_STAR;  i++; break;
+                case PLUS:         inst->op = VM_PLUS;  i++; break;
+                case TIMES:
+                    inst->op = VM_RANGE;
+                    inst->x = objs[i].u.times.n;
+                    inst->y = objs[i].u.times.m;
+                    i++;
+                    break;
+                default:
+                    if (objs[atom].type == CHAR && objs[atom].ch_size == 1) {
+                        inst->op = VM_CHAR;
+                        inst->ch = objs[atom].u.ch[0];
+                        inst->obj = (uint8_t)atom;
+                        continue;
+                    }
+                    inst->op = VM_CLASS;
+                    break;
+            }
+            set_atom(inst, objs, atom);
+        }
+        if (objs[i].type == BRANCH) {
+            insts[pc++].op = VM_JMP;  /* the target is set below */
+            i++;
+        }
+    }
+    insts[pc].op = VM_MATCH;
+    prog->len = pc + 1;
+
+    for (b = 0; b < prog->branch_count - 1; b++) {
+        insts[b].op = VM_SPLIT;
+        insts[b].x = prog->entries[b];
+        insts[b].y = (uint16_t)(b + 1 < prog->branch_count - 1 ? b + 1 : prog->entries[b + 1]);
+    }
+    for (b = 0; b < pc; b++) {
+        if (insts[b].op == VM_JMP)
+            insts[b].x = (uint16_t)pc;
+    }
+
+    /* Jumps only go forward, so later instructions are known first. */
+    for (b = pc; b >= 0; b--) {
+        const vm_inst_t* inst = &insts[b];
+        int empty;
+        switch (inst->op) {
+            case VM_MATCH: empty = 1; break;
+            case VM_QUEST:
+            case VM_STAR:  empty = nullable(prog, b + 1); break;
+            case VM_RANGE: empty = inst->x == 0 && nullable(prog, b + 1); break;
+            case VM_JMP:   empty = nullable(prog, inst->x); break;
+            case VM_SPLIT: empty = nullable(prog, inst->x) || nullable(prog, inst->y); break;
+            default:       empty = 0; break;  /* characters and anchors */
+        }
+        if (empty)
+            prog->nullable |= (uint64_t)1 << b;
+    }
+    return 1;
+}
+
+static int test(const vm_inst_t* inst, const regex_t* objs, const char* c, int c_size) {
+    if (c_size == 1)
+        return (inst->ascii[(uint8_t)*c >> 5] >> (*c & 31)) & 1;
+    if (inst->mb == RE_MB_TEST)
+        return re_matchone(&objs[inst->obj], c, c_size);
+    return inst->mb == RE_MB_ANY;
+}
+
+/* Tests a decoded character. Regex objects take utf-8, so it's encoded again. */
+static int test_cp(const vm_inst_t* inst, const regex_t* objs, uint32_t cp) {
+    char buf[4];
+    if (cp <= ASCII_MAX)
+        return (inst->ascii[cp >> 5] >> (cp & 31)) & 1;
+    if (inst->mb == RE_MB_TEST)
+        return re_matchone(&objs[inst->obj], buf, tsm_rune_encode(cp, buf));
+    return inst->mb == RE_MB_ANY;
+}
+
+/* Scans a run of single-byte characters that match the atom. */
+static size_t span(const vm_prog_t* prog, const vm_inst_t* inst,
+                   const char* text, const char* end) {
+    const span_t* sp;
+    if (!prog->spans)
+        return 0;
+    sp = &prog->spans[inst->obj];
+    return sp->kind == SPAN_NONE ? 0 : span_scan(sp, text, end);
+}
+
+/* Profiling event for testing the atom of inst at text. */
+#define VM_STEP(inst, text) PROF_STEP(prof, (inst)->obj, (size_t)((text) - begin))
+
+/* Checks if {n,m} allows more repetitions than count. */
+#define below_max(inst, count) ((inst)->y == MAX_USHORT || (count) < (inst)->y)
+
+#ifdef VM_COMPUTED_GOTO
+/* Labels as values are a GNU extension. */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#define TARGET(op) L_##op:
+#define DISPATCH() do { \
+        if ((accepts >> pc) & 1) goto matched; \
+        inst = &insts[pc]; \
+        goto *labels[inst->op]; \
+    } while (0)
+#else
+#define TARGET(op) case op:
+#define DISPATCH() goto dispatch
+#endif
+
+/* Moves to the next character. The backtracker fails on invalid characters. */
+#define NEXT_RUNE() do { \
+        size = VM_SIZE(text, end); \
+        if (!size) goto fail; \
+        pc++; \
+        DISPATCH(); \
+    } while (0)
+
+#define PUSH(text_, low_, count_) do { \
+        stack[sp].text = (text_); \
+        stack[sp].low = (low_); \
+        stack[sp].count = (count_); \
+        stack[sp].pc = pc; \
+        sp++; \
+    } while (0)
+
+#define VM_RUN run
+#define VM_UNIT char
+#define VM_SIZE(text, end) runesize(text, end)
+#define VM_TEST(inst, c, size) test(inst, objs, c, size)
+#define VM_IS_CONT(unit) is_multibyte_seq(unit)
+#define VM_SPAN(inst, text, end) span(prog, inst, text, end)
+#include "vm_run.h"
+
+#define VM_RUN run_bytes
+#define VM_UNIT char
+#define VM_SIZE(text, end) 1
+#define VM_TEST(inst, c, size) test_cp(inst, objs, (uint8_t)*(c))
+#define VM_IS_CONT(unit) 0
+#define VM_SPAN(inst, text, end) span(prog, inst, text, end)
+#include "vm_run.h"
+
+#define VM_RUN run_utf16
+#define VM_UNIT uint16_t
+#define VM_SIZE(text, end) ((text) >= (end) ? 1 : tsm_utf16_size(text, (size_t)((end) - (text))))
+#define VM_TEST(inst, c, size) test_cp(inst, objs, tsm_utf16_decode(c, size))
+#define VM_IS_CONT(unit) is_low_surrogate(unit)
+#define VM_SPAN(inst, text, end) 0
+#include "vm_run.h"
+
+#define VM_RUN run_utf32
+#define VM_UNIT uint32_t
+#define VM_SIZE(text, end) ((text) >= (end) || tsm_utf32_valid(*(text)))
+#define VM_TEST(inst, c, size) test_cp(inst, objs, *(c))
+#define VM_IS_CONT(unit) 0
+#define VM_SPAN(inst, text, end) 0
+#include "vm_run.h"
+
+#ifdef VM_COMPUTED_GOTO
+#pragma GCC diagnostic pop
+#endif
+
+/* Same as vm_search(). Early searches only check if there's a match. */
+static int search(const vm_prog_t* prog, const regex_t* objs,
+                  const char* begin, const char* end, const char* from, const char* limit,
+                  int early, const char** match, size_t* matchlength) {
+    const char* text;
+    const char* match_end;
+    int res = 0;
+    PROF_LOCAL(prof, prog->stats, begin);
+    for (text = from; text < limit || text == end; ) {
+        int size = prog->bytes ? 1 : runesize(text, end);
+        int found;
+        if (!size) {
+            res = -1;
+            break;
+        }
+        PROF_START(&prof, (size_t)(text - begin));
+        /* SPLITs try all branches at the same position to get the leftmost match. */
+        if (prog->jit)
+            found = jit_run(prog->jit, begin, end, text, 0, &match_end);
+        else if (prog->bytes)
+            found = run_bytes(prog, objs, begin, end, text, 0, 0, early,
+                              &match_end PROF_ARG(&prof));
+        else
+            found = run(prog, objs, begin, end, text, 0, 0, early,
+                        &match_end PROF_ARG(&prof));
+        if (found) {
+            *match = text;
+            *matchlength = (size_t)(match_end - text);
+            res = 1;
+            break;
+        }
+        if (text == end || prog->anchored)
+            break;
+        text += size;
+    }
+    PROF_COMMIT(prof, prog->stats);
+    return res;
+}
+
+int vm_exec(const vm_prog_t* prog, const regex_t* objs, const char* text) {
+    const char* end = text + strlen(text);
+    const char* match;
+    size_t matchlength;
+    return search(prog, objs, text, end, text, end, 1, &match, &matchlength) == 1;
+}
+
+int vm_fullmatch(const vm_prog_t* prog, const regex_t* objs, const char* text) {
+    const char* end = text + strlen(text);
+    const char* match_end;
+    int found;
+    PROF_LOCAL(prof, prog->stats, text);
+    PROF_START(&prof, 0);
+    if (prog->jit)
+        found = (prog->bytes || runesize(text, end)) &&
+                jit_run(prog->jit, text, end, text, 1, &match_end);
+    else if (prog->bytes)
+        found = run_bytes(prog, objs, text, end, text, 0, 1, 0, &match_end PROF_ARG(&prof));
+    else
+        found = runesize(text, end) &&
+                run(prog, objs, text, end, text, 0, 1, 0, &match_end PROF_ARG(&prof));
+    PROF_COMMIT(prof, prog->stats);
+    return found;
+}
+
+int vm_exec_utf16(const vm_prog_t* prog, const regex_t* objs, const uint16_t* text, size_t len) {
+    const uint16_t* end = text + len;
+    const uint16_t* p;
+    const uint16_t* match_end;
+    int found = 0;
+    PROF_LOCAL(prof, prog->stats, text);
+    for (p = text; ; ) {
+        int size = p == end ? 1 : tsm_utf16_size(p, (size_t)(end - p));
+        if (!size)
+            break;
+        PROF_START(&prof, (size_t)(p - text));
+        found = run_utf16(prog, objs, text, end, p, 0, 0, 1, &match_end PROF_ARG(&prof));
+        if (found || p == end || prog->anchored)
+            break;
+        p += size;
+    }
+    PROF_COMMIT(prof, prog->stats);
+    return found;
+}
+
+int vm_exec_utf32(const vm_prog_t* prog, const regex_t* objs, const uint32_t* text, size_t len) {
+    const uint32_t* end = text + len;
+    const uint32_t* p;
+    const uint32_t* match_end;
+    int found = 0;
+    PROF_LOCAL(prof, prog->stats, text);
+    for (p = text; ; p++) {
+        if (p != end && !tsm_utf32_valid(*p))
+            break;
+        PROF_START(&prof, (size_t)(p - text));
+        found = run_utf32(prog, objs, text, end, p, 0, 0, 1, &match_end PROF_ARG(&prof));
+        if (found || p == end || prog->anchored)
+            break;
+    }
+    PROF_COMMIT(prof, prog->stats);
+    return found;
+}
+
+int vm_search(const vm_prog_t* prog, const regex_t* objs,
+              const char* begin, const char* end, const char* from, const char* limit,
+              const char** match, size_t* matchlength) {
+    return search(prog, objs, begin, end, from, limit, 0, match, matchlength);
+}
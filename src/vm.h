@@ -0,0 +1,100 @@
+/*
+ * Bytecode for regex patterns.
+ *
+ * Each regex object compiles to an instruction with precomputed operands.
+ * Quantifiers are fused with their atoms, so the matching loop doesn't look ahead
+ * at the next object to decode them.
+ *
+ *   "ab*|^c$"   0: SPLIT 1, 4
+ *               1: CHAR  'a'
+ *               2: STAR  [b]
+ *               3: JMP   7
+ *               4: BEGIN
+ *               5: CHAR  'c'
+ *               6: END
+ *               7: MATCH
+ *
+ * The VM backtracks in the same order as the backtracker (See re.c),
+ * so it returns the same matches even for invalid utf-8 strings.
+ *
+ */
+
+#ifndef __TINY_STR_MATCH_INCLUDE_VM_H__
+#define __TINY_STR_MATCH_INCLUDE_VM_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Objects and branches, a JMP for each branch, and MATCH */
+#define VM_MAX_INSTS 64
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    VM_CHAR,    /* an ASCII character */
+    VM_CLASS,   /* an atom */
+    VM_QUEST,   /* atom? (non-greedy) */
+    VM_STAR,    /* atom* (greedy) */
+    VM_PLUS,    /* atom+ (greedy) */
+    VM_RANGE,   /* atom{n,m} (lazy) */
+    VM_BEGIN,   /* assertion for '^' */
+    VM_END,     /* assertion for '$' */
+    VM_SPLIT,   /* try x, then y */
+    VM_JMP,     /* go to x */
+    VM_MATCH,
+    VM_OP_COUNT,
+};
+
+typedef struct vm_inst_t {
+    uint8_t op;
+    uint8_t mb;        /* how the atom matches multi-byte characters (RE_MB_*) */
+    uint8_t obj;       /* regex object of the atom */
+    uint8_t ch;        /* the character of VM_CHAR */
+    uint8_t possessive;  /* VM_QUEST, VM_STAR, VM_PLUS, and VM_RANGE never give characters back */
+    uint16_t x, y;     /* {n,m} for VM_RANGE, or targets for VM_SPLIT and VM_JMP */
+    uint32_t ascii[4];  /* bitmap for ASCII characters that match the atom */
+} vm_inst_t;
+
+typedef struct vm_prog_t {
+    vm_inst_t insts[VM_MAX_INSTS];
+    int len;  /* zero when the pattern isn't supported */
+    uint8_t entries[VM_MAX_INSTS];  /* the first instruction of each branch */
+    int branch_count;
+    int anchored;  /* all branches start with '^' */
+    uint64_t nullable;  /* bit pc: MATCH can be reached from pc without characters */
+    int bytes;     /* each byte is a Latin-1 character (RE_BYTES) */
+    const struct span_t* spans;  /* scanners for each regex object, or NULL */
+    struct jit_code_t* jit;      /* machine code of the program, or NULL (See jit.h) */
+#ifdef TSM_PROFILE
+    struct re_stats_t* stats;  /* counters of the pattern */
+#endif
+} vm_prog_t;
+
+/* Compiles regex objects. Returns zero for patterns that only the backtracker supports. */
+struct regex_t;
+int vm_compile(vm_prog_t* prog, const struct regex_t* objs);
+
+/* Checks if the text has the pattern. It stops at the first accepting state. */
+int vm_exec(const vm_prog_t* prog, const struct regex_t* objs, const char* text);
+
+/* Checks if the whole text matches the pattern. */
+int vm_fullmatch(const vm_prog_t* prog, const struct regex_t* objs, const char* text);
+
+/* Checks if utf-16 or utf-32 text has the pattern like vm_exec(). */
+int vm_exec_utf16(const vm_prog_t* prog, const struct regex_t* objs,
+                  const uint16_t* text, size_t len);
+int vm_exec_utf32(const vm_prog_t* prog, const struct regex_t* objs,
+                  const uint32_t* text, size_t len);
+
+/* Same as re_search() in re.h */
+int vm_search(const vm_prog_t* prog, const struct regex_t* objs,
+              const char* begin, const char* end, const char* from, const char* limit,
+              const char** match, size_t* matchlength);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __TINY_STR_MATCH_INCLUDE_VM_H__
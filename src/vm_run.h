@@ -0,0 +1,288 @@
+/*
+ * The matching loop of the VM. (See vm.c)
+ *
+ * vm.c includes this file for each code unit type. Define these macros before including it.
+ *
+ *   VM_RUN                   name of the function
+ *   VM_UNIT                  type of code units
+ *   VM_SIZE(text, end)       number of units of the character at text.
+ *                            One at the end, and zero for invalid characters.
+ *   VM_TEST(inst, c, size)   checks if the atom of inst matches the character.
+ *   VM_IS_CONT(unit)         checks if a unit continues a character.
+ *   VM_SPAN(inst, text, end) number of units from text that are single characters
+ *                            matching the atom of inst. (See span.h)
+ *
+ * The function runs the program from pc at text. The text should start with a valid character.
+ * Full matches should reach the end of the text.
+ * Early runs only check if there's a match. They stop where the rest of the program can be empty,
+ * and match_end isn't the end of the leftmost match.
+ * With TSM_PROFILE, it also takes counters of the attempt. (See profile.h)
+ */
+
+static int VM_RUN(const vm_prog_t* prog, const regex_t* objs,
+                  const VM_UNIT* begin, const VM_UNIT* end,
+                  const VM_UNIT* text, int pc, int full, int early, const VM_UNIT** match_end
+                  PROF_PARAM) {
+    const vm_inst_t* insts = prog->insts;
+    const uint64_t accepts = early ? prog->nullable : 0;
+    const vm_inst_t* inst;
+    vm_frame_t stack[VM_MAX_INSTS];
+    int sp = 0;
+    int size = VM_SIZE(text, end);
+    const VM_UNIT* low;
+    uint32_t count;
+    size_t run, reps;
+#ifdef VM_COMPUTED_GOTO
+    static const void* const labels[VM_OP_COUNT] = {
+        [VM_CHAR] = &&L_VM_CHAR, [VM_CLASS] = &&L_VM_CLASS,
+        [VM_QUEST] = &&L_VM_QUEST, [VM_STAR] = &&L_VM_STAR,
+        [VM_PLUS] = &&L_VM_PLUS, [VM_RANGE] = &&L_VM_RANGE,
+        [VM_BEGIN] = &&L_VM_BEGIN, [VM_END] = &&L_VM_END,
+        [VM_SPLIT] = &&L_VM_SPLIT, [VM_JMP] = &&L_VM_JMP, [VM_MATCH] = &&L_VM_MATCH,
+    };
+    DISPATCH();
+#else
+dispatch:
+    if ((accepts >> pc) & 1)
+        goto matched;
+    inst = &insts[pc];
+    switch (inst->op) {
+#endif
+    TARGET(VM_CHAR)
+        VM_STEP(inst, text);
+        if (text == end || *text != (VM_UNIT)inst->ch)
+            goto fail;
+        text++;
+        NEXT_RUNE();
+
+    TARGET(VM_CLASS)
+        VM_STEP(inst, text);
+        if (text == end || !VM_TEST(inst, text, size))
+            goto fail;
+        text += size;
+        NEXT_RUNE();
+
+    TARGET(VM_QUEST)
+        if (inst->possessive) {
+            /* Take the atom if it matches, and keep it. */
+            if (text != end) {
+                VM_STEP(inst, text);
+                if (VM_TEST(inst, text, size) && VM_SIZE(text + size, end)) {
+                    text += size;
+                    size = VM_SIZE(text, end);
+                }
+            }
+            pc++;
+            DISPATCH();
+        }
+        /* Try without the atom first. */
+        PUSH(text, NULL, 0);
+        pc++;
+        DISPATCH();
+
+    TARGET(VM_STAR)
+    TARGET(VM_PLUS)
+        low = text;
+        while (text != end) {
+            VM_STEP(inst, text);
+            run = VM_SPAN(inst, text, end);
+            if (run)
+                text += run;
+            else if (VM_TEST(inst, text, size))
+                text += size;
+            else
+                break;
+            size = VM_SIZE(text, end);
+            if (!size) {
+                /* The backtracker gives up all the repetitions here. */
+                if (inst->op == VM_PLUS)
+                    goto fail;
+                text = low;
+                size = VM_SIZE(text, end);
+                break;
+            }
+        }
+        if (text == low) {
+            if (inst->op == VM_PLUS)
+                goto fail;
+        } else if (!inst->possessive) {
+            PUSH(text, low, 0);
+        }
+        pc++;
+        DISPATCH();
+
+    TARGET(VM_RANGE)
+        if (inst->possessive) {
+            /* As many repetitions as possible up to m */
+            low = text;
+            reps = 0;
+            while (text != end && (inst->y == MAX_USHORT || reps < inst->y)) {
+                VM_STEP(inst, text);
+                run = VM_SPAN(inst, text, end);
+                if (run) {
+                    if (inst->y != MAX_USHORT && run > inst->y - reps)
+                        run = inst->y - reps;
+                    text += run;
+                    reps += run;
+                } else if (VM_TEST(inst, text, size)) {
+                    text += size;
+                    reps++;
+                } else {
+                    break;
+                }
+                size = VM_SIZE(text, end);
+                if (!size) {
+                    /* Give up all the repetitions like VM_STAR does. */
+                    text = low;
+                    size = VM_SIZE(text, end);
+                    reps = 0;
+                    break;
+                }
+            }
+            if (reps < inst->x)
+                goto fail;
+            pc++;
+            DISPATCH();
+        }
+        count = 0;
+        run = inst->x ? VM_SPAN(inst, text, end) : 0;
+        if (run) {
+            VM_STEP(inst, text);
+            count = run < inst->x ? (uint32_t)run : inst->x;
+            text += count;
+            size = VM_SIZE(text, end);
+            if (!size)
+                goto fail;
+        }
+        for (; count < inst->x; count++) {
+            if (text == end || !below_max(inst, count))
+                goto fail;
+            VM_STEP(inst, text);
+            if (!VM_TEST(inst, text, size))
+                goto fail;
+            text += size;
+            size = VM_SIZE(text, end);
+            if (!size)
+                goto fail;
+        }
+        PUSH(text, NULL, count);
+        pc++;
+        DISPATCH();
+
+    TARGET(VM_BEGIN)
+        if (text != begin)
+            goto fail;
+        pc++;
+        DISPATCH();
+
+    TARGET(VM_END)
+        if (text != end)
+            goto fail;
+        pc++;
+        DISPATCH();
+
+    TARGET(VM_SPLIT)
+        PUSH(text, NULL, 0);
+        pc = inst->x;
+        DISPATCH();
+
+    TARGET(VM_JMP)
+        pc = inst->x;
+        DISPATCH();
+
+    TARGET(VM_MATCH)
+        if (full && text != end)
+            goto fail;
+    matched:
+        *match_end = text;
+        return 1;
+#ifndef VM_COMPUTED_GOTO
+    }
+#endif
+
+fail:
+    while (sp > 0) {
+        vm_frame_t* f = &stack[sp - 1];
+        pc = f->pc;
+        inst = &insts[pc];
+        text = (const VM_UNIT*)f->text;
+        size = VM_SIZE(text, end);
+        if (inst->op != VM_SPLIT)
+            PROF_BACKTRACK(prof, inst->obj, (size_t)(text - begin));
+        switch (inst->op) {
+            case VM_SPLIT:
+                sp--;
+                pc = inst->y;
+                DISPATCH();
+            case VM_QUEST:
+                /* Then with the atom. */
+                sp--;
+                if (text == end)
+                    continue;
+                VM_STEP(inst, text);
+                if (!VM_TEST(inst, text, size))
+                    continue;
+                text += size;
+                NEXT_RUNE();
+            case VM_RANGE:
+                /* One more repetition. */
+                sp--;
+                count = f->count;
+                if (text == end || !below_max(inst, count))
+                    continue;
+                VM_STEP(inst, text);
+                if (!VM_TEST(inst, text, size))
+                    continue;
+                text += size;
+                size = VM_SIZE(text, end);
+                if (!size)
+                    continue;
+                PUSH(text, NULL, count + 1);
+                pc++;
+                DISPATCH();
+            default:
+                /* VM_STAR and VM_PLUS: one less repetition. */
+                low = (const VM_UNIT*)f->low;
+                if (early) {
+                    /* After the most repetitions, try the fewest first.
+                     * Then the frame keeps the end of the longest run in low and counts 1. */
+                    if (!f->count) {
+                        f->count = 1;
+                        f->low = text;
+                        text = inst->op == VM_PLUS ? low + VM_SIZE(low, end) : low;
+                    } else {
+                        text += size;
+                    }
+                    if (text >= (const VM_UNIT*)f->low) {
+                        sp--;
+                        continue;
+                    }
+                    f->text = text;
+                    size = VM_SIZE(text, end);
+                    pc++;
+                    DISPATCH();
+                }
+                do {
+                    text--;
+                } while (text > low && VM_IS_CONT(*text));
+                if (text == low) {
+                    sp--;
+                    if (inst->op == VM_PLUS)
+                        continue;
+                } else {
+                    f->text = text;
+                }
+                size = VM_SIZE(text, end);
+                pc++;
+                DISPATCH();
+        }
+    }
+    return 0;
+}
+
+#undef VM_RUN
+#undef VM_UNIT
+#undef VM_SIZE
+#undef VM_TEST
+#undef VM_IS_CONT
+#undef VM_SPAN
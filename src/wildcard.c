@@ -7,12 +7,94 @@
  *   '*'        Asterisk, matches zero or more
  *   '?'        Question, matches any character.
  *
+ * Compiled patterns are split into segments by '*'.
+ * The first and last segments are matched at the ends of the string,
+ * and the others are searched from left to right with the bit-parallel engine.
+ *
+ * Compiled patterns also have a small automaton for paths (TSM_FLAG_PATH).
+ *   '*', '?'   don't match '/'.
+ *   '**'       matches any characters including '/'.
+ *   '**' + '/' matches zero or more directories at the beginning or after '/'.
+ * The automaton keeps a set of active states, so it can also tell
+ * if any path under a directory can match the pattern.
+ * It also matches utf-16 and utf-32 strings without converting them first.
+ *
+ * With TSM_FLAG_BYTES, each byte of patterns and strings is a Latin-1 character.
+ * Patterns are stored as utf-8, and strings are read one byte at a time without validation.
+ *
  */
 
+#include <string.h>
 #include "str_match.h"
 #include "utf.h"
+#include "bitpar.h"
+
+// A part of a pattern separated by '*'.
+typedef struct {
+    size_t offset;  // offset in the pattern
+    size_t size;    // binary size
+    size_t runes;   // number of characters
+    int first_bit;  // positions for the bit-parallel search
+    int last_bit;
+} WcSegment;
+
+// States of the path automaton.
+enum {
+    WC_CHAR,       // a character
+    WC_ANY,        // '?' (not '/' with TSM_FLAG_PATH)
+    WC_ANY_ALL,    // '?' without TSM_FLAG_PATH
+    WC_STAR,       // '*' with TSM_FLAG_PATH
+    WC_GLOBSTAR,   // '**', or '*' without TSM_FLAG_PATH
+    WC_DIRS,       // '**/', zero or more directories. The next state is WC_DIRS_NAME.
+    WC_DIRS_NAME,  // in a directory name of '**/'
+};
+
+typedef struct {
+    uint8_t type;
+    uint8_t size;     // binary size of WC_CHAR
+    uint32_t offset;  // offset of WC_CHAR in the pattern
+} WcState;
+
+// Enough states for most paths without heap allocation.
+#define WC_STACK_STATES 256
+
+struct TsmWildcard {
+    int flags;
+    size_t seg_count;  // number of '*' + 1
+    WcSegment *segs;
+    size_t state_count;  // the accepting state is states[state_count]
+    WcState *states;
+    int use_bp;  // use bit-parallel search for middle segments
+    bitpar_t bp;
+    char pattern[];  // lowercased with TSM_FLAG_ICASE
+};
+
+static int rune_neq(const char* pattern, int p_rs, const char* str, int s_rs, int flags) {
+    if (!(flags & TSM_FLAG_ICASE))
+        return tsm_rune_cmp(pattern, p_rs, str, s_rs);
+    if (p_rs == 1 && s_rs == 1)
+        return (uint8_t)*pattern != tsm_ascii_lower[(uint8_t)*str];
+    return tsm_rune_decode(pattern, p_rs) != tsm_rune_fold(str, s_rs);
+}
+
+// Reads a character of a string or a pattern. With TSM_FLAG_BYTES, each byte is a Latin-1
+// character, and non-ASCII bytes are encoded to utf-8 in buf. Others point to the string.
+// Returns the number of bytes read, or zero for bad utf-8 characters.
+static int read_rune(const char* str, int flags, char* buf, const char** c, int* c_size) {
+    if (!(flags & TSM_FLAG_BYTES) || (uint8_t)*str <= ASCII_MAX) {
+        *c = str;
+        *c_size = tsm_rune_size(str);
+        return *c_size;
+    }
+    *c = buf;
+    *c_size = tsm_rune_encode((uint8_t)*str, buf);
+    return 1;
+}
 
-static TsmResult wildcard_match_base(const char* pattern, const char* str) {
+// Code units of strings for the path automaton
+#define wc_unit(wc) (((wc)->flags & TSM_FLAG_BYTES) ? TSM_UNIT_LATIN1 : TSM_UNIT_UTF8)
+
+static TsmResult wildcard_match_base(const char* pattern, const char* str, int flags) {
     while (*pattern != '\0') {
         // count the binary size of each character.
         int p_rs = tsm_rune_size(pattern);
@@ -21,7 +103,7 @@ static TsmResult wildcard_match_base(const char* pattern, const char* str) {
             return TSM_FAIL;  // failed to parse utf-8 characters.
 
         if (*pattern == '*') {
-            if (wildcard_match_base(pattern + p_rs, str) == TSM_OK)
+            if (wildcard_match_base(pattern + p_rs, str, flags) == TSM_OK)
                 return TSM_OK;
             else if (!*str)
                 return TSM_FAIL;
@@ -31,7 +113,7 @@ static TsmResult wildcard_match_base(const char* pattern, const char* str) {
         if (*pattern == '?') {
             if (!*str)
                 return TSM_FAIL;
-        } else if (tsm_rune_cmp(pattern, p_rs, str, s_rs)) {
+        } else if (rune_neq(pattern, p_rs, str, s_rs, flags)) {
             return TSM_FAIL;
         }
         pattern += p_rs;
@@ -43,5 +125,437 @@ static TsmResult wildcard_match_base(const char* pattern, const char* str) {
 TsmResult tsm_wildcard_match(const char *pattern, const char *str) {
     if (pattern == NULL || str == NULL)
         return TSM_FAIL;
-    return wildcard_match_base(pattern, str);
+    return wildcard_match_base(pattern, str, 0);
+}
+
+// Splits the pattern into segments and builds bit-parallel tables for middle segments.
+static void compile_segments(TsmWildcard *wc) {
+    const char* pattern = wc->pattern;
+    WcSegment* seg = wc->segs;
+    size_t i = 0;
+    int bit = 0;
+
+    memset(&wc->bp, 0, sizeof(bitpar_t));
+    wc->bp.bytes = (wc->flags & TSM_FLAG_BYTES) != 0;
+    seg->offset = 0;
+    seg->size = 0;
+    seg->runes = 0;
+    while (pattern[i] != '\0') {
+        int rs = tsm_rune_size(&pattern[i]);
+        if (pattern[i] == '*') {
+            seg++;
+            seg->offset = i + 1;
+            seg->size = 0;
+            seg->runes = 0;
+        } else {
+            seg->size += (size_t)rs;
+            seg->runes++;
+        }
+        i += (size_t)rs;
+    }
+
+    wc->use_bp = 1;
+    for (i = 1; i + 1 < wc->seg_count; i++) {
+        const char* p;
+        seg = &wc->segs[i];
+        if (seg->runes == 0)
+            continue;
+        if (bit + seg->runes > BP_MAX_POSITIONS) {
+            wc->use_bp = 0;
+            return;
+        }
+        seg->first_bit = bit + 1;
+        for (p = pattern + seg->offset; p < pattern + seg->offset + seg->size;) {
+            int rs = tsm_rune_size(p);
+            uint64_t mask = (uint64_t)1 << ++bit;
+            int c;
+            wc->bp.src[bit - 1] = (uint32_t)(p - pattern);
+            if (*p == '?') {
+                for (c = 1; c <= ASCII_MAX; c++)
+                    wc->bp.ascii[c] |= mask;
+                for (c = 0; wc->bp.bytes && c <= 0xFF - ASCII_MAX - 1; c++)
+                    wc->bp.latin1[c] |= mask;
+                wc->bp.mb_fixed |= mask;
+            } else if (rs == 1) {
+                wc->bp.ascii[(uint8_t)*p] |= mask;
+                if (wc->flags & TSM_FLAG_ICASE) {
+                    // Other cases, such as the Kelvin sign for 'k', may be non-ASCII.
+                    const uint32_t c0 = (uint8_t)*p;
+                    uint32_t cp;
+                    for (cp = tsm_rune_orbit(c0); cp != c0; cp = tsm_rune_orbit(cp)) {
+                        if (cp <= ASCII_MAX)
+                            wc->bp.ascii[cp] |= mask;
+                        else
+                            wc->bp.mb_var |= mask;
+                    }
+                }
+            } else {
+                wc->bp.mb_var |= mask;
+                for (c = ASCII_MAX + 1; wc->bp.bytes && c <= 0xFF; c++) {
+                    char buf[2];
+                    if (!rune_neq(p, rs, buf, tsm_rune_encode((uint32_t)c, buf), wc->flags))
+                        wc->bp.latin1[c - ASCII_MAX - 1] |= mask;
+                }
+            }
+            p += rs;
+        }
+        seg->last_bit = bit;
+    }
+    wc->bp.len = bit;
+}
+
+// Builds the path automaton. Returns the number of states. Counts them when states is NULL.
+static size_t compile_states(const char* pattern, int flags, WcState* states) {
+    const int path = flags & TSM_FLAG_PATH;
+    int seg_start = 1;  // at the beginning of the pattern or after '/'
+    size_t n = 0;
+    size_t i = 0;
+
+    while (pattern[i] != '\0') {
+        int rs = tsm_rune_size(&pattern[i]);
+        uint8_t type = WC_CHAR;
+        if (pattern[i] == '*') {
+            size_t stars = 0;
+            while (pattern[i] == '*') {
+                stars++;
+                i++;
+            }
+            if (path && stars >= 2 && seg_start && pattern[i] == '/') {
+                if (states) {
+                    states[n].type = WC_DIRS;
+                    states[n + 1].type = WC_DIRS_NAME;
+                }
+                n += 2;
+                i++;
+                continue;
+            }
+            if (states)
+                states[n].type = (path && stars == 1) ? WC_STAR : WC_GLOBSTAR;
+            n++;
+            seg_start = 0;
+            continue;
+        }
+        if (pattern[i] == '?')
+            type = path ? WC_ANY : WC_ANY_ALL;
+        if (states) {
+            states[n].type = type;
+            states[n].size = (uint8_t)rs;
+            states[n].offset = (uint32_t)i;
+        }
+        n++;
+        seg_start = (pattern[i] == '/');
+        i += (size_t)rs;
+    }
+    return n;
+}
+
+TsmResult tsm_wildcard_compile(const char *pattern, int flags, TsmWildcard **compiled) {
+    if (compiled == NULL)
+        return TSM_FAIL;
+    *compiled = NULL;
+    if (pattern == NULL)
+        return TSM_FAIL;
+
+    // Count the binary size of the (lowercased) pattern.
+    size_t size = 0;
+    size_t seg_count = 1;
+    const char* p = pattern;
+    const char* c;
+    int c_size;
+    char buf[4], folded[4];
+    while (*p != '\0') {
+        int rs = read_rune(p, flags, buf, &c, &c_size);
+        if (!rs)
+            return TSM_SYNTAX_ERROR;  // failed to parse utf-8 characters.
+        size += (flags & TSM_FLAG_ICASE) ? (size_t)tsm_rune_encode(tsm_rune_fold(c, c_size), folded)
+                                         : (size_t)c_size;
+        seg_count += (*p == '*');
+        p += rs;
+    }
+
+    TsmWildcard *wc = (TsmWildcard *)malloc(sizeof(TsmWildcard) + size + 1);
+    if (wc == NULL)
+        return TSM_OUT_OF_MEMORY;
+    wc->segs = (WcSegment *)calloc(seg_count, sizeof(WcSegment));
+    if (wc->segs == NULL) {
+        free(wc);
+        return TSM_OUT_OF_MEMORY;
+    }
+    wc->flags = flags;
+    wc->seg_count = seg_count;
+    wc->states = NULL;
+    if (flags & (TSM_FLAG_ICASE | TSM_FLAG_BYTES)) {
+        // Patterns are stored as utf-8.
+        char* out = wc->pattern;
+        for (p = pattern; *p != '\0';) {
+            p += read_rune(p, flags, buf, &c, &c_size);
+            if (flags & TSM_FLAG_ICASE) {
+                out += tsm_rune_encode(tsm_rune_fold(c, c_size), out);
+            } else {
+                memcpy(out, c, (size_t)c_size);
+                out += c_size;
+            }
+        }
+        *out = '\0';
+    } else {
+        memcpy(wc->pattern, pattern, size + 1);
+    }
+    compile_segments(wc);
+
+    wc->state_count = compile_states(wc->pattern, flags, NULL);
+    wc->states = (WcState *)calloc(wc->state_count + 1, sizeof(WcState));
+    if (wc->states == NULL) {
+        tsm_wildcard_free(wc);
+        return TSM_OUT_OF_MEMORY;
+    }
+    compile_states(wc->pattern, flags, wc->states);
+    *compiled = wc;
+    return TSM_OK;
+}
+
+// Matches a segment at the beginning of the string. Returns the end of the match or NULL.
+static const char* segment_match_at(const TsmWildcard *wc, const WcSegment *seg,
+                                    const char* str, const char* end) {
+    const char* p = wc->pattern + seg->offset;
+    const char* p_end = p + seg->size;
+    while (p < p_end) {
+        if (str >= end)
+            return NULL;
+        const char* c;
+        int c_size;
+        char buf[2];
+        int p_rs = tsm_rune_size(p);
+        int s_rs = read_rune(str, wc->flags, buf, &c, &c_size);
+        if (*p != '?' && rune_neq(p, p_rs, c, c_size, wc->flags))
+            return NULL;
+        p += p_rs;
+        str += s_rs;
+    }
+    return str;
+}
+
+static uint64_t segment_mbmask(const bitpar_t* bp, const void* ctx, uint64_t mask,
+                               const char* c, int c_size) {
+    const TsmWildcard *wc = (const TsmWildcard *)ctx;
+    uint64_t found = 0;
+    int i;
+    for (i = 1; i <= bp->len; i++) {
+        if (mask & ((uint64_t)1 << i)) {
+            const char* p = wc->pattern + bp->src[i - 1];
+            if (!rune_neq(p, tsm_rune_size(p), c, c_size, wc->flags))
+                found |= (uint64_t)1 << i;
+        }
+    }
+    return found;
+}
+
+// Finds the leftmost occurrence of a segment in [str, limit). Returns the end of it or NULL.
+static const char* segment_find(const TsmWildcard *wc, const WcSegment *seg,
+                                const char* str, const char* limit) {
+    if (wc->use_bp)
+        return bp_find_segment(&wc->bp, seg->first_bit, seg->last_bit,
+                               str, limit, segment_mbmask, wc);
+    while (str < limit) {
+        const char* found = segment_match_at(wc, seg, str, limit);
+        if (found)
+            return found;
+        str += (wc->flags & TSM_FLAG_BYTES) ? 1 : tsm_rune_size(str);
+    }
+    return NULL;
+}
+
+static TsmResult wildcard_match_segments(const TsmWildcard *wc, const char *str) {
+    // Matching consumes the whole string. So, it should be valid utf-8.
+    const int bytes = wc->flags & TSM_FLAG_BYTES;
+    size_t len = strlen(str);
+    if (!bytes && !tsm_utf8_valid(str, len))
+        return TSM_FAIL;
+
+    const char* end = str + len;
+    const WcSegment *head = &wc->segs[0];
+    const WcSegment *tail = &wc->segs[wc->seg_count - 1];
+    const char* pos = segment_match_at(wc, head, str, end);
+    if (pos == NULL)
+        return TSM_FAIL;
+    if (wc->seg_count == 1)
+        return (pos == end ? TSM_OK : TSM_FAIL);
+
+    // The last segment should be at the end of the string.
+    const char* tail_start = end;
+    for (size_t i = 0; i < tail->runes; i++) {
+        if (tail_start <= pos)
+            return TSM_FAIL;
+        do {
+            tail_start--;
+        } while (tail_start > pos && !bytes && is_multibyte_seq(*tail_start));
+    }
+    if (segment_match_at(wc, tail, tail_start, end) == NULL)
+        return TSM_FAIL;
+
+    // Other segments can be anywhere. The leftmost ones leave the most room for the rest.
+    for (size_t i = 1; i + 1 < wc->seg_count; i++) {
+        if (wc->segs[i].runes == 0)
+            continue;
+        pos = segment_find(wc, &wc->segs[i], pos, tail_start);
+        if (pos == NULL)
+            return TSM_FAIL;
+    }
+    return TSM_OK;
+}
+
+// Follows empty transitions. They always go forward.
+static void path_closure(const TsmWildcard *wc, uint8_t* active) {
+    for (size_t i = 0; i < wc->state_count; i++) {
+        if (!active[i])
+            continue;
+        if (wc->states[i].type == WC_STAR || wc->states[i].type == WC_GLOBSTAR)
+            active[i + 1] = 1;
+        else if (wc->states[i].type == WC_DIRS)
+            active[i + 2] = 1;
+    }
+}
+
+// Moves active states with a character. Returns non-zero when some states are still active.
+static int path_step(const TsmWildcard *wc, const uint8_t* cur, uint8_t* next,
+                     const char* c, int c_size) {
+    const int slash = (*c == '/');
+    int alive = 0;
+    memset(next, 0, wc->state_count + 1);
+    for (size_t i = 0; i < wc->state_count; i++) {
+        const WcState *st = &wc->states[i];
+        if (!cur[i])
+            continue;
+        switch (st->type) {
+            case WC_CHAR:
+                if (!rune_neq(wc->pattern + st->offset, st->size, c, c_size, wc->flags))
+                    next[i + 1] = 1;
+                break;
+            case WC_ANY:
+                next[i + 1] |= !slash;
+                break;
+            case WC_ANY_ALL:
+                next[i + 1] = 1;
+                break;
+            case WC_STAR:
+                next[i] |= !slash;
+                break;
+            case WC_GLOBSTAR:
+                next[i] = 1;
+                break;
+            case WC_DIRS:
+                next[slash ? i : i + 1] = 1;
+                break;
+            default:  // WC_DIRS_NAME
+                next[slash ? i - 1 : i] = 1;
+                break;
+        }
+    }
+    path_closure(wc, next);
+    for (size_t i = 0; i <= wc->state_count; i++)
+        alive |= next[i];
+    return alive;
+}
+
+// Runs the path automaton. Returns TSM_OK when the string reaches the accepting state.
+// The string has len code units of the given size (TSM_UNIT_*).
+// With descend, the string is a directory and it checks states for its descendants.
+static TsmResult path_match(const TsmWildcard *wc, const void* str, size_t len, int unit,
+                            int descend) {
+    uint8_t stack_buf[WC_STACK_STATES * 2];
+    uint8_t* buf = stack_buf;
+    uint8_t *cur, *next, *tmp;
+    const size_t n = wc->state_count + 1;
+    const char* units = (const char*)str;
+    TsmResult res = TSM_FAIL;
+    int alive = 1;
+    size_t pos = 0;
+
+    if (n > WC_STACK_STATES) {
+        buf = (uint8_t*)malloc(n * 2);
+        if (buf == NULL)
+            return TSM_OUT_OF_MEMORY;
+    }
+    cur = buf;
+    next = buf + n;
+    memset(cur, 0, n);
+    cur[0] = 1;
+    path_closure(wc, cur);
+
+    while (pos < len && alive) {
+        // The automaton compares utf-8 characters. Others are encoded again.
+        char utf8[4];
+        const char* c = units + pos * tsm_unit_width(unit);
+        uint32_t cp;
+        int rs = tsm_unit_decode(c, len - pos, unit, &cp);
+        if (!rs) {
+            alive = 0;  // failed to parse characters.
+            break;
+        }
+        pos += (size_t)rs;
+        if (unit != TSM_UNIT_UTF8) {
+            c = utf8;
+            rs = tsm_rune_encode(cp, utf8);
+        }
+        alive = path_step(wc, cur, next, c, rs);
+        tmp = cur;
+        cur = next;
+        next = tmp;
+        if (descend && pos == len && cp != '/') {
+            // Descendants start with '/'.
+            alive = alive && path_step(wc, cur, next, "/", 1);
+            tmp = cur;
+            cur = next;
+            next = tmp;
+        }
+    }
+
+    if (alive) {
+        if (descend) {
+            // A descendant has more characters. The accepting state can't take them.
+            for (size_t i = 0; i < wc->state_count; i++) {
+                if (cur[i])
+                    res = TSM_OK;
+            }
+        } else if (cur[wc->state_count]) {
+            res = TSM_OK;
+        }
+    }
+    if (buf != stack_buf)
+        free(buf);
+    return res;
+}
+
+TsmResult tsm_wildcard_match_compiled(const TsmWildcard *compiled, const char *str) {
+    if (compiled == NULL || str == NULL)
+        return TSM_FAIL;
+    if (compiled->flags & TSM_FLAG_PATH)
+        return path_match(compiled, str, strlen(str), wc_unit(compiled), 0);
+    return wildcard_match_segments(compiled, str);
+}
+
+// The automaton also works without TSM_FLAG_PATH. It reads each character once.
+TsmResult tsm_wildcard_match_utf16(const TsmWildcard *compiled, const uint16_t *str, size_t len) {
+    if (compiled == NULL || str == NULL || (compiled->flags & TSM_FLAG_BYTES))
+        return TSM_FAIL;
+    return path_match(compiled, str, len, TSM_UNIT_UTF16, 0);
+}
+
+TsmResult tsm_wildcard_match_utf32(const TsmWildcard *compiled, const uint32_t *str, size_t len) {
+    if (compiled == NULL || str == NULL || (compiled->flags & TSM_FLAG_BYTES))
+        return TSM_FAIL;
+    return path_match(compiled, str, len, TSM_UNIT_UTF32, 0);
+}
+
+TsmResult tsm_wildcard_can_descend(const TsmWildcard *compiled, const char *dir) {
+    if (compiled == NULL || dir == NULL)
+        return TSM_FAIL;
+    return path_match(compiled, dir, strlen(dir), wc_unit(compiled), 1);
+}
+
+void tsm_wildcard_free(TsmWildcard *compiled) {
+    if (compiled == NULL)
+        return;
+    free(compiled->states);
+    free(compiled->segs);
+    free(compiled);
 }
@@ -0,0 +1,72 @@
+/*
+ * Micro-benchmark for one-shot matches. Each call compiles the pattern,
+ * so tsm_regex_match() should stay cheap for short texts.
+ *
+ * Usage: bench_match [calls]
+ *
+ * Prints the best time of a few rounds for each pattern. (Run with "meson test --benchmark")
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "str_match.h"
+
+#define ROUNDS 5
+
+typedef struct BenchCase {
+    const char* pattern;
+    const char* str;
+} BenchCase;
+
+static const BenchCase cases[] = {
+    { "hello", "say hello world" },  // literal
+    { "^[a-z]+@[a-z]+\\.com$", "hello@example.com" },
+    { "x|y|z", "abcdefghz" },
+    { "\\d+", "abc12345" },
+    { "a.c", "xxxxabc" },
+    { "[0-9]{3}-[0-9]{4}", "call 555-1234" },
+    { "\\w+\\s\\w+", "hello world" },
+    { "a*b", "aaaaaaaaac" },  // no match
+};
+
+// Returns the best time of a call in nanoseconds.
+static double bench(const BenchCase* c, long calls, int full) {
+    double best = 0;
+    int round;
+    for (round = 0; round < ROUNDS; round++) {
+        clock_t begin = clock();
+        double ns;
+        long i;
+        for (i = 0; i < calls; i++) {
+            TsmResult res = full ? tsm_regex_fullmatch(c->pattern, c->str)
+                                 : tsm_regex_match(c->pattern, c->str);
+            if (res == TSM_SYNTAX_ERROR)
+                return -1;
+        }
+        ns = (double)(clock() - begin) * 1e9 / CLOCKS_PER_SEC / (double)calls;
+        if (round == 0 || ns < best)
+            best = ns;
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    long calls = argc > 1 ? atol(argv[1]) : 100000;
+    size_t i;
+    if (calls <= 0) {
+        fprintf(stderr, "Usage: bench_match [calls]\n");
+        return 1;
+    }
+    printf("%-24s %-20s %10s %10s\n", "pattern", "str", "match", "fullmatch");
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        double match = bench(&cases[i], calls, 0);
+        double full = bench(&cases[i], calls, 1);
+        if (match < 0 || full < 0) {
+            fprintf(stderr, "Syntax error: %s\n", cases[i].pattern);
+            return 1;
+        }
+        printf("%-24s %-20s %7.0f ns %7.0f ns\n", cases[i].pattern, cases[i].str, match, full);
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <string.h>
+#include <gtest/gtest.h>
+#include "str_match.h"
+
+// Built only with tsm-gen. (See tests/meson.build)
+#ifdef TSM_TEST_GEN
+#include "gen_patterns.h"
+
+struct GenCase {
+    const TsmRegex *const *generated;
+    const char *pattern;
+    int flags;
+};
+
+class GenTest : public ::testing::TestWithParam<GenCase> {
+};
+
+// Same patterns as gen_patterns.txt
+const GenCase gen_cases[] = {
+    { &literal, "abc", TSM_FLAG_NONE },
+    { &exact, "^abc$", TSM_FLAG_NONE },
+    { &bndm, "a\\dc", TSM_FLAG_ICASE },
+    { &digits, "^\\d+$", TSM_FLAG_NONE },
+    { &image, "^[a-z]+\\.png$", TSM_FLAG_ICASE },
+    { &assign, "^\\w+ *= *\\S+$", TSM_FLAG_NONE },
+    { &choice, "\\d{2,3}|png|x+y", TSM_FLAG_NONE },
+    { &memo, "a*a*b|\\d+$", TSM_FLAG_MEMOIZE },
+    { &word, "\\w{3}", TSM_FLAG_UNICODE },
+    { &kana, u8"[あ-お]+", TSM_FLAG_NONE },
+    { &raw, "[^a]+c|.b", TSM_FLAG_BYTES },
+    { &comment, "x*/y", TSM_FLAG_NONE },
+    { &possessive, "\\d++\\d|a*+c", TSM_FLAG_NONE },
+    { &words, "\\w*\\w*!|x", TSM_FLAG_SAFE },
+};
+
+INSTANTIATE_TEST_SUITE_P(GenTestInstantiation,
+    GenTest,
+    ::testing::ValuesIn(gen_cases));
+
+const char *const gen_strs[] = {
+    "", "abc", "xABCx", "A1C", "a1c", "123", "12a", "image.PNG", "x.png", "key = value",
+    "key=", "1234567890123456789012345678901234567890", "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaac",
+    "xxxy", "x/y", u8"あいう", u8"xééé", "a\x81" "b", "\xe4\xe4" "c",
+};
+
+// Generated patterns work the same as patterns compiled at run time.
+TEST_P(GenTest, tsm_regex_compile) {
+    const GenCase test_case = GetParam();
+    const TsmRegex *generated = *test_case.generated;
+    TsmRegex *compiled;
+    ASSERT_EQ(TSM_OK, tsm_regex_compile(test_case.pattern, test_case.flags, &compiled));
+    EXPECT_EQ(tsm_regex_strategy(compiled), tsm_regex_strategy(generated))
+        << "\npattern: " << test_case.pattern << "\n";
+    for (const char *str : gen_strs) {
+        size_t len = strlen(str);
+        TsmMatch expected = { 0, 0 }, actual = { 0, 0 };
+        size_t expected_count = 0, actual_count = 0;
+        EXPECT_EQ(tsm_regex_match_compiled(compiled, str),
+                  tsm_regex_match_compiled(generated, str))
+            << "\npattern: " << test_case.pattern << ", str: " << str << "\n";
+        EXPECT_EQ(tsm_regex_fullmatch_compiled(compiled, str),
+                  tsm_regex_fullmatch_compiled(generated, str))
+            << "\npattern: " << test_case.pattern << ", str: " << str << "\n";
+        EXPECT_EQ(tsm_regex_search(compiled, str, len, 0, &expected),
+                  tsm_regex_search(generated, str, len, 0, &actual))
+            << "\npattern: " << test_case.pattern << ", str: " << str << "\n";
+        EXPECT_EQ(expected.start, actual.start);
+        EXPECT_EQ(expected.end, actual.end);
+        EXPECT_EQ(tsm_regex_count(compiled, str, len, &expected_count),
+                  tsm_regex_count(generated, str, len, &actual_count));
+        EXPECT_EQ(expected_count, actual_count)
+            << "\npattern: " << test_case.pattern << ", str: " << str << "\n";
+    }
+    tsm_regex_free(compiled);
+}
+
+#endif  // TSM_TEST_GEN
@@ -0,0 +1,67 @@
+"""Runs tsm-grep and compares its output.
+
+Usage: python3 tests/grep_test.py tsm-grep tests/grep_fixture.txt
+
+The large file repeats the fixture over two chunks of MIN_CHUNK_SIZE, so -j 2 splits it.
+The stdin input has no line break at the end, so the last line comes from the last read.
+"""
+import os
+import subprocess
+import sys
+import tempfile
+
+MIN_CHUNK_SIZE = 1 << 16  # tools/tsm_grep.c
+
+failures = 0
+
+
+def run(grep, args, stdin=None):
+    proc = subprocess.run([grep] + args, input=stdin, stdout=subprocess.PIPE)
+    return proc.returncode, proc.stdout.replace(b"\r\n", b"\n")
+
+
+def check(name, actual, expected):
+    global failures
+    if actual != expected:
+        failures += 1
+        print("FAILED: %s\n  expected: %r\n  actual:   %r" % (name, expected, actual))
+
+
+def main():
+    grep, fixture = sys.argv[1], sys.argv[2]
+    with open(fixture, "rb") as f:
+        text = f.read()
+    digits = b"apple 10\nbanana 20\ndate 3\nelderberry 45\n"
+
+    check("lines", run(grep, ["\\d+$", fixture]), (0, digits))
+    check("-c", run(grep, ["-c", "\\d+$", fixture]), (0, b"4\n"))
+    check("-i", run(grep, ["-i", "^apple", fixture]), (0, b"apple 10\nApple pie\n"))
+    check("-w", run(grep, ["-w", "*rr*", fixture]), (0, b"cherry\nelderberry 45\n"))
+    check("no match", run(grep, ["-c", "zzz", fixture]), (1, b"0\n"))
+
+    with tempfile.TemporaryDirectory() as tmp:
+        empty = os.path.join(tmp, "empty.txt")
+        with open(empty, "wb"):
+            pass
+        check("-l", run(grep, ["-l", "cherry", empty, fixture]), (0, fixture.encode() + b"\n"))
+        check("-c with names", run(grep, ["-c", "cherry", empty, fixture]),
+              (0, b"%s:0\n%s:1\n" % (empty.encode(), fixture.encode())))
+
+        repeat = 2 * MIN_CHUNK_SIZE // len(text) + 1
+        large = os.path.join(tmp, "large.txt")
+        with open(large, "wb") as f:
+            f.write(text * repeat)
+        check("-j 2 -c", run(grep, ["-j", "2", "-c", "\\d+$", large]),
+              (0, b"%d\n" % (4 * repeat)))
+        check("-j 2", run(grep, ["-j", "2", "\\d+$", large]), (0, digits * repeat))
+        check("-j 2 -l", run(grep, ["-j2", "-l", "^cherry$", large]), (0, large.encode() + b"\n"))
+
+    check("stdin", run(grep, ["\\d+$"], stdin=text.rstrip(b"\n")), (0, digits))
+    check("stdin -c", run(grep, ["-c", "5$", "-"], stdin=text.rstrip(b"\n")), (0, b"1\n"))
+    check("stdin large", run(grep, ["-c", "^e"], stdin=(text * repeat).rstrip(b"\n")),
+          (0, b"%d\n" % repeat))
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,121 @@
+#pragma once
+#include <string.h>
+#include <string>
+#include <gtest/gtest.h>
+#include "str_match.h"
+
+struct IncrementalCase {
+    const char *pattern;
+    int flags;
+    int full;
+    const char *str;
+    const char *expected;  // status for each prefix: 'd' for dead, 'v' for viable, 'c' for complete
+};
+
+class IncrementalTest : public ::testing::TestWithParam<IncrementalCase> {
+};
+
+// Test with characters added one by one.
+const IncrementalCase incremental_cases[] = {
+    { "^\\d{3}-\\d{4}$", TSM_FLAG_NONE, 0, "123-4567", "vvvvvvvvc" },
+    { "^\\d{3}-\\d{4}$", TSM_FLAG_NONE, 0, "12a", "vvvd" },
+    { "^[a-z]+@[a-z]+\\.com$", TSM_FLAG_NONE, 0, "ab@x.com", "vvvvvvvvc" },
+    { "\\d+", TSM_FLAG_NONE, 1, "12a", "vccd" },
+    { "ab", TSM_FLAG_NONE, 0, "xaby", "vvvcc" },  // more text still has the match
+    { "^ab", TSM_FLAG_NONE, 0, "xa", "vdd" },
+    { "ab$", TSM_FLAG_NONE, 0, "abx", "vvcv" },
+    { "a|^b", TSM_FLAG_NONE, 0, "cc", "vvv" },
+    { "abc", TSM_FLAG_ICASE, 1, "AB", "vvv" },
+    { u8"^[あ-お]{2}$", TSM_FLAG_NONE, 0, u8"あいう", "vvcd" },
+    { "^\xe4+$", TSM_FLAG_BYTES, 0, "\xe4\xe4" "a", "vccd" },
+    { "a*", TSM_FLAG_NONE, 0, "b", "cc" },
+    { "a{2,3}", TSM_FLAG_NONE, 1, "aaaa", "vvccd" },
+    { "a{2,}b", TSM_FLAG_NONE, 1, "aaab", "vvvvc" },
+    { "a?b?", TSM_FLAG_NONE, 1, "abb", "cccd" },
+    { "\\w+|\\d{1,2}x", TSM_FLAG_NONE, 1, "1x", "vcc" },
+    { "\\s\\S", TSM_FLAG_UNICODE, 1, u8"　あ", "vvc" },
+    { "a", TSM_FLAG_NONE, 0, "\x81" "a", "vdd" },  // invalid utf-8
+    { "a\\d*|x", TSM_FLAG_NONE, 0, "a1\x81" "a", "vcccc" },  // found before the invalid byte
+    { "ab", TSM_FLAG_NONE, 0, "ab\x81", "vvcd" },  // ends right before it
+    { "\\d", TSM_FLAG_NONE, 1, "1\x81", "vcd" },
+};
+
+INSTANTIATE_TEST_SUITE_P(IncrementalTestInstantiation,
+    IncrementalTest,
+    ::testing::ValuesIn(incremental_cases));
+
+static size_t test_char_size(const char *str, int flags) {
+    unsigned char c = (unsigned char)*str;
+    if ((flags & TSM_FLAG_BYTES) || c < 0xC0)
+        return 1;
+    return c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+}
+
+static char status_char(TsmPrefixStatus status) {
+    return status == TSM_PREFIX_COMPLETE ? 'c' : status == TSM_PREFIX_VIABLE ? 'v' : 'd';
+}
+
+TEST_P(IncrementalTest, tsm_regex_incremental_push) {
+    const IncrementalCase test_case = GetParam();
+    TsmRegex *compiled;
+    TsmIncremental *inc;
+    std::string actual;
+    ASSERT_EQ(TSM_OK, tsm_regex_compile(test_case.pattern, test_case.flags, &compiled));
+    ASSERT_EQ(TSM_OK, tsm_regex_incremental_new(compiled, test_case.full, &inc));
+    actual += status_char(tsm_regex_incremental_status(inc));
+    for (const char *p = test_case.str; *p;) {
+        size_t size = test_char_size(p, test_case.flags);
+        EXPECT_EQ(TSM_OK, tsm_regex_incremental_push(inc, p, size));
+        actual += status_char(tsm_regex_incremental_status(inc));
+        p += size;
+    }
+    EXPECT_EQ(std::string(test_case.expected), actual)
+        << "\npattern: " << test_case.pattern << ", str: " << test_case.str << "\n";
+
+    // Removing characters goes back to the previous states.
+    for (size_t i = actual.size() - 1; i > 0; i--) {
+        EXPECT_EQ(TSM_OK, tsm_regex_incremental_pop(inc, 1));
+        EXPECT_EQ(actual[i - 1], status_char(tsm_regex_incremental_status(inc)))
+            << "\npattern: " << test_case.pattern << ", str: " << test_case.str << "\n";
+    }
+    EXPECT_EQ(0u, tsm_regex_incremental_length(inc));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_incremental_pop(inc, 1));
+
+    // Pushing the whole string at once works the same.
+    EXPECT_EQ(TSM_OK, tsm_regex_incremental_push(inc, test_case.str, strlen(test_case.str)));
+    EXPECT_EQ(actual.back(), status_char(tsm_regex_incremental_status(inc)));
+    tsm_regex_incremental_reset(inc);
+    EXPECT_EQ(actual[0], status_char(tsm_regex_incremental_status(inc)));
+    tsm_regex_incremental_free(inc);
+    tsm_regex_free(compiled);
+}
+
+TEST(IncrementalTest, tsm_regex_incremental_new) {
+    TsmRegex *compiled;
+    TsmIncremental *inc;
+    EXPECT_EQ(TSM_FAIL, tsm_regex_incremental_new(NULL, 0, &inc));
+    EXPECT_EQ(NULL, inc);
+    ASSERT_EQ(TSM_OK, tsm_regex_compile("a**", TSM_FLAG_NONE, &compiled));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_incremental_new(compiled, 0, &inc));  // backtracker only
+    EXPECT_EQ(TSM_FAIL, tsm_regex_incremental_new(compiled, 0, NULL));
+    tsm_regex_free(compiled);
+    ASSERT_EQ(TSM_OK, tsm_regex_compile("\\d{1,2000}", TSM_FLAG_NONE, &compiled));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_incremental_new(compiled, 0, &inc));  // too many positions
+    tsm_regex_free(compiled);
+    ASSERT_EQ(TSM_OK, tsm_regex_compile("a++b", TSM_FLAG_NONE, &compiled));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_incremental_new(compiled, 0, &inc));  // possessive
+    tsm_regex_free(compiled);
+    ASSERT_EQ(TSM_OK, tsm_regex_compile("\\d{1,500}", TSM_FLAG_NONE, &compiled));
+    ASSERT_EQ(TSM_OK, tsm_regex_incremental_new(compiled, 1, &inc));
+    std::string digits(501, '1');
+    EXPECT_EQ(TSM_OK, tsm_regex_incremental_push(inc, digits.c_str(), 500));
+    EXPECT_EQ(TSM_PREFIX_COMPLETE, tsm_regex_incremental_status(inc));
+    EXPECT_EQ(TSM_OK, tsm_regex_incremental_push(inc, digits.c_str(), 1));
+    EXPECT_EQ(TSM_PREFIX_DEAD, tsm_regex_incremental_status(inc));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_incremental_push(NULL, "a", 1));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_incremental_push(inc, NULL, 1));
+    EXPECT_EQ(TSM_PREFIX_DEAD, tsm_regex_incremental_status(NULL));
+    tsm_regex_incremental_free(inc);
+    tsm_regex_incremental_free(NULL);
+    tsm_regex_free(compiled);
+}
@@ -3,6 +3,9 @@
 #include "str_match.h"
 #include "wildcard_test.h"
 #include "re_test.h"
+#include "search_test.h"
+#include "incremental_test.h"
+#include "gen_test.h"
 
 int main(int argc, char* argv[]) {
     ::testing::InitGoogleTest(&argc, argv);
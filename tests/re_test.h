@@ -1,5 +1,6 @@
 #pragma once
 #include <stdio.h>
+#include <string>
 #include <gtest/gtest.h>
 #include "str_match.h"
 
@@ -223,6 +224,8 @@ const RegexCase regex_cases_python[] = {
     { "a\\", "-", TSM_SYNTAX_ERROR },
     // { "abc)", "-", TSM_SYNTAX_ERROR },  // () operator is not supported.
     // { "(abc", "-", TSM_SYNTAX_ERROR },
+    { "(ab)", "x(ab)y", TSM_OK },  // literal parentheses
+    { "(ab)", "ab", TSM_FAIL },
     { "a]", "a]", TSM_OK },
     // { "a[]]b", "a]b", TSM_OK },  // fail.
     { "a[\\]]b", "a]b", TSM_OK },
@@ -384,6 +387,133 @@ INSTANTIATE_TEST_SUITE_P(RegexTestInstantiation_Startend,
     RegexTest,
     ::testing::ValuesIn(regex_cases_startend));
 
+// Test with patterns for the bit-parallel engine.
+const RegexCase regex_cases_bitpar[] = {
+    { "needle", "haystack with a needle in it", TSM_OK },
+    { "needle", "haystack with a needl", TSM_FAIL },
+    { "n[a-e]e\\dle", "xxne3le nee4le", TSM_OK },
+    { "n[a-e]e\\dle", "xxne3le nef4le", TSM_FAIL },
+    { u8"\u3042\\d?b", u8"x\u3042b", TSM_OK },
+    { u8"\u3042\\d?b", u8"x\u30421b", TSM_OK },
+    { u8"\u3042\\d?b", u8"x\u304212b", TSM_FAIL },
+    { "^a?b?c?$", "", TSM_OK },
+    { "^a?b?c?$", "ac", TSM_OK },
+    { "^a?b?c?$", "ca", TSM_FAIL },
+    { "^x\\d{2,4}y$", "x1y", TSM_FAIL },
+    { "^x\\d{2,4}y$", "x123y", TSM_OK },
+    { "^x\\d{2,4}y$", "x12345y", TSM_FAIL },
+    { "^x\\d{2,}y$", "x12345y", TSM_OK },
+    { "a.+b*c", "xxaxxbbbc", TSM_OK },
+    { "a.+b*c", "xxabbb", TSM_FAIL },
+    { "\\d{40}", "123456789012345678901234567890123456789", TSM_FAIL },
+    { "\\d{40}", "1234567890123456789012345678901234567890", TSM_OK },
+    { "\\d{1,70}x", "1234567890123456789012345678901234567890x", TSM_OK },  // too many positions
+};
+
+INSTANTIATE_TEST_SUITE_P(RegexTestInstantiation_BitParallel,
+    RegexTest,
+    ::testing::ValuesIn(regex_cases_bitpar));
+
+// Test with literal patterns.
+const RegexCase regex_cases_literal[] = {
+    { "needle", "a needle in a haystack", TSM_OK },
+    { "needle", "a needl", TSM_FAIL },
+    { u8"\u3042\u3044", u8"x\u3042\u3044y", TSM_OK },
+    { "\\.png", "image.png", TSM_OK },
+    { "\\.png", "image_png", TSM_FAIL },
+    { "^image", "image.png", TSM_OK },
+    { "^image", "my image.png", TSM_FAIL },
+    { "png$", "image.png", TSM_OK },
+    { "png$", "image.png.bak", TSM_FAIL },
+    { "^image.png$", "image_png", TSM_OK },  // '.' is not a literal
+    { "^image\\.png$", "image.png", TSM_OK },
+    { "^image\\.png$", "image.png ", TSM_FAIL },
+    { "^$", "", TSM_OK },
+    { "^$", "a", TSM_FAIL },
+    { "ab", "\x81" "ab", TSM_FAIL },  // bad rune before the match
+    { "ab", "ab\x81", TSM_FAIL },  // bad rune after the match
+    { "ab", "ab ab\x81", TSM_OK },
+    { "^ab", "ab\xc3", TSM_FAIL },
+    { "ab$", "\xe3" "ab", TSM_FAIL },
+};
+
+INSTANTIATE_TEST_SUITE_P(RegexTestInstantiation_Literal,
+    RegexTest,
+    ::testing::ValuesIn(regex_cases_literal));
+
+// Test with patterns for the bytecode VM.
+const RegexCase regex_cases_vm[] = {
+    { "cat|dog", "hotdog", TSM_OK },
+    { "cat|dog", "hotdot", TSM_FAIL },
+    { "^cat|dog$", "cats", TSM_OK },
+    { "^cat|dog$", "a cat", TSM_FAIL },
+    { "^cat|dog$", "dogs", TSM_FAIL },
+    { "x|", "abc", TSM_OK },  // empty branch
+    { "x|^$", "", TSM_OK },
+    { "x|a+b+$", "aabb", TSM_OK },
+    { "x|a+b+$", "aabba", TSM_FAIL },
+    { "x|^a*ab$", "aaab", TSM_OK },
+    { "x|^a?ab$", "ab", TSM_OK },
+    { "x|^a{2,3}b$", "aab", TSM_OK },
+    { "x|^a{2,3}b$", "aaaab", TSM_FAIL },
+    { "x|^a{2,}$", "aaaaaaaa", TSM_OK },
+    { u8"x|^[あ-ん]+$", u8"あい", TSM_OK },
+    { "x|\\d{1,70}$", "12345678901234567890123456789012345678901234567890123456789012345", TSM_OK },
+    { "x|a.*b", "a\x81" "b", TSM_FAIL },  // bad rune
+    { "x|a*b", "b\x81", TSM_FAIL },
+    { "a*b?|x", "aa\x81", TSM_OK },  // matches the empty string at the beginning
+    { "x|a", "ab\x81", TSM_OK },  // all branches are tried before the bad rune
+    { "x|^a", "b\x81", TSM_FAIL },
+};
+
+INSTANTIATE_TEST_SUITE_P(RegexTestInstantiation_VM,
+    RegexTest,
+    ::testing::ValuesIn(regex_cases_vm));
+
+// Test with boolean matches that stop at the first accepting state.
+const RegexCase regex_cases_early[] = {
+    { "error.*timeout", "error: timeout after timeout", TSM_OK },
+    { "error.*timeout", "error: timeou", TSM_FAIL },
+    { "x|a\\d+\\d", "a123", TSM_OK },
+    { "x|a\\d+\\d{3}", "a123", TSM_FAIL },
+    { "x|a.+b", u8"aäbä", TSM_OK },
+    { "x|a[^x]*b", u8"aäbäx", TSM_OK },
+    { "ab*", "ab\x81", TSM_OK },  // accepts before the bad rune, like the greedy match
+    { "a.*", "a\x81", TSM_FAIL },
+    { "x|a.*b", "ab\x81", TSM_FAIL },  // 'b' is followed by the bad rune
+    { "x|a.*c", "abc\x81" "c", TSM_FAIL },
+};
+
+INSTANTIATE_TEST_SUITE_P(RegexTestInstantiation_Early,
+    RegexTest,
+    ::testing::ValuesIn(regex_cases_early));
+
+// Test with possessive quantifiers. They never give repetitions back.
+const RegexCase regex_cases_possessive[] = {
+    { "a*+a", "aaaa", TSM_FAIL },
+    { "a++b", "aaab", TSM_OK },
+    { "x|a*+a", "aaaa", TSM_FAIL },
+    { "x|a++b", "aaab", TSM_OK },
+    { "x|\\d++\\d", "123", TSM_FAIL },
+    { "x|^\\d*+$", "", TSM_OK },
+    { "x|^a?+a$", "a", TSM_FAIL },
+    { "x|^a?+a$", "aa", TSM_OK },
+    { "x|^a{1,3}+a$", "aaa", TSM_FAIL },
+    { "x|^a{1,3}+a$", "aaaa", TSM_OK },
+    { "x|^a{2,}+$", "aaaaaaaa", TSM_OK },
+    { "x|^a{2,}+b", "ab", TSM_FAIL },
+    { "x|\"[^\"]*+\"", "say \"hi\"", TSM_OK },
+    { "x|\"[^\"]*+\"", "say \"hi", TSM_FAIL },
+    { "x|a*+b", "aa\x81", TSM_FAIL },  // bad rune
+    { "x|^a*+$", "aa\x81", TSM_FAIL },
+    { "x|a{0,2}+b", "a\x81" "b", TSM_FAIL },
+    { "a+++", "a", TSM_FAIL },  // the third '+' has no atom
+};
+
+INSTANTIATE_TEST_SUITE_P(RegexTestInstantiation_Possessive,
+    RegexTest,
+    ::testing::ValuesIn(regex_cases_possessive));
+
 // Test with long pattern errors.
 const RegexCase regex_cases_long_error[] = {
     { "abcdefghijabcdefghijabcdefghi", "abcdefghijabcdefghijabcdefghi", TSM_OK },
@@ -406,3 +536,687 @@ TEST_P(RegexTest, tsm_regex_match) {
     EXPECT_EQ(test_case.expected, actual)
         << "\npattern: " << test_case.pattern << ", str: " << test_case.str << "\n";
 }
+
+TEST_P(RegexTest, tsm_regex_match_compiled) {
+    const RegexCase test_case = GetParam();
+    TsmRegex *compiled;
+    int actual = tsm_regex_compile(test_case.pattern, TSM_FLAG_NONE, &compiled);
+    if (actual == TSM_OK) {
+        actual = tsm_regex_match_compiled(compiled, test_case.str);
+        tsm_regex_free(compiled);
+    }
+    EXPECT_EQ(test_case.expected, actual)
+        << "\npattern: " << test_case.pattern << ", str: " << test_case.str << "\n";
+}
+
+// Searches run the machine code for bit-parallel patterns too.
+static int match_jit(const char *pattern, const char *str, int flags, int full) {
+    TsmRegex *compiled;
+    TsmMatch match;
+    int actual = tsm_regex_compile(pattern, flags | TSM_FLAG_JIT, &compiled);
+    if (actual != TSM_OK)
+        return actual;
+    if (full) {
+        actual = tsm_regex_fullmatch_compiled(compiled, str);
+    } else if (str == NULL) {
+        actual = tsm_regex_match_compiled(compiled, str);
+    } else {
+        actual = tsm_regex_match_compiled(compiled, str);
+        EXPECT_EQ(actual, tsm_regex_search(compiled, str, strlen(str), 0, &match))
+            << "\npattern: " << pattern << ", str: " << str << ", flags: " << flags << "\n";
+    }
+    tsm_regex_free(compiled);
+    return actual;
+}
+
+TEST_P(RegexTest, tsm_regex_match_compiled_jit) {
+    const RegexCase test_case = GetParam();
+    int actual = match_jit(test_case.pattern, test_case.str, TSM_FLAG_NONE, 0);
+    EXPECT_EQ(test_case.expected, actual)
+        << "\npattern: " << test_case.pattern << ", str: " << test_case.str << "\n";
+}
+
+struct RegexFlagCase {
+    const char *pattern;
+    const char *str;
+    int flags;
+    int expected;
+};
+
+class RegexFlagTest : public ::testing::TestWithParam<RegexFlagCase> {
+};
+
+// Test with case-insensitive patterns.
+const RegexFlagCase regex_cases_icase[] = {
+    { "abc", "ABC", TSM_FLAG_NONE, TSM_FAIL },
+    { "abc", "ABC", TSM_FLAG_ICASE, TSM_OK },
+    { "ABC", "xabcx", TSM_FLAG_ICASE, TSM_OK },
+    { "^aBc$", "AbC", TSM_FLAG_ICASE, TSM_OK },
+    { "^aBc$", "AbCd", TSM_FLAG_ICASE, TSM_FAIL },
+    { "^a+$", "aAaA", TSM_FLAG_ICASE, TSM_OK },
+    { "^[a-c]+$", "AbC", TSM_FLAG_ICASE, TSM_OK },
+    { "^[A-C]+$", "abc", TSM_FLAG_ICASE, TSM_OK },
+    { "^[^a-c]+$", "ABC", TSM_FLAG_ICASE, TSM_FAIL },
+    { "^[^a-c]+$", "DEF", TSM_FLAG_ICASE, TSM_OK },
+    { "^\\W+$", "@-", TSM_FLAG_ICASE, TSM_OK },
+    { "^1_\\d$", "1_2", TSM_FLAG_ICASE, TSM_OK },
+    { "^\\Q$", "q", TSM_FLAG_ICASE, TSM_OK },
+    { u8"^\u00e4$", u8"\u00c4", TSM_FLAG_NONE, TSM_FAIL },  // \u00e4 == "ä", \u00c4 == "Ä"
+    { u8"^\u00e4$", u8"\u00c4", TSM_FLAG_ICASE, TSM_OK },
+    { u8"^\u00c4$", u8"\u00e4", TSM_FLAG_ICASE, TSM_OK },
+    { u8"^[\u00e0-\u00ef]+$", u8"\u00c4\u00e4", TSM_FLAG_ICASE, TSM_OK },
+    { u8"^\u03a9+$", u8"\u03c9\u03a9", TSM_FLAG_ICASE, TSM_OK },  // Greek omega
+    { u8"^\u0416$", u8"\u0436", TSM_FLAG_ICASE, TSM_OK },  // Cyrillic zhe
+    { u8"^\u3042$", u8"\u3042", TSM_FLAG_ICASE, TSM_OK },  // no case
+    { u8"^\u3042$", u8"\u3044", TSM_FLAG_ICASE, TSM_FAIL },
+    { u8"^\u0181\u01a0\u01cd$", u8"\u0253\u01a1\u01ce", TSM_FLAG_ICASE, TSM_OK },  // Latin Ext-B
+    { u8"^\u0386\u038f$", u8"\u03ac\u03ce", TSM_FLAG_ICASE, TSM_OK },  // accented Greek
+    { u8"^\u10a0$", u8"\u2d00", TSM_FLAG_ICASE, TSM_OK },  // Georgian an
+    { u8"^\u13a0$", u8"\uab70", TSM_FLAG_ICASE, TSM_OK },  // Cherokee a
+    { u8"^\u1e9e$", u8"\u00df", TSM_FLAG_ICASE, TSM_OK },  // capital sharp s
+    { u8"^K+$", u8"k\u212aK", TSM_FLAG_ICASE, TSM_OK },  // \u212a == Kelvin sign
+    { u8"^\u212a$", u8"k", TSM_FLAG_ICASE, TSM_OK },
+    { u8"^k$", u8"\u212a", TSM_FLAG_NONE, TSM_FAIL },
+    { u8"x\u017f", u8"aXS", TSM_FLAG_ICASE, TSM_OK },  // \u017f == long s
+    { u8"^s+$", u8"\u017fsS", TSM_FLAG_ICASE, TSM_OK },
+    { u8"^\u03c3+$", u8"\u03a3\u03c2\u03c3", TSM_FLAG_ICASE, TSM_OK },  // Greek sigma
+    { u8"^\u03b8+$", u8"\u0398\u03d1\u03f4", TSM_FLAG_ICASE, TSM_OK },  // Greek theta
+    { u8"^[j-l]$", u8"\u212a", TSM_FLAG_ICASE, TSM_OK },
+    { u8"^[\u212a]+$", u8"kK", TSM_FLAG_ICASE, TSM_OK },
+    { u8"^[^k]$", u8"\u212a", TSM_FLAG_ICASE, TSM_FAIL },
+};
+
+INSTANTIATE_TEST_SUITE_P(RegexFlagTestInstantiation_ICase,
+    RegexFlagTest,
+    ::testing::ValuesIn(regex_cases_icase));
+
+// Test with Unicode-aware \d, \w, and \s.
+const RegexFlagCase regex_cases_unicode[] = {
+    { "^\\d+$", u8"\u0661\u0662", TSM_FLAG_NONE, TSM_FAIL },  // Arabic-Indic digits
+    { "^\\d+$", u8"\u0661\u0662", TSM_FLAG_UNICODE, TSM_OK },
+    { "^\\d+$", u8"\uff11", TSM_FLAG_UNICODE, TSM_OK },  // Fullwidth digit one
+    { "^\\D$", u8"\u0661", TSM_FLAG_UNICODE, TSM_FAIL },
+    { "^\\D$", u8"\u0661", TSM_FLAG_NONE, TSM_OK },
+    { "^\\w+$", u8"\u3042\u00e4_1", TSM_FLAG_NONE, TSM_FAIL },
+    { "^\\w+$", u8"\u3042\u00e4_1", TSM_FLAG_UNICODE, TSM_OK },
+    { "^\\w+$", u8"\U0001F600", TSM_FLAG_UNICODE, TSM_FAIL },  // emoji
+    { "^\\W$", u8"\U0001F600", TSM_FLAG_UNICODE, TSM_OK },
+    { "^a\\sb$", u8"a\u3000b", TSM_FLAG_NONE, TSM_FAIL },  // Ideographic space
+    { "^a\\sb$", u8"a\u3000b", TSM_FLAG_UNICODE, TSM_OK },
+    { "^a\\sb$", u8"a\u00a0b", TSM_FLAG_UNICODE, TSM_OK },  // No-break space
+    { "^a\\Sb$", u8"a\u3000b", TSM_FLAG_UNICODE, TSM_FAIL },
+    { "^[\\d\\s]+$", u8"1\u3000\u0662", TSM_FLAG_UNICODE, TSM_OK },
+    { "^[^\\w]+$", u8"\u00e4", TSM_FLAG_UNICODE, TSM_FAIL },
+    { "^[^\\w]+$", u8"\u00e4", TSM_FLAG_NONE, TSM_OK },
+    { "^\\w+$", u8"\u00c4\u00e4", TSM_FLAG_UNICODE | TSM_FLAG_ICASE, TSM_OK },
+};
+
+INSTANTIATE_TEST_SUITE_P(RegexFlagTestInstantiation_Unicode,
+    RegexFlagTest,
+    ::testing::ValuesIn(regex_cases_unicode));
+
+// Test with memoized backtracking. Results should be the same as plain backtracking.
+const RegexFlagCase regex_cases_memoize[] = {
+    { "x|a*a*b", "aaab", TSM_FLAG_MEMOIZE, TSM_OK },
+    { "x|a*a*b", "aaaa", TSM_FLAG_MEMOIZE, TSM_FAIL },
+    { "x|^a+b", "aab", TSM_FLAG_MEMOIZE, TSM_OK },
+    { "x|a+b$", "aab", TSM_FLAG_MEMOIZE, TSM_OK },
+    { "x|a{2,3}b", "ab aaab", TSM_FLAG_MEMOIZE, TSM_OK },
+    { "x|\\d?\\d?\\d?123", "123", TSM_FLAG_MEMOIZE, TSM_OK },
+    { "x|a.*b", "a\x81" "b", TSM_FLAG_MEMOIZE, TSM_FAIL },  // bad rune
+    { "x|a*+a", "aaaa", TSM_FLAG_MEMOIZE, TSM_FAIL },  // possessive
+    { "x|^a{1,3}+a$", "aaaa", TSM_FLAG_MEMOIZE, TSM_OK },
+};
+
+INSTANTIATE_TEST_SUITE_P(RegexFlagTestInstantiation_Memoize,
+    RegexFlagTest,
+    ::testing::ValuesIn(regex_cases_memoize));
+
+// Test with byte mode. Each byte is a Latin-1 character.
+const RegexFlagCase regex_cases_bytes[] = {
+    { "a.c", "a\xff" "c", TSM_FLAG_NONE, TSM_FAIL },  // bad rune
+    { "a.c", "a\xff" "c", TSM_FLAG_BYTES, TSM_OK },
+    { "^.$", "\xe4", TSM_FLAG_BYTES, TSM_OK },
+    { "^.$", u8"\u00e4", TSM_FLAG_BYTES, TSM_FAIL },  // two bytes
+    { "^..$", u8"\u00e4", TSM_FLAG_BYTES, TSM_OK },
+    { "\xe4", "x\xe4x", TSM_FLAG_BYTES, TSM_OK },  // literal
+    { "^\xe4", "\xe4\x81", TSM_FLAG_BYTES, TSM_OK },
+    { "\xe4$", "\x81\xe4", TSM_FLAG_BYTES, TSM_OK },
+    { "^\xe4+$", "\xe4\xc4", TSM_FLAG_BYTES | TSM_FLAG_ICASE, TSM_OK },  // Latin-1 cases
+    { "^\xe4+$", "\xe4\xc4", TSM_FLAG_BYTES, TSM_FAIL },
+    { "^[\x80-\xff]+$", "\x80\xff\xe4", TSM_FLAG_BYTES, TSM_OK },
+    { "^[\x80-\xff]+$", "\x80" "a", TSM_FLAG_BYTES, TSM_FAIL },
+    { "^[^\xe4]$", "\xc4", TSM_FLAG_BYTES, TSM_OK },
+    { "^\\w+$", "a\xe4", TSM_FLAG_BYTES, TSM_FAIL },
+    { "^\\w+$", "a\xe4", TSM_FLAG_BYTES | TSM_FLAG_UNICODE, TSM_OK },
+    { "a\\d+b", "\x81" "a12b", TSM_FLAG_BYTES, TSM_OK },  // bit-parallel
+    { "a.b", "\x81" "a\xfe" "b", TSM_FLAG_BYTES, TSM_OK },
+    { "cat|d.g", "\xfe" "d\xff" "g", TSM_FLAG_BYTES, TSM_OK },  // bytecode VM
+    { "cat|d.g", "\xfe" "d\xff" "g", TSM_FLAG_BYTES | TSM_FLAG_MEMOIZE, TSM_OK },  // backtracking
+    { "x|\xe4.", "a\xe4\xff", TSM_FLAG_BYTES | TSM_FLAG_MEMOIZE, TSM_OK },
+    { "a$b|c", "\xfe" "c", TSM_FLAG_BYTES, TSM_OK },
+};
+
+INSTANTIATE_TEST_SUITE_P(RegexFlagTestInstantiation_Bytes,
+    RegexFlagTest,
+    ::testing::ValuesIn(regex_cases_bytes));
+
+// Test with long runs for span scanners. Runs cross 16 and 32-byte blocks.
+#define DIGITS40 "1234567890123456789012345678901234567890"
+#define WORDS40 "abcdefghij_ABCDEFGHIJ0123456789abcdefghi"
+const RegexFlagCase regex_cases_span[] = {
+    { "x|^\\d+$", DIGITS40 DIGITS40, TSM_FLAG_NONE, TSM_OK },  // bytecode VM
+    { "x|^\\d+$", DIGITS40 "a" DIGITS40, TSM_FLAG_NONE, TSM_FAIL },
+    { "x|^\\d+$", DIGITS40 "a" DIGITS40, TSM_FLAG_MEMOIZE, TSM_FAIL },  // backtracking
+    { "x|^\\w*0$", WORDS40 WORDS40 "0", TSM_FLAG_NONE, TSM_OK },
+    { "x|^\\w*0$", WORDS40 WORDS40 "0", TSM_FLAG_MEMOIZE, TSM_OK },
+    { "x|^\\w*9a$", WORDS40 "9a", TSM_FLAG_MEMOIZE, TSM_OK },  // gives back a part of the run
+    { "x|^[a-z0-9]{1,64}$", DIGITS40 "abcdefghijklmnopqrstuvwy", TSM_FLAG_NONE, TSM_OK },
+    { "x|^[a-z0-9]{1,64}$", DIGITS40 "abcdefghijklmnopqrstuvwyz", TSM_FLAG_NONE, TSM_FAIL },
+    { "x|^[a-z0-9]{1,64}$", DIGITS40 "abcdefghijklmnopqrstuvwy", TSM_FLAG_MEMOIZE, TSM_OK },
+    { "x|^[a-z0-9]{1,64}$", DIGITS40 "abcdefghijklmnopqrstuvwyz", TSM_FLAG_MEMOIZE, TSM_FAIL },
+    { "x|^\\d{70}", DIGITS40 DIGITS40, TSM_FLAG_NONE, TSM_OK },
+    { "x|^\\d{70}", DIGITS40 DIGITS40, TSM_FLAG_MEMOIZE, TSM_OK },
+    { "x|^.*$", DIGITS40 u8"\u3042" DIGITS40 u8"\u3042", TSM_FLAG_NONE, TSM_OK },
+    { "x|^.*$", DIGITS40 u8"\u3042" DIGITS40 u8"\u3042", TSM_FLAG_MEMOIZE, TSM_OK },
+    { "x|^\\w+$", WORDS40 u8"\u00e4" WORDS40, TSM_FLAG_UNICODE, TSM_OK },
+    { "x|^\\w+$", WORDS40 u8"\u00e4" WORDS40, TSM_FLAG_NONE, TSM_FAIL },
+    { "x|\\d*", DIGITS40 "\x81", TSM_FLAG_NONE, TSM_OK },  // matches the empty string
+    { "x|\\d+", DIGITS40 "\x81", TSM_FLAG_NONE, TSM_FAIL },  // bad rune after the run
+    { "x|\\d+", DIGITS40 "\x81", TSM_FLAG_MEMOIZE, TSM_FAIL },
+    { "x|\\d{2}", DIGITS40 "\x81", TSM_FLAG_NONE, TSM_OK },
+    { "x|\\d{40}", DIGITS40 "\x81", TSM_FLAG_NONE, TSM_FAIL },
+    { "x|\\d{40}", DIGITS40 "\x81", TSM_FLAG_MEMOIZE, TSM_FAIL },
+    { "x|^[\x80-\xff]+$", DIGITS40 DIGITS40, TSM_FLAG_BYTES, TSM_FAIL },
+    { "x|^\xe4+\xff$", "\xe4\xc4\xe4\xc4\xe4\xc4\xe4\xc4\xe4\xc4\xe4\xc4\xe4\xc4\xe4\xc4"
+      "\xe4\xc4\xe4\xc4\xe4\xc4\xe4\xc4\xe4\xc4\xe4\xc4\xe4\xc4\xe4\xc4\xe4\xff",
+      TSM_FLAG_BYTES | TSM_FLAG_ICASE, TSM_OK },
+    { "x|^.+$", DIGITS40 "\x81\xff" DIGITS40, TSM_FLAG_BYTES, TSM_OK },
+};
+#undef DIGITS40
+#undef WORDS40
+
+INSTANTIATE_TEST_SUITE_P(RegexFlagTestInstantiation_Span,
+    RegexFlagTest,
+    ::testing::ValuesIn(regex_cases_span));
+
+TEST(RegexMemoizeTest, tsm_regex_match_compiled_exponential) {
+    // Plain backtracking takes O(n^9) time for it.
+    std::string str(300, 'a');
+    TsmRegex *compiled;
+    ASSERT_EQ(TSM_OK, tsm_regex_compile("x|a*a*a*a*a*a*a*a*a*b", TSM_FLAG_MEMOIZE, &compiled));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_match_compiled(compiled, str.c_str()));
+    str += "b";
+    EXPECT_EQ(TSM_OK, tsm_regex_match_compiled(compiled, str.c_str()));
+    tsm_regex_free(compiled);
+}
+
+TEST(RegexBacktrackTest, tsm_regex_search_long) {
+    // The misplaced anchor needs the backtracker. Its stack doesn't grow with the text.
+    std::string str(1 << 20, 'a');
+    TsmRegex *compiled;
+    TsmMatch match;
+    ASSERT_EQ(TSM_OK, tsm_regex_compile("x^|a.*a$", TSM_FLAG_NONE, &compiled));
+    EXPECT_EQ(TSM_STRATEGY_BACKTRACK, tsm_regex_strategy(compiled));
+    EXPECT_EQ(TSM_OK, tsm_regex_match_compiled(compiled, str.c_str()));
+    EXPECT_EQ(TSM_OK, tsm_regex_fullmatch_compiled(compiled, str.c_str()));
+    ASSERT_EQ(TSM_OK, tsm_regex_search(compiled, str.c_str(), str.size(), 0, &match));
+    EXPECT_EQ(0u, match.start);
+    EXPECT_EQ(str.size(), match.end);
+    tsm_regex_free(compiled);
+}
+
+TEST(RegexBacktrackTest, tsm_regex_search_deepest) {
+    // Each '?' pushes a choice and a memo frame, so the longest pattern fills the stack.
+    std::string pattern;
+    for (int i = 0; i < 14; i++)
+        pattern += "a?";
+    pattern += "b";
+    std::string str(20, 'a');
+    TsmRegex *compiled;
+    TsmMatch match;
+    ASSERT_EQ(TSM_OK, tsm_regex_compile(pattern.c_str(), TSM_FLAG_MEMOIZE, &compiled));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_search(compiled, (str + "c").c_str(), 21, 0, &match));
+    ASSERT_EQ(TSM_OK, tsm_regex_search(compiled, (str + "b").c_str(), 21, 0, &match));
+    EXPECT_EQ(6u, match.start);
+    EXPECT_EQ(21u, match.end);
+    tsm_regex_free(compiled);
+}
+
+TEST_P(RegexFlagTest, tsm_regex_match_compiled) {
+    const RegexFlagCase test_case = GetParam();
+    TsmRegex *compiled;
+    int actual = tsm_regex_compile(test_case.pattern, test_case.flags, &compiled);
+    if (actual == TSM_OK) {
+        actual = tsm_regex_match_compiled(compiled, test_case.str);
+        tsm_regex_free(compiled);
+    }
+    EXPECT_EQ(test_case.expected, actual)
+        << "\npattern: " << test_case.pattern << ", str: " << test_case.str
+        << ", flags: " << test_case.flags << "\n";
+}
+
+TEST_P(RegexFlagTest, tsm_regex_match_compiled_jit) {
+    const RegexFlagCase test_case = GetParam();
+    int actual = match_jit(test_case.pattern, test_case.str, test_case.flags, 0);
+    EXPECT_EQ(test_case.expected, actual)
+        << "\npattern: " << test_case.pattern << ", str: " << test_case.str
+        << ", flags: " << test_case.flags << "\n";
+}
+
+class RegexFullmatchTest : public ::testing::TestWithParam<RegexFlagCase> {
+};
+
+// Test with whole strings. Each engine should be anchored at both ends.
+const RegexFlagCase regex_cases_fullmatch[] = {
+    { "abc", "abc", TSM_FLAG_NONE, TSM_OK },  // literal
+    { "abc", "xabc", TSM_FLAG_NONE, TSM_FAIL },
+    { "abc", "abcx", TSM_FLAG_NONE, TSM_FAIL },
+    { "^abc", "abcx", TSM_FLAG_NONE, TSM_FAIL },
+    { "", "", TSM_FLAG_NONE, TSM_OK },
+    { "", "a", TSM_FLAG_NONE, TSM_FAIL },
+    { "a[bc]+d", "abcbd", TSM_FLAG_NONE, TSM_OK },  // bit-parallel
+    { "a[bc]+d", "abcbdx", TSM_FLAG_NONE, TSM_FAIL },
+    { "a\\dc", "a1c", TSM_FLAG_NONE, TSM_OK },
+    { "a\\dc", "xa1c", TSM_FLAG_NONE, TSM_FAIL },
+    { "ABC", "abc", TSM_FLAG_ICASE, TSM_OK },
+    { "a?", "", TSM_FLAG_NONE, TSM_OK },
+    { "\\d{2,3}", "123", TSM_FLAG_NONE, TSM_OK },  // lazy, but should reach the end
+    { "\\d{2,3}", "1234", TSM_FLAG_NONE, TSM_FAIL },
+    { "cat|dog", "dog", TSM_FLAG_NONE, TSM_OK },  // bytecode VM
+    { "cat|dog", "dogs", TSM_FLAG_NONE, TSM_FAIL },
+    { "a|ab", "ab", TSM_FLAG_NONE, TSM_OK },
+    { "a*|b", "aab", TSM_FLAG_NONE, TSM_FAIL },
+    { "x|a?ab", "aab", TSM_FLAG_NONE, TSM_OK },
+    { "x|a*a*b", "aaab", TSM_FLAG_MEMOIZE, TSM_OK },  // backtracking
+    { "x|a*a*b", "aaabb", TSM_FLAG_MEMOIZE, TSM_FAIL },
+    { "a$b", "ab", TSM_FLAG_NONE, TSM_FAIL },
+    { "a.*", "ab\x81", TSM_FLAG_NONE, TSM_FAIL },  // bad rune
+    { "x|a.*", "ab\x81", TSM_FLAG_NONE, TSM_FAIL },
+    { "a.*", "ab\x81", TSM_FLAG_BYTES, TSM_OK },
+    { "x|a.*", "ab\x81", TSM_FLAG_BYTES, TSM_OK },
+    { "^a\\d\xe4$", "a1\xe4", TSM_FLAG_BYTES, TSM_OK },
+};
+
+INSTANTIATE_TEST_SUITE_P(RegexFullmatchTestInstantiation,
+    RegexFullmatchTest,
+    ::testing::ValuesIn(regex_cases_fullmatch));
+
+TEST_P(RegexFullmatchTest, tsm_regex_fullmatch) {
+    const RegexFlagCase test_case = GetParam();
+    if (test_case.flags & (TSM_FLAG_ICASE | TSM_FLAG_BYTES))
+        return;
+    int actual = tsm_regex_fullmatch(test_case.pattern, test_case.str);
+    EXPECT_EQ(test_case.expected, actual)
+        << "\npattern: " << test_case.pattern << ", str: " << test_case.str << "\n";
+}
+
+TEST_P(RegexFullmatchTest, tsm_regex_fullmatch_compiled) {
+    const RegexFlagCase test_case = GetParam();
+    TsmRegex *compiled;
+    int actual = tsm_regex_compile(test_case.pattern, test_case.flags, &compiled);
+    if (actual == TSM_OK) {
+        actual = tsm_regex_fullmatch_compiled(compiled, test_case.str);
+        tsm_regex_free(compiled);
+    }
+    EXPECT_EQ(test_case.expected, actual)
+        << "\npattern: " << test_case.pattern << ", str: " << test_case.str
+        << ", flags: " << test_case.flags << "\n";
+}
+
+TEST_P(RegexFullmatchTest, tsm_regex_fullmatch_compiled_jit) {
+    const RegexFlagCase test_case = GetParam();
+    int actual = match_jit(test_case.pattern, test_case.str, test_case.flags, 1);
+    EXPECT_EQ(test_case.expected, actual)
+        << "\npattern: " << test_case.pattern << ", str: " << test_case.str
+        << ", flags: " << test_case.flags << "\n";
+}
+
+TEST(RegexFullmatchNullTest, tsm_regex_fullmatch) {
+    TsmRegex *compiled;
+    EXPECT_EQ(TSM_FAIL, tsm_regex_fullmatch(NULL, "a"));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_fullmatch("a", NULL));
+    EXPECT_EQ(TSM_SYNTAX_ERROR, tsm_regex_fullmatch("[a", "a"));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_fullmatch_compiled(NULL, "a"));
+    ASSERT_EQ(TSM_OK, tsm_regex_compile("a", TSM_FLAG_NONE, &compiled));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_fullmatch_compiled(compiled, NULL));
+    tsm_regex_free(compiled);
+}
+
+struct RegexWideCase {
+    const char *pattern;
+    const char16_t *str16;
+    const char32_t *str32;
+    int flags;
+    int expected;
+};
+
+class RegexWideTest : public ::testing::TestWithParam<RegexWideCase> {
+};
+
+// Test with utf-16 and utf-32 strings. Each engine should give the same results as utf-8.
+const RegexWideCase regex_cases_wide[] = {
+    { "abc", u"xabcx", U"xabcx", TSM_FLAG_NONE, TSM_OK },  // literal
+    { "abc", u"xabx", U"xabx", TSM_FLAG_NONE, TSM_FAIL },
+    { "^abc$", u"abc", U"abc", TSM_FLAG_NONE, TSM_OK },
+    { "^abc$", u"abcd", U"abcd", TSM_FLAG_NONE, TSM_FAIL },
+    { "a[bc]+d", u"xabcbd", U"xabcbd", TSM_FLAG_NONE, TSM_OK },  // bit-parallel
+    { "cat|dog", u"hotdog", U"hotdog", TSM_FLAG_NONE, TSM_OK },  // bytecode VM
+    { "cat|dog", u"cow", U"cow", TSM_FLAG_NONE, TSM_FAIL },
+    { "x|^a", u"ba", U"ba", TSM_FLAG_NONE, TSM_FAIL },
+    { "x|a$", u"ba", U"ba", TSM_FLAG_NONE, TSM_OK },
+    { "x|\\d{2,3}", u"a12", U"a12", TSM_FLAG_NONE, TSM_OK },
+    { "x|^.$", u"\u3042", U"\u3042", TSM_FLAG_NONE, TSM_OK },
+    { "x|^.$", u"\U0001F600", U"\U0001F600", TSM_FLAG_NONE, TSM_OK },  // surrogate pair
+    { "x|^..$", u"\U0001F600", U"\U0001F600", TSM_FLAG_NONE, TSM_FAIL },
+    { u8"x|^[\U0001F600-\U0001F64F]+$", u"\U0001F600\U0001F64F", U"\U0001F600\U0001F64F",
+      TSM_FLAG_NONE, TSM_OK },
+    { u8"x|^\u00e4+$", u"\u00c4\u00e4", U"\u00c4\u00e4", TSM_FLAG_ICASE, TSM_OK },
+    { "x|^\\d+$", u"\u0661\u0662", U"\u0661\u0662", TSM_FLAG_UNICODE, TSM_OK },
+    { "x|a*a*b", u"aaab", U"aaab", TSM_FLAG_MEMOIZE, TSM_OK },  // backtracking
+    { "x|a*a*b", u"\u3042aab", U"\u3042aab", TSM_FLAG_MEMOIZE, TSM_OK },
+    { "a$b", u"ab", U"ab", TSM_FLAG_NONE, TSM_FAIL },
+    { "x|a.*b", u"a\xD800" u"b", U"a\xD800" U"b", TSM_FLAG_NONE, TSM_FAIL },  // unpaired surrogate
+    { "x|a.*b", u"a\xDC00" u"b", U"a\xDC00" U"b", TSM_FLAG_NONE, TSM_FAIL },  // lone low surrogates
+    { "x|a.*b", u"a\xDC00" u"b", U"a\xDC00" U"b", TSM_FLAG_MEMOIZE, TSM_FAIL },
+    { "x|ab", u"ab\xD800", U"ab\xD800", TSM_FLAG_NONE, TSM_FAIL },  // right after the match
+};
+
+INSTANTIATE_TEST_SUITE_P(RegexWideTestInstantiation,
+    RegexWideTest,
+    ::testing::ValuesIn(regex_cases_wide));
+
+TEST_P(RegexWideTest, tsm_regex_match_utf16) {
+    const RegexWideCase test_case = GetParam();
+    std::u16string str(test_case.str16);
+    TsmRegex *compiled;
+    int actual = tsm_regex_compile(test_case.pattern, test_case.flags, &compiled);
+    if (actual == TSM_OK) {
+        actual = tsm_regex_match_utf16(compiled, (const uint16_t *)str.data(), str.size());
+        tsm_regex_free(compiled);
+    }
+    EXPECT_EQ(test_case.expected, actual)
+        << "\npattern: " << test_case.pattern << ", flags: " << test_case.flags << "\n";
+}
+
+TEST_P(RegexWideTest, tsm_regex_match_utf32) {
+    const RegexWideCase test_case = GetParam();
+    std::u32string str(test_case.str32);
+    TsmRegex *compiled;
+    int actual = tsm_regex_compile(test_case.pattern, test_case.flags, &compiled);
+    if (actual == TSM_OK) {
+        actual = tsm_regex_match_utf32(compiled, (const uint32_t *)str.data(), str.size());
+        tsm_regex_free(compiled);
+    }
+    EXPECT_EQ(test_case.expected, actual)
+        << "\npattern: " << test_case.pattern << ", flags: " << test_case.flags << "\n";
+}
+
+TEST(RegexWideNullTest, tsm_regex_match_utf16) {
+    const uint16_t str16[] = { 'a', 0, 'b' };  // lengths allow NUL characters
+    const uint32_t str32[] = { 'a', 0, 'b' };
+    const uint32_t bad32[] = { 'a', 0x110000, 'b' };  // beyond U+10FFFF
+    TsmRegex *compiled;
+    ASSERT_EQ(TSM_OK, tsm_regex_compile("x|b", TSM_FLAG_NONE, &compiled));
+    EXPECT_EQ(TSM_OK, tsm_regex_match_utf16(compiled, str16, 3));
+    EXPECT_EQ(TSM_OK, tsm_regex_match_utf32(compiled, str32, 3));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_match_utf32(compiled, bad32, 3));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_match_utf16(compiled, str16, 2));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_match_utf16(compiled, NULL, 0));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_match_utf32(compiled, NULL, 0));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_match_utf16(NULL, str16, 3));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_match_utf32(NULL, str32, 3));
+    tsm_regex_free(compiled);
+    ASSERT_EQ(TSM_OK, tsm_regex_compile("x|b", TSM_FLAG_BYTES, &compiled));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_match_utf16(compiled, str16, 3));  // not bytes
+    tsm_regex_free(compiled);
+}
+
+struct RegexStrategyCase {
+    const char *pattern;
+    int flags;
+    TsmStrategy expected;
+};
+
+class RegexStrategyTest : public ::testing::TestWithParam<RegexStrategyCase> {
+};
+
+#if defined(__x86_64__) && defined(__linux__) && !defined(TSM_NO_JIT) && !defined(TSM_PROFILE)
+#define TEST_STRATEGY_JIT TSM_STRATEGY_JIT
+#else
+#define TEST_STRATEGY_JIT TSM_STRATEGY_VM
+#endif
+
+// Test with engine selection.
+const RegexStrategyCase regex_cases_strategy[] = {
+    { "abc", TSM_FLAG_NONE, TSM_STRATEGY_LITERAL },
+    { u8"\u3042\\.", TSM_FLAG_NONE, TSM_STRATEGY_LITERAL },
+    { "^abc", TSM_FLAG_NONE, TSM_STRATEGY_PREFIX },
+    { "abc$", TSM_FLAG_NONE, TSM_STRATEGY_SUFFIX },
+    { "^abc$", TSM_FLAG_NONE, TSM_STRATEGY_EXACT },
+    { "123", TSM_FLAG_ICASE, TSM_STRATEGY_LITERAL },  // no cases
+    { "abc", TSM_FLAG_ICASE, TSM_STRATEGY_BNDM },
+    { "a\\dc", TSM_FLAG_NONE, TSM_STRATEGY_BNDM },
+    { "a[bc]d", TSM_FLAG_NONE, TSM_STRATEGY_SHIFT_AND },  // classes can have multi-byte characters
+    { "^a[bc]+d", TSM_FLAG_NONE, TSM_STRATEGY_SHIFT_AND },
+    { "abc|def", TSM_FLAG_NONE, TSM_STRATEGY_VM },
+    { "\\d{1,70}", TSM_FLAG_NONE, TSM_STRATEGY_VM },
+    { "abc|def", TSM_FLAG_MEMOIZE, TSM_STRATEGY_BACKTRACK },
+    { "a$b", TSM_FLAG_NONE, TSM_STRATEGY_BACKTRACK },  // misplaced anchors
+    { "a**", TSM_FLAG_NONE, TSM_STRATEGY_BACKTRACK },
+    { "\xe4", TSM_FLAG_BYTES, TSM_STRATEGY_LITERAL },
+    { "a.c", TSM_FLAG_NONE, TSM_STRATEGY_SHIFT_AND },  // '.' matches multi-byte characters
+    { "a.c", TSM_FLAG_BYTES, TSM_STRATEGY_BNDM },  // but not in byte mode
+    { "\xe4" "b", TSM_FLAG_BYTES | TSM_FLAG_ICASE, TSM_STRATEGY_BNDM },
+    { "abc|def", TSM_FLAG_JIT, TEST_STRATEGY_JIT },
+    { "abc|def", TSM_FLAG_JIT | TSM_FLAG_BYTES, TEST_STRATEGY_JIT },
+    { "a\\dc", TSM_FLAG_JIT, TSM_STRATEGY_BNDM },  // searches still use the machine code
+    { "abc", TSM_FLAG_JIT, TSM_STRATEGY_LITERAL },
+    { "abc|def", TSM_FLAG_JIT | TSM_FLAG_MEMOIZE, TSM_STRATEGY_BACKTRACK },
+    { "a*+b", TSM_FLAG_NONE, TSM_STRATEGY_VM },  // possessive
+    { "a*+b|c", TSM_FLAG_JIT, TSM_STRATEGY_VM },
+    { "x|\\w*\\w*!", TSM_FLAG_SAFE, TSM_STRATEGY_BACKTRACK },  // memoized
+    { "x|\\d*[a-z]*!", TSM_FLAG_SAFE, TSM_STRATEGY_VM },  // linear
+};
+
+INSTANTIATE_TEST_SUITE_P(RegexStrategyTestInstantiation,
+    RegexStrategyTest,
+    ::testing::ValuesIn(regex_cases_strategy));
+
+TEST_P(RegexStrategyTest, tsm_regex_strategy) {
+    const RegexStrategyCase test_case = GetParam();
+    TsmRegex *compiled;
+    ASSERT_EQ(TSM_OK, tsm_regex_compile(test_case.pattern, test_case.flags, &compiled));
+    EXPECT_EQ(test_case.expected, tsm_regex_strategy(compiled))
+        << "\npattern: " << test_case.pattern << ", flags: " << test_case.flags << "\n";
+    tsm_regex_free(compiled);
+}
+
+struct RegexComplexityCase {
+    const char *pattern;
+    int flags;
+    int expected;
+};
+
+class RegexComplexityTest : public ::testing::TestWithParam<RegexComplexityCase> {
+};
+
+// Test with degrees of backtracking time.
+const RegexComplexityCase regex_cases_complexity[] = {
+    { "abc", TSM_FLAG_NONE, 1 },
+    { "\\w*!", TSM_FLAG_NONE, 1 },
+    { "\\w*\\w*!", TSM_FLAG_NONE, 2 },
+    { "\\w*\\w*\\w*!", TSM_FLAG_NONE, 3 },
+    { ".*.*=.*", TSM_FLAG_NONE, 3 },
+    { "\\d+\\s*\\d+", TSM_FLAG_NONE, 2 },  // optional atoms between them
+    { "\\w*x\\w*!", TSM_FLAG_NONE, 2 },  // 'x' is a word character
+    { "\\w*!\\w*", TSM_FLAG_NONE, 1 },
+    { "\\d*[a-z]*!", TSM_FLAG_NONE, 1 },  // no common characters
+    { "^\\s*\\S+\\s*$", TSM_FLAG_NONE, 1 },
+    { "a+b+a+", TSM_FLAG_NONE, 1 },
+    { "a{2,}a{2,}b", TSM_FLAG_NONE, 2 },
+    { "\\d{1,70}\\d{1,70}!", TSM_FLAG_NONE, 1 },  // bounded
+    { "\\w*+\\w*!", TSM_FLAG_NONE, 1 },  // possessive
+    { "\\w*\\w*+!", TSM_FLAG_NONE, 2 },  // scans the rest after each backtrack
+    { "x|\\w+\\w+", TSM_FLAG_NONE, 2 },
+    { "a*|a*b", TSM_FLAG_NONE, 1 },  // branches don't share loops
+    { "a|", TSM_FLAG_NONE, 1 },
+    { u8"[あ-ん]*[い-う]*!", TSM_FLAG_NONE, 2 },
+    { "A*a*!", TSM_FLAG_NONE, 1 },
+    { "A*a*!", TSM_FLAG_ICASE, 2 },
+    { u8"\\w*[é]*!", TSM_FLAG_NONE, 1 },
+    { u8"\\w*[é]*!", TSM_FLAG_UNICODE, 2 },
+    { "\xe4*\xe4*b", TSM_FLAG_BYTES, 2 },
+};
+
+INSTANTIATE_TEST_SUITE_P(RegexComplexityTestInstantiation,
+    RegexComplexityTest,
+    ::testing::ValuesIn(regex_cases_complexity));
+
+TEST_P(RegexComplexityTest, tsm_regex_complexity) {
+    const RegexComplexityCase test_case = GetParam();
+    TsmRegex *compiled;
+    ASSERT_EQ(TSM_OK, tsm_regex_compile(test_case.pattern, test_case.flags, &compiled));
+    EXPECT_EQ(test_case.expected, tsm_regex_complexity(compiled))
+        << "\npattern: " << test_case.pattern << ", flags: " << test_case.flags << "\n";
+    tsm_regex_free(compiled);
+}
+
+TEST(RegexComplexityTest, tsm_regex_compile_safe) {
+    // Plain backtracking takes O(n^3) steps for each start position.
+    std::string str(1 << 11, 'a');
+    TsmRegex *compiled;
+    EXPECT_EQ(0, tsm_regex_complexity(NULL));
+    ASSERT_EQ(TSM_OK, tsm_regex_compile("x|\\w*\\w*\\w*!", TSM_FLAG_SAFE, &compiled));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_match_compiled(compiled, str.c_str()));
+    str += "!";
+    EXPECT_EQ(TSM_OK, tsm_regex_match_compiled(compiled, str.c_str()));
+    tsm_regex_free(compiled);
+}
+
+struct RegexTraceCounts {
+    uint64_t events[3];
+    size_t first_offset;
+};
+
+static void count_trace(void *user, TsmTraceEvent event, int obj, size_t offset) {
+    RegexTraceCounts *counts = (RegexTraceCounts *)user;
+    (void)obj;
+    if (counts->events[0] + counts->events[1] + counts->events[2] == 0)
+        counts->first_offset = offset;
+    counts->events[event]++;
+}
+
+#ifdef TSM_PROFILE
+TEST(RegexStatsTest, tsm_regex_stats) {
+    // The VM and the backtracker try the same start positions.
+    const int flags[] = { TSM_FLAG_NONE, TSM_FLAG_MEMOIZE };
+    for (int f : flags) {
+        TsmRegex *compiled;
+        TsmStats stats;
+        ASSERT_EQ(TSM_OK, tsm_regex_compile("a+b|c", f, &compiled));
+        EXPECT_EQ(TSM_OK, tsm_regex_match_compiled(compiled, "aac"));
+        EXPECT_EQ(TSM_FAIL, tsm_regex_match_compiled(compiled, "aa"));
+        ASSERT_EQ(TSM_OK, tsm_regex_stats(compiled, &stats));
+        EXPECT_EQ(2u, stats.calls) << "flags: " << f;
+        EXPECT_EQ(6u, stats.starts) << "flags: " << f;  // 3 for "aac" and 3 for "aa"
+        EXPECT_GT(stats.steps, 0u) << "flags: " << f;
+        EXPECT_GT(stats.backtracks, 0u) << "flags: " << f;
+        EXPECT_EQ(0u, stats.rejects) << "flags: " << f;
+        tsm_regex_free(compiled);
+    }
+}
+
+TEST(RegexStatsTest, tsm_regex_stats_early) {
+    // Boolean matches don't look for the end of the match.
+    const int flags[] = { TSM_FLAG_NONE, TSM_FLAG_MEMOIZE };
+    for (int f : flags) {
+        TsmRegex *compiled;
+        TsmStats stats;
+        ASSERT_EQ(TSM_OK, tsm_regex_compile("x|ab*", f, &compiled));
+        EXPECT_EQ(TSM_OK, tsm_regex_match_compiled(compiled, "abbbbbbbb"));
+        ASSERT_EQ(TSM_OK, tsm_regex_stats(compiled, &stats));
+        EXPECT_EQ(2u, stats.steps) << "flags: " << f;  // 'x' and 'a'
+        EXPECT_EQ(0u, stats.backtracks) << "flags: " << f;
+        tsm_regex_free(compiled);
+    }
+}
+
+TEST(RegexStatsTest, tsm_regex_stats_rejects) {
+    TsmRegex *compiled;
+    TsmStats stats;
+    ASSERT_EQ(TSM_OK, tsm_regex_compile("abc", TSM_FLAG_NONE, &compiled));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_match_compiled(compiled, "xyz"));
+    EXPECT_EQ(TSM_OK, tsm_regex_match_compiled(compiled, "xabc"));
+    ASSERT_EQ(TSM_OK, tsm_regex_stats(compiled, &stats));
+    EXPECT_EQ(2u, stats.calls);
+    EXPECT_EQ(1u, stats.rejects);
+    EXPECT_EQ(0u, stats.starts);
+
+    ASSERT_EQ(TSM_OK, tsm_regex_stats_reset(compiled));
+    ASSERT_EQ(TSM_OK, tsm_regex_stats(compiled, &stats));
+    EXPECT_EQ(0u, stats.calls);
+    EXPECT_EQ(0u, stats.rejects);
+    EXPECT_EQ(0u, stats.nanos);
+    tsm_regex_free(compiled);
+}
+
+TEST(RegexStatsTest, tsm_regex_stats_count) {
+    // Each count is one call, with or without the fast paths.
+    const char *patterns[] = { "abc", "a\\dc", "b+|c", "x*" };
+    for (const char *pattern : patterns) {
+        TsmRegex *compiled;
+        TsmStats stats;
+        size_t count;
+        ASSERT_EQ(TSM_OK, tsm_regex_compile(pattern, TSM_FLAG_NONE, &compiled));
+        EXPECT_EQ(TSM_OK, tsm_regex_count(compiled, "abcbca1c", 8, &count));
+        EXPECT_EQ(TSM_FAIL, tsm_regex_count(compiled, "abc\x81", 4, &count));
+        ASSERT_EQ(TSM_OK, tsm_regex_stats(compiled, &stats));
+        EXPECT_EQ(2u, stats.calls) << "pattern: " << pattern;
+        tsm_regex_free(compiled);
+    }
+}
+
+TEST(RegexStatsTest, tsm_regex_set_trace) {
+    const int flags[] = { TSM_FLAG_NONE, TSM_FLAG_MEMOIZE };
+    for (int f : flags) {
+        TsmRegex *compiled;
+        TsmStats stats;
+        RegexTraceCounts counts = {};
+        TsmMatch match;
+        ASSERT_EQ(TSM_OK, tsm_regex_compile("\\d+x|y", f, &compiled));
+        ASSERT_EQ(TSM_OK, tsm_regex_set_trace(compiled, count_trace, &counts));
+        EXPECT_EQ(TSM_OK, tsm_regex_search(compiled, "--12y", 5, 2, &match));
+        EXPECT_EQ(4u, match.start);
+        ASSERT_EQ(TSM_OK, tsm_regex_stats(compiled, &stats));
+        EXPECT_EQ(stats.starts, counts.events[TSM_TRACE_START]) << "flags: " << f;
+        EXPECT_EQ(stats.steps, counts.events[TSM_TRACE_STEP]) << "flags: " << f;
+        EXPECT_EQ(stats.backtracks, counts.events[TSM_TRACE_BACKTRACK]) << "flags: " << f;
+        EXPECT_EQ(3u, stats.starts) << "flags: " << f;
+        EXPECT_EQ(2u, counts.first_offset) << "flags: " << f;  // offsets are from the buffer
+
+        ASSERT_EQ(TSM_OK, tsm_regex_set_trace(compiled, NULL, NULL));
+        EXPECT_EQ(TSM_OK, tsm_regex_match_compiled(compiled, "1x"));
+        EXPECT_EQ(3u, counts.events[TSM_TRACE_START]) << "flags: " << f;
+        tsm_regex_free(compiled);
+    }
+}
+#else
+TEST(RegexStatsTest, tsm_regex_stats_disabled) {
+    TsmRegex *compiled;
+    TsmStats stats;
+    RegexTraceCounts counts = {};
+    ASSERT_EQ(TSM_OK, tsm_regex_compile("abc", TSM_FLAG_NONE, &compiled));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_stats(compiled, &stats));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_stats_reset(compiled));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_set_trace(compiled, count_trace, &counts));
+    tsm_regex_free(compiled);
+}
+#endif
+
+TEST(RegexStatsNullTest, tsm_regex_stats) {
+    TsmStats stats;
+    EXPECT_EQ(TSM_FAIL, tsm_regex_stats(NULL, &stats));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_stats_reset(NULL));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_set_trace(NULL, count_trace, NULL));
+}
@@ -0,0 +1,480 @@
+#pragma once
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <gtest/gtest.h>
+#include "str_match.h"
+
+#ifndef TSM_MIN_CHUNK_SIZE
+#define TSM_MIN_CHUNK_SIZE 65536  // the default of src/parallel.c
+#endif
+
+
+struct SearchCase {
+    const char *pattern;
+    const char *str;
+    size_t offset;
+    int expected;
+    size_t start;
+    size_t end;
+};
+
+class SearchTest : public ::testing::TestWithParam<SearchCase> {
+};
+
+// Test with match positions.
+const SearchCase search_cases[] = {
+    { "abc", "xxabcxx", 0, TSM_OK, 2, 5 },
+    { "abc", "xxabcxx", 3, TSM_FAIL, 0, 0 },
+    { "a+", "baaab", 0, TSM_OK, 1, 4 },
+    { "a*", "baaab", 0, TSM_OK, 0, 0 },
+    { "a*", "baaab", 1, TSM_OK, 1, 4 },
+    { "x|ab", "abx", 0, TSM_OK, 0, 2 },  // leftmost of all branches
+    { "ab|a", "abx", 0, TSM_OK, 0, 2 },  // the first branch wins at the same position
+    { "^ab", "abab", 1, TSM_FAIL, 0, 0 },  // '^' matches only at the beginning of the buffer
+    { "ab$", "abab", 0, TSM_OK, 2, 4 },
+    { "b$", "ab", 0, TSM_OK, 1, 2 },
+    { "$", "ab", 0, TSM_OK, 2, 2 },
+    { "a?", "", 0, TSM_OK, 0, 0 },
+    { "\\d{2,3}", "a12345", 0, TSM_OK, 1, 3 },  // '{n,m}' is lazy
+    { "\\d{2,3}$", "a12345", 0, TSM_OK, 3, 6 },
+    { "\\d+", "a12345", 0, TSM_OK, 1, 6 },
+    { u8"あ.", u8"xあいう", 0, TSM_OK, 1, 7 },
+    { "b", "a\x81" "b", 0, TSM_FAIL, 0, 0 },  // bad rune before the match
+    { "a", "a\x81", 0, TSM_FAIL, 0, 0 },  // bad rune right after the match
+    { "b+|a+", "xaabb", 0, TSM_OK, 1, 3 },
+    { "b+|a+", "xaabb", 3, TSM_OK, 3, 5 },
+    { "^a|b", "ab", 1, TSM_OK, 1, 2 },
+    { "x|a{2,3}", "aaaa", 0, TSM_OK, 0, 2 },
+};
+
+INSTANTIATE_TEST_SUITE_P(SearchTestInstantiation,
+    SearchTest,
+    ::testing::ValuesIn(search_cases));
+
+TEST_P(SearchTest, tsm_regex_search) {
+    const SearchCase test_case = GetParam();
+    TsmRegex *compiled;
+    TsmMatch match = { 0, 0 };
+    ASSERT_EQ(TSM_OK, tsm_regex_compile(test_case.pattern, TSM_FLAG_NONE, &compiled));
+    int actual = tsm_regex_search(compiled, test_case.str, strlen(test_case.str),
+                                  test_case.offset, &match);
+    tsm_regex_free(compiled);
+    EXPECT_EQ(test_case.expected, actual)
+        << "\npattern: " << test_case.pattern << ", str: " << test_case.str << "\n";
+    if (actual == TSM_OK) {
+        EXPECT_EQ(test_case.start, match.start);
+        EXPECT_EQ(test_case.end, match.end);
+    }
+}
+
+// Counts matches with tsm_regex_search().
+static size_t count_sequential(const TsmRegex *compiled, const std::string& str) {
+    size_t count = 0;
+    size_t pos = 0;
+    TsmMatch match;
+    while (pos <= str.size() &&
+           tsm_regex_search(compiled, str.c_str(), str.size(), pos, &match) == TSM_OK) {
+        count++;
+        if (match.end > match.start)
+            pos = match.end;
+        else
+            pos = match.start + 1;  // ASCII only
+    }
+    return count;
+}
+
+struct ParallelCase {
+    const char *pattern;
+    const char *unit;  // the buffer repeats it
+    size_t repeat;
+};
+
+class ParallelTest : public ::testing::TestWithParam<ParallelCase> {
+};
+
+// Test with large buffers. The units have odd lengths to move matches over chunk boundaries.
+const ParallelCase parallel_cases[] = {
+    { "abc", "xxabcxx", 100000 },
+    { "b+", "abbbbbbbbbbbbba", 50000 },
+    { "x*", "axxa", 200000 },
+    { "a.*b", "a.......b...", 60000 },  // every match runs over the buffer
+    { "a[^b]{1,20}b", "xa0123456789b", 60000 },
+    { "zzz", "abcdefg", 100000 },  // no matches
+    { "^abc", "abcx", 100000 },
+    { "c$", "abc", 100000 },
+};
+
+INSTANTIATE_TEST_SUITE_P(ParallelTestInstantiation,
+    ParallelTest,
+    ::testing::ValuesIn(parallel_cases));
+
+TEST_P(ParallelTest, tsm_regex_search_parallel) {
+    const ParallelCase test_case = GetParam();
+    std::string str;
+    for (size_t i = 0; i < test_case.repeat; i++)
+        str += test_case.unit;
+
+    TsmRegex *compiled;
+    ASSERT_EQ(TSM_OK, tsm_regex_compile(test_case.pattern, TSM_FLAG_NONE, &compiled));
+    TsmMatch expected = { 0, 0 };
+    int expected_res = tsm_regex_search(compiled, str.c_str(), str.size(), 0, &expected);
+    for (int threads = 1; threads <= 8; threads *= 2) {
+        TsmMatch actual = { 0, 0 };
+        EXPECT_EQ(expected_res, tsm_regex_search_parallel(compiled, str.c_str(), str.size(),
+                                                          threads, &actual));
+        EXPECT_EQ(expected.start, actual.start) << "threads: " << threads;
+        EXPECT_EQ(expected.end, actual.end) << "threads: " << threads;
+    }
+    tsm_regex_free(compiled);
+}
+
+// Test with chunks of several search blocks. Later chunks stop when the first one finds a match.
+TEST(ParallelSearchTest, tsm_regex_search_parallel_blocks) {
+    std::string str(6 << 20, 'x');
+    str.replace(str.size() - 100, 9, "ERROR 7 \xff");
+    TsmRegex *compiled;
+    ASSERT_EQ(TSM_OK, tsm_regex_compile("ERROR \\d+", TSM_FLAG_NONE, &compiled));
+    for (int threads = 1; threads <= 4; threads++) {
+        TsmMatch match = { 0, 0 };
+        str.replace(100, 8, "ERROR 42");
+        EXPECT_EQ(TSM_OK, tsm_regex_search_parallel(compiled, str.c_str(), str.size(),
+                                                    threads, &match));
+        EXPECT_EQ(100u, match.start) << "threads: " << threads;
+        EXPECT_EQ(108u, match.end) << "threads: " << threads;
+        str.replace(100, 8, "xxxxxxxx");  // the match of the last block
+        EXPECT_EQ(TSM_OK, tsm_regex_search_parallel(compiled, str.c_str(), str.size(),
+                                                    threads, &match));
+        EXPECT_EQ(str.size() - 100, match.start) << "threads: " << threads;
+    }
+    tsm_regex_free(compiled);
+}
+
+TEST_P(ParallelTest, tsm_regex_count_parallel) {
+    const ParallelCase test_case = GetParam();
+    std::string str;
+    for (size_t i = 0; i < test_case.repeat; i++)
+        str += test_case.unit;
+
+    TsmRegex *compiled;
+    ASSERT_EQ(TSM_OK, tsm_regex_compile(test_case.pattern, TSM_FLAG_NONE, &compiled));
+    size_t expected = count_sequential(compiled, str);
+    for (int threads = 0; threads <= 8; threads++) {
+        size_t actual = 0;
+        EXPECT_EQ(TSM_OK, tsm_regex_count_parallel(compiled, str.c_str(), str.size(),
+                                                   threads, &actual));
+        EXPECT_EQ(expected, actual) << "threads: " << threads;
+    }
+    tsm_regex_free(compiled);
+}
+
+TEST_P(ParallelTest, tsm_regex_count) {
+    const ParallelCase test_case = GetParam();
+    std::string str;
+    for (size_t i = 0; i < test_case.repeat; i++)
+        str += test_case.unit;
+
+    TsmRegex *compiled;
+    ASSERT_EQ(TSM_OK, tsm_regex_compile(test_case.pattern, TSM_FLAG_NONE, &compiled));
+    size_t actual = 0;
+    EXPECT_EQ(TSM_OK, tsm_regex_count(compiled, str.c_str(), str.size(), &actual));
+    EXPECT_EQ(count_sequential(compiled, str), actual);
+    tsm_regex_free(compiled);
+}
+
+struct CountCase {
+    const char *pattern;
+    const char *str;
+    int flags;
+    int expected;
+    size_t count;
+};
+
+class CountTest : public ::testing::TestWithParam<CountCase> {
+};
+
+// Test with the number of matches.
+const CountCase count_cases[] = {
+    { "abc", "abcabcab", TSM_FLAG_NONE, TSM_OK, 2 },  // literal
+    { "aa", "aaaaa", TSM_FLAG_NONE, TSM_OK, 2 },  // non-overlapping
+    { "abc", "\x81" "abc", TSM_FLAG_NONE, TSM_FAIL, 0 },  // bad rune before matches
+    { "abc", "abc\x81", TSM_FLAG_NONE, TSM_FAIL, 0 },  // bad rune right after the match
+    { "abc", "abcab\x81", TSM_FLAG_NONE, TSM_FAIL, 0 },
+    { "a\\dc", "a1ca2cxa3c", TSM_FLAG_NONE, TSM_OK, 3 },  // BNDM
+    { "a\\dc", "a1ca2ca3ca", TSM_FLAG_NONE, TSM_OK, 3 },
+    { "\\d\\d", "12345", TSM_FLAG_NONE, TSM_OK, 2 },
+    { "a\\dc", "a1c\x81", TSM_FLAG_NONE, TSM_FAIL, 0 },
+    { "a\\dc", u8"a1cあa2c", TSM_FLAG_NONE, TSM_OK, 2 },
+    { "a+", "baaabaa", TSM_FLAG_NONE, TSM_OK, 2 },  // bytecode VM
+    { "x*", "abc", TSM_FLAG_NONE, TSM_OK, 4 },  // empty matches
+    { "b*", "abc", TSM_FLAG_NONE, TSM_OK, 4 },
+    { "b+|c", "abbcb", TSM_FLAG_NONE, TSM_OK, 3 },
+    { "^a", "aaa", TSM_FLAG_NONE, TSM_OK, 1 },
+    { "a$", "aaa", TSM_FLAG_NONE, TSM_OK, 1 },
+    { "a+", "baaabaa", TSM_FLAG_MEMOIZE, TSM_OK, 2 },  // backtracking
+    { "\xff.", "\xff\x81\xff" "a\xff", TSM_FLAG_BYTES, TSM_OK, 2 },
+    { "\xff\x81", "\xff\x81\xff\x81", TSM_FLAG_BYTES, TSM_OK, 2 },
+};
+
+INSTANTIATE_TEST_SUITE_P(CountTestInstantiation,
+    CountTest,
+    ::testing::ValuesIn(count_cases));
+
+TEST_P(CountTest, tsm_regex_count) {
+    const CountCase test_case = GetParam();
+    TsmRegex *compiled;
+    size_t count = 0;
+    ASSERT_EQ(TSM_OK, tsm_regex_compile(test_case.pattern, test_case.flags, &compiled));
+    int actual = tsm_regex_count(compiled, test_case.str, strlen(test_case.str), &count);
+    EXPECT_EQ(test_case.expected, actual)
+        << "\npattern: " << test_case.pattern << ", str: " << test_case.str << "\n";
+    if (actual == TSM_OK) {
+        EXPECT_EQ(test_case.count, count);
+    }
+    // Build with a small min_chunk_size to split these buffers.
+    for (int threads = 1; threads <= 4; threads++) {
+        size_t parallel_count = 0;
+        EXPECT_EQ(actual, tsm_regex_count_parallel(compiled, test_case.str,
+                                                   strlen(test_case.str), threads,
+                                                   &parallel_count))
+            << "\npattern: " << test_case.pattern << ", threads: " << threads << "\n";
+        EXPECT_EQ(count, parallel_count);
+    }
+    tsm_regex_free(compiled);
+}
+
+TEST(CountTest, tsm_regex_count_parallel_anchored) {
+    // The second chunk starts with invalid utf-8, but the search stops after the first match.
+    std::string str(2 * TSM_MIN_CHUNK_SIZE, 'b');
+    str[0] = 'a';
+    str[TSM_MIN_CHUNK_SIZE] = '\xff';
+    TsmRegex *compiled;
+    ASSERT_EQ(TSM_OK, tsm_regex_compile("^a{1,3}", TSM_FLAG_NONE, &compiled));
+    size_t count = 0;
+    EXPECT_EQ(TSM_OK, tsm_regex_count(compiled, str.c_str(), str.size(), &count));
+    EXPECT_EQ(1u, count);
+    for (int threads = 1; threads <= 4; threads++) {
+        size_t parallel_count = 0;
+        EXPECT_EQ(TSM_OK, tsm_regex_count_parallel(compiled, str.c_str(), str.size(),
+                                                   threads, &parallel_count));
+        EXPECT_EQ(1u, parallel_count) << "threads: " << threads;
+    }
+    tsm_regex_free(compiled);
+}
+
+TEST(CountTest, tsm_regex_count_null) {
+    const char str[] = "a1c\0a2c";  // NUL characters in the buffer
+    TsmRegex *compiled;
+    size_t count = 0;
+    ASSERT_EQ(TSM_OK, tsm_regex_compile("a\\dc", TSM_FLAG_NONE, &compiled));
+    EXPECT_EQ(TSM_OK, tsm_regex_count(compiled, str, sizeof(str) - 1, &count));
+    EXPECT_EQ(2u, count);
+    EXPECT_EQ(TSM_FAIL, tsm_regex_count(NULL, str, sizeof(str) - 1, &count));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_count(compiled, NULL, 0, &count));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_count(compiled, str, sizeof(str) - 1, NULL));
+    tsm_regex_free(compiled);
+}
+
+TEST(SearchBytesTest, tsm_regex_search) {
+    const char str[] = "x\xff\0a\x81" "b";  // byte mode also allows NUL characters
+    TsmRegex *compiled;
+    TsmMatch match = { 0, 0 };
+    ASSERT_EQ(TSM_OK, tsm_regex_compile("a.b", TSM_FLAG_BYTES, &compiled));
+    EXPECT_EQ(TSM_OK, tsm_regex_search(compiled, str, sizeof(str) - 1, 0, &match));
+    EXPECT_EQ(3u, match.start);
+    EXPECT_EQ(6u, match.end);
+    tsm_regex_free(compiled);
+    ASSERT_EQ(TSM_OK, tsm_regex_compile("\xff.a", TSM_FLAG_BYTES, &compiled));
+    EXPECT_EQ(TSM_OK, tsm_regex_search(compiled, str, sizeof(str) - 1, 0, &match));
+    EXPECT_EQ(1u, match.start);
+    EXPECT_EQ(4u, match.end);
+    tsm_regex_free(compiled);
+}
+
+TEST(ParallelTest, tsm_regex_count_parallel_bytes) {
+    std::string str;
+    for (int i = 0; i < 100000; i++)
+        str += "\x81\xff" "b";
+    TsmRegex *compiled;
+    ASSERT_EQ(TSM_OK, tsm_regex_compile("[\x80-\xff]b", TSM_FLAG_BYTES, &compiled));
+    for (int threads = 1; threads <= 8; threads *= 2) {
+        size_t count = 0;
+        EXPECT_EQ(TSM_OK, tsm_regex_count_parallel(compiled, str.c_str(), str.size(),
+                                                   threads, &count));
+        EXPECT_EQ(100000u, count) << "threads: " << threads;
+    }
+    tsm_regex_free(compiled);
+}
+
+TEST(ParallelTest, tsm_regex_count_parallel_bad_rune) {
+    std::string str(1 << 20, 'a');
+    str[str.size() / 2] = '\x81';
+    TsmRegex *compiled;
+    ASSERT_EQ(TSM_OK, tsm_regex_compile("b", TSM_FLAG_NONE, &compiled));
+    size_t count;
+    EXPECT_EQ(TSM_FAIL, tsm_regex_count_parallel(compiled, str.c_str(), str.size(), 4, &count));
+    tsm_regex_free(compiled);
+}
+
+struct ReplaceCase {
+    const char *pattern;
+    const char *str;
+    const char *replacement;
+    int all;
+    int expected;
+    const char *result;
+};
+
+class ReplaceTest : public ::testing::TestWithParam<ReplaceCase> {
+};
+
+// Test with replaced strings.
+const ReplaceCase replace_cases[] = {
+    { "a+", "baaabaa", "-", 1, TSM_OK, "b-b-" },
+    { "a+", "baaabaa", "-", 0, TSM_OK, "b-baa" },
+    { "x", "abc", "-", 1, TSM_OK, "abc" },  // no matches
+    { "a*", "", "-", 1, TSM_OK, "-" },
+    { "x*", "abc", "-", 1, TSM_OK, "-a-b-c-" },  // empty matches
+    { "x*", "abc", "-", 0, TSM_OK, "-abc" },
+    { "b*", "abc", "-", 1, TSM_OK, "-a--c-" },  // an empty match right after a match
+    { "$", "ab", "-", 1, TSM_OK, "ab-" },
+    { "^a", "aaa", "-", 1, TSM_OK, "-aa" },
+    { "\\s+", "a  b\t c", " ", 1, TSM_OK, "a b c" },
+    { "\\d{4}", "card 1234 5678", "****", 1, TSM_OK, "card **** ****" },
+    { "abc", "xabcxabc", "", 1, TSM_OK, "xx" },  // literal
+    { "ab|c", "abcab", "<>", 1, TSM_OK, "<><><>" },  // bytecode VM
+    { u8"い", u8"あいう", "i", 1, TSM_OK, u8"あiう" },
+    { u8"x*", u8"あい", "-", 1, TSM_OK, u8"-あ-い-" },
+    { "b", "a\x81" "b", "-", 1, TSM_FAIL, "" },  // bad rune before the match
+    { "a", "a\x81", "-", 0, TSM_FAIL, "" },  // bad rune right after the match
+    { "a", "ab\x81", "-", 0, TSM_OK, "-b\x81" },  // the rest is copied as is
+};
+
+INSTANTIATE_TEST_SUITE_P(ReplaceTestInstantiation,
+    ReplaceTest,
+    ::testing::ValuesIn(replace_cases));
+
+TEST_P(ReplaceTest, tsm_regex_replace) {
+    const ReplaceCase test_case = GetParam();
+    TsmRegex *compiled;
+    size_t len = 0, len2 = 0;
+    size_t str_len = strlen(test_case.str);
+    ASSERT_EQ(TSM_OK, tsm_regex_compile(test_case.pattern, TSM_FLAG_NONE, &compiled));
+    int actual = tsm_regex_replace(compiled, test_case.str, str_len, test_case.replacement,
+                                   test_case.all, NULL, 0, &len);
+    EXPECT_EQ(test_case.expected, actual)
+        << "\npattern: " << test_case.pattern << ", str: " << test_case.str << "\n";
+    if (actual == TSM_OK) {
+        std::string out(len + 1, '#');
+        EXPECT_EQ(TSM_OK, tsm_regex_replace(compiled, test_case.str, str_len,
+                                            test_case.replacement, test_case.all,
+                                            &out[0], out.size(), &len2));
+        EXPECT_EQ(len, len2);
+        EXPECT_STREQ(test_case.result, out.c_str());
+    }
+    tsm_regex_free(compiled);
+}
+
+TEST(ReplaceTest, tsm_regex_replace_small_buffer) {
+    TsmRegex *compiled;
+    char out[8];
+    size_t len = 0;
+    ASSERT_EQ(TSM_OK, tsm_regex_compile("\\d", TSM_FLAG_NONE, &compiled));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_replace(compiled, "a1b2c3", 6, "<>", 1, out, 8, &len));
+    EXPECT_EQ(9u, len);  // no room for the null terminator
+    EXPECT_EQ(TSM_OK, tsm_regex_replace(compiled, "a1b2c3", 6, "<>", 0, out, 8, &len));
+    EXPECT_EQ(7u, len);
+    EXPECT_STREQ("a<>b2c3", out);
+    EXPECT_EQ(TSM_FAIL, tsm_regex_replace(NULL, "a1b2c3", 6, "<>", 1, out, 8, &len));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_replace(compiled, "a1b2c3", 6, NULL, 1, out, 8, &len));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_replace(compiled, "a1b2c3", 6, "<>", 1, out, 8, NULL));
+    tsm_regex_free(compiled);
+}
+
+TEST(ReplaceTest, tsm_regex_replace_bytes) {
+    const char str[] = "a\0b\xff" "c";  // NUL characters in byte mode
+    TsmRegex *compiled;
+    char out[16];
+    size_t len = 0;
+    ASSERT_EQ(TSM_OK, tsm_regex_compile("[^a-z]", TSM_FLAG_BYTES, &compiled));
+    EXPECT_EQ(TSM_OK, tsm_regex_replace(compiled, str, sizeof(str) - 1, "_", 1,
+                                        out, sizeof(out), &len));
+    EXPECT_EQ(5u, len);
+    EXPECT_STREQ("a_b_c", out);
+    tsm_regex_free(compiled);
+}
+
+struct SplitCase {
+    const char *pattern;
+    const char *str;
+    int expected;  // the result after the last field
+    size_t count;
+    const char *fields;  // joined with '/'
+};
+
+class SplitTest : public ::testing::TestWithParam<SplitCase> {
+};
+
+// Test with fields.
+const SplitCase split_cases[] = {
+    { "\\s+", "a b  \tc", TSM_FAIL, 3, "a/b/c" },
+    { ",", "a,,b,", TSM_FAIL, 4, "a//b/" },
+    { "[,;]\\s*", "a, b;c", TSM_FAIL, 3, "a/b/c" },
+    { ",", "", TSM_FAIL, 1, "" },
+    { ",", "abc", TSM_FAIL, 1, "abc" },
+    { "x*", "ab", TSM_FAIL, 4, "/a/b/" },  // empty matches
+    { "b*", "abc", TSM_FAIL, 5, "/a//c/" },  // an empty match right after a match
+    { "^a", "aab", TSM_FAIL, 2, "/ab" },
+    { "$", "ab", TSM_FAIL, 2, "ab/" },
+    { u8"、", u8"あ、い、う", TSM_FAIL, 3, u8"あ/い/う" },
+    { ",|;", "a;b,c", TSM_FAIL, 3, "a/b/c" },  // bytecode VM
+    { ",", "a,b\x81,c", TSM_FAIL, 1, "a" },  // stops at the bad rune
+};
+
+INSTANTIATE_TEST_SUITE_P(SplitTestInstantiation,
+    SplitTest,
+    ::testing::ValuesIn(split_cases));
+
+TEST_P(SplitTest, tsm_regex_split_next) {
+    const SplitCase test_case = GetParam();
+    TsmRegex *compiled;
+    TsmSplit split;
+    const char *field;
+    size_t field_len;
+    size_t count = 0;
+    std::string fields;
+    size_t str_len = strlen(test_case.str);
+    ASSERT_EQ(TSM_OK, tsm_regex_compile(test_case.pattern, TSM_FLAG_NONE, &compiled));
+    ASSERT_EQ(TSM_OK, tsm_regex_split_init(&split, compiled, test_case.str, str_len));
+    int actual;
+    while ((actual = tsm_regex_split_next(&split, &field, &field_len)) == TSM_OK) {
+        EXPECT_GE(field, test_case.str);
+        EXPECT_LE(field + field_len, test_case.str + str_len);
+        if (count > 0)
+            fields += "/";
+        fields.append(field, field_len);
+        count++;
+    }
+    EXPECT_EQ(test_case.expected, actual);
+    EXPECT_EQ(test_case.count, count)
+        << "\npattern: " << test_case.pattern << ", str: " << test_case.str << "\n";
+    EXPECT_EQ(test_case.fields, fields);
+    EXPECT_EQ(TSM_FAIL, tsm_regex_split_next(&split, &field, &field_len));
+    tsm_regex_free(compiled);
+}
+
+TEST(SplitTest, tsm_regex_split_null) {
+    TsmRegex *compiled;
+    TsmSplit split;
+    const char *field;
+    size_t field_len;
+    ASSERT_EQ(TSM_OK, tsm_regex_compile(",", TSM_FLAG_NONE, &compiled));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_split_init(NULL, compiled, "a,b", 3));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_split_init(&split, NULL, "a,b", 3));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_split_init(&split, compiled, NULL, 3));
+    ASSERT_EQ(TSM_OK, tsm_regex_split_init(&split, compiled, "a,b", 3));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_split_next(NULL, &field, &field_len));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_split_next(&split, NULL, &field_len));
+    EXPECT_EQ(TSM_FAIL, tsm_regex_split_next(&split, &field, NULL));
+    tsm_regex_free(compiled);
+}
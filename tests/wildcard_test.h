@@ -156,9 +156,254 @@ INSTANTIATE_TEST_SUITE_P(WildcardTestInstantiation_Multicard,
     WildcardTest,
     ::testing::ValuesIn(wildcard_cases_multicard));
 
+// Test with patterns have many segments.
+const WildcardCase wildcard_cases_segments[] = {
+    { "*a?c*a?c*", "abcabc", TSM_OK },
+    { "*a?c*a?c*", "abcab", TSM_FAIL },
+    { "**a**", "a", TSM_OK },
+    { "a*b*c", "abbbcbc", TSM_OK },
+    { "a*b*c", "abbbcbd", TSM_FAIL },
+    { "a*ba*a", "aba", TSM_FAIL },
+    { "a*ba*a", "abaa", TSM_OK },
+    { u8"*\u3042?*\u3044*", u8"x\u3042\u3042\u3044", TSM_OK },
+    { u8"*\u3042?*\u3044*", u8"x\u3042\u3044", TSM_FAIL },
+    { "*0123456789*0123456789*0123456789*0123456789*0123456789*0123456789*0123456789*",
+      "0123456789012345678901234567890123456789012345678901234567890123456789", TSM_OK },
+    { "*0123456789*0123456789*0123456789*0123456789*0123456789*0123456789*0123456789*",
+      "012345678901234567890123456789012345678901234567890123456789012345678", TSM_FAIL },
+};
+
+INSTANTIATE_TEST_SUITE_P(WildcardTestInstantiation_Segments,
+    WildcardTest,
+    ::testing::ValuesIn(wildcard_cases_segments));
+
 TEST_P(WildcardTest, tsm_wildcard_match) {
     const WildcardCase test_case = GetParam();
     int actual = tsm_wildcard_match(test_case.pattern, test_case.str);
     EXPECT_EQ(test_case.expected, actual)
         << "\npattern: " << test_case.pattern << ", str: " << test_case.str << "\n";
 }
+
+TEST_P(WildcardTest, tsm_wildcard_match_compiled) {
+    const WildcardCase test_case = GetParam();
+    TsmWildcard *compiled;
+    int actual = tsm_wildcard_compile(test_case.pattern, TSM_FLAG_NONE, &compiled);
+    if (actual == TSM_OK) {
+        actual = tsm_wildcard_match_compiled(compiled, test_case.str);
+        tsm_wildcard_free(compiled);
+    } else if (actual == TSM_SYNTAX_ERROR) {
+        actual = TSM_FAIL;  // tsm_wildcard_match() returns TSM_FAIL for bad runes.
+    }
+    EXPECT_EQ(test_case.expected, actual)
+        << "\npattern: " << test_case.pattern << ", str: " << test_case.str << "\n";
+}
+
+struct WildcardFlagCase {
+    const char *pattern;
+    const char *str;
+    int flags;
+    int expected;
+};
+
+class WildcardFlagTest : public ::testing::TestWithParam<WildcardFlagCase> {
+};
+
+// Test with case-insensitive patterns.
+const WildcardFlagCase wildcard_cases_icase[] = {
+    { "Test*Case", "testfoocase", TSM_FLAG_NONE, TSM_FAIL },
+    { "Test*Case", "testfoocase", TSM_FLAG_ICASE, TSM_OK },
+    { "test?case", "TESTFCASE", TSM_FLAG_ICASE, TSM_OK },
+    { "test?case", "TESTCASE", TSM_FLAG_ICASE, TSM_FAIL },
+    { "*.PNG", "image.png", TSM_FLAG_ICASE, TSM_OK },
+    { "*.png", "image.jpg", TSM_FLAG_ICASE, TSM_FAIL },
+    { u8"\u00c4*\u00c4", u8"\u00e4a\u00e4", TSM_FLAG_ICASE, TSM_OK },  // \u00c4 == "Ä"
+    { u8"\u00e4*\u00e4", u8"\u00c4a\u00c4", TSM_FLAG_ICASE, TSM_OK },
+    { u8"\u00e4*\u00e4", u8"\u00c4a\u00c4", TSM_FLAG_NONE, TSM_FAIL },
+    { u8"\u0414?", u8"\u0434\u3042", TSM_FLAG_ICASE, TSM_OK },  // Cyrillic de
+    { u8"\u3042*", u8"\u3042\u3044", TSM_FLAG_ICASE, TSM_OK },  // no case
+    { u8"*\u01a0\u10a0*", u8"x\u01a1\u2d00", TSM_FLAG_ICASE, TSM_OK },  // Latin Ext-B, Georgian
+    { u8"a*ok*z", u8"a-O\u212a-z", TSM_FLAG_ICASE, TSM_OK },  // \u212a == Kelvin sign
+    { u8"a*ok*z", u8"a-O\u212a-z", TSM_FLAG_NONE, TSM_FAIL },
+    { u8"\u212a?", u8"k\u3042", TSM_FLAG_ICASE, TSM_OK },
+};
+
+INSTANTIATE_TEST_SUITE_P(WildcardFlagTestInstantiation_ICase,
+    WildcardFlagTest,
+    ::testing::ValuesIn(wildcard_cases_icase));
+
+// Test with path mode.
+const WildcardFlagCase wildcard_cases_path[] = {
+    { "*.c", "main.c", TSM_FLAG_NONE, TSM_OK },
+    { "*.c", "src/main.c", TSM_FLAG_NONE, TSM_OK },
+    { "*.c", "src/main.c", TSM_FLAG_PATH, TSM_FAIL },  // '*' stops at '/'
+    { "src/*.c", "src/main.c", TSM_FLAG_PATH, TSM_OK },
+    { "src/*.c", "src/sub/main.c", TSM_FLAG_PATH, TSM_FAIL },
+    { "src/?", "src/a", TSM_FLAG_PATH, TSM_OK },
+    { "src?a", "src/a", TSM_FLAG_PATH, TSM_FAIL },  // '?' doesn't match '/'
+    { "src?a", "src/a", TSM_FLAG_NONE, TSM_OK },
+    { "src/**/*.c", "src/main.c", TSM_FLAG_PATH, TSM_OK },  // zero directories
+    { "src/**/*.c", "src/a/b/main.c", TSM_FLAG_PATH, TSM_OK },
+    { "src/**/*.c", "src/a/b/main.h", TSM_FLAG_PATH, TSM_FAIL },
+    { "src/**/*.c", "srcx/main.c", TSM_FLAG_PATH, TSM_FAIL },
+    { "**/*.c", "main.c", TSM_FLAG_PATH, TSM_OK },
+    { "**/*.c", "a/b/main.c", TSM_FLAG_PATH, TSM_OK },
+    { "src/**", "src/a/b/main.c", TSM_FLAG_PATH, TSM_OK },
+    { "src/**", "src", TSM_FLAG_PATH, TSM_FAIL },
+    { "a**b", "a/x/b", TSM_FLAG_PATH, TSM_OK },
+    { "**", "a/b/c", TSM_FLAG_PATH, TSM_OK },
+    { "SRC/*.C", "src/main.c", TSM_FLAG_PATH | TSM_FLAG_ICASE, TSM_OK },
+    { u8"あ/*", u8"あ/い", TSM_FLAG_PATH, TSM_OK },
+    { "a/*", "a/\x81", TSM_FLAG_PATH, TSM_FAIL },  // bad rune
+};
+
+INSTANTIATE_TEST_SUITE_P(WildcardFlagTestInstantiation_Path,
+    WildcardFlagTest,
+    ::testing::ValuesIn(wildcard_cases_path));
+
+// Test with byte mode. Each byte is a Latin-1 character.
+const WildcardFlagCase wildcard_cases_bytes[] = {
+    { "a*", "a\x81", TSM_FLAG_NONE, TSM_FAIL },  // bad rune
+    { "a*", "a\x81", TSM_FLAG_BYTES, TSM_OK },
+    { "a?c", "a\xff" "c", TSM_FLAG_BYTES, TSM_OK },
+    { "a?c", u8"a\u00e4c", TSM_FLAG_BYTES, TSM_FAIL },  // two bytes
+    { "a??c", u8"a\u00e4c", TSM_FLAG_BYTES, TSM_OK },
+    { "*\xe4*", "\x80\xe4\x80", TSM_FLAG_BYTES, TSM_OK },
+    { "*\xe4*", "\x80\xc4\x80", TSM_FLAG_BYTES, TSM_FAIL },
+    { "*\xe4*", "\x80\xc4\x80", TSM_FLAG_BYTES | TSM_FLAG_ICASE, TSM_OK },  // Latin-1 cases
+    { "*\xe4?*", "\x80\xe4", TSM_FLAG_BYTES, TSM_FAIL },
+    { "*a*b*c*", "\xff" "a\xfe" "b\xfd" "c\xfc", TSM_FLAG_BYTES, TSM_OK },
+    { "\xe4/*", "\xe4/\xff", TSM_FLAG_BYTES | TSM_FLAG_PATH, TSM_OK },
+    { "\xe4/*", "\xe4/\xff/a", TSM_FLAG_BYTES | TSM_FLAG_PATH, TSM_FAIL },
+};
+
+INSTANTIATE_TEST_SUITE_P(WildcardFlagTestInstantiation_Bytes,
+    WildcardFlagTest,
+    ::testing::ValuesIn(wildcard_cases_bytes));
+
+TEST_P(WildcardFlagTest, tsm_wildcard_match_compiled) {
+    const WildcardFlagCase test_case = GetParam();
+    TsmWildcard *compiled;
+    int actual = tsm_wildcard_compile(test_case.pattern, test_case.flags, &compiled);
+    if (actual == TSM_OK) {
+        actual = tsm_wildcard_match_compiled(compiled, test_case.str);
+        tsm_wildcard_free(compiled);
+    }
+    EXPECT_EQ(test_case.expected, actual)
+        << "\npattern: " << test_case.pattern << ", str: " << test_case.str
+        << ", flags: " << test_case.flags << "\n";
+}
+
+struct WildcardWideCase {
+    const char *pattern;
+    const char16_t *str16;
+    const char32_t *str32;
+    int flags;
+    int expected;
+};
+
+class WildcardWideTest : public ::testing::TestWithParam<WildcardWideCase> {
+};
+
+// Test with utf-16 and utf-32 strings.
+const WildcardWideCase wildcard_cases_wide[] = {
+    { "test*case", u"testfoocase", U"testfoocase", TSM_FLAG_NONE, TSM_OK },
+    { "test?case", u"testcase", U"testcase", TSM_FLAG_NONE, TSM_FAIL },
+    { "test?case", u"test\u3042case", U"test\u3042case", TSM_FLAG_NONE, TSM_OK },
+    { "test?case", u"test\U0001F600case", U"test\U0001F600case", TSM_FLAG_NONE, TSM_OK },
+    { u8"\U0001F600*\U0001F600", u"\U0001F600a\U0001F600", U"\U0001F600a\U0001F600",
+      TSM_FLAG_NONE, TSM_OK },
+    { u8"\u00e4*", u"\u00c4a", U"\u00c4a", TSM_FLAG_ICASE, TSM_OK },
+    { "src/*.c", u"src/main.c", U"src/main.c", TSM_FLAG_PATH, TSM_OK },
+    { "src/*.c", u"src/a/main.c", U"src/a/main.c", TSM_FLAG_PATH, TSM_FAIL },
+    { "src/**/*.c", u"src/a/main.c", U"src/a/main.c", TSM_FLAG_PATH, TSM_OK },
+    { "a*", u"a\xD800", U"a\xD800", TSM_FLAG_NONE, TSM_FAIL },  // unpaired surrogate
+    { "a*", u"a\xDC00\xD800", U"a\xDC00", TSM_FLAG_NONE, TSM_FAIL },  // lone low surrogates
+};
+
+INSTANTIATE_TEST_SUITE_P(WildcardWideTestInstantiation,
+    WildcardWideTest,
+    ::testing::ValuesIn(wildcard_cases_wide));
+
+TEST_P(WildcardWideTest, tsm_wildcard_match_utf16) {
+    const WildcardWideCase test_case = GetParam();
+    std::u16string str(test_case.str16);
+    TsmWildcard *compiled;
+    int actual = tsm_wildcard_compile(test_case.pattern, test_case.flags, &compiled);
+    if (actual == TSM_OK) {
+        actual = tsm_wildcard_match_utf16(compiled, (const uint16_t *)str.data(), str.size());
+        tsm_wildcard_free(compiled);
+    }
+    EXPECT_EQ(test_case.expected, actual)
+        << "\npattern: " << test_case.pattern << ", flags: " << test_case.flags << "\n";
+}
+
+TEST_P(WildcardWideTest, tsm_wildcard_match_utf32) {
+    const WildcardWideCase test_case = GetParam();
+    std::u32string str(test_case.str32);
+    TsmWildcard *compiled;
+    int actual = tsm_wildcard_compile(test_case.pattern, test_case.flags, &compiled);
+    if (actual == TSM_OK) {
+        actual = tsm_wildcard_match_utf32(compiled, (const uint32_t *)str.data(), str.size());
+        tsm_wildcard_free(compiled);
+    }
+    EXPECT_EQ(test_case.expected, actual)
+        << "\npattern: " << test_case.pattern << ", flags: " << test_case.flags << "\n";
+}
+
+TEST(WildcardWideNullTest, tsm_wildcard_match_utf16) {
+    const uint16_t str16[] = { 'a', 0, 'b' };  // lengths allow NUL characters
+    const uint32_t str32[] = { 'a', 0, 'b' };
+    const uint32_t bad32[] = { 'a', 0x110000, 'b' };  // beyond U+10FFFF
+    TsmWildcard *compiled;
+    ASSERT_EQ(TSM_OK, tsm_wildcard_compile("a?b", TSM_FLAG_NONE, &compiled));
+    EXPECT_EQ(TSM_OK, tsm_wildcard_match_utf16(compiled, str16, 3));
+    EXPECT_EQ(TSM_OK, tsm_wildcard_match_utf32(compiled, str32, 3));
+    EXPECT_EQ(TSM_FAIL, tsm_wildcard_match_utf32(compiled, bad32, 3));
+    EXPECT_EQ(TSM_FAIL, tsm_wildcard_match_utf16(compiled, str16, 2));
+    EXPECT_EQ(TSM_FAIL, tsm_wildcard_match_utf16(compiled, NULL, 0));
+    EXPECT_EQ(TSM_FAIL, tsm_wildcard_match_utf32(compiled, NULL, 0));
+    EXPECT_EQ(TSM_FAIL, tsm_wildcard_match_utf16(NULL, str16, 3));
+    tsm_wildcard_free(compiled);
+}
+
+struct WildcardDescendCase {
+    const char *pattern;
+    const char *dir;
+    int flags;
+    int expected;
+};
+
+class WildcardDescendTest : public ::testing::TestWithParam<WildcardDescendCase> {
+};
+
+// Test with directory pruning.
+const WildcardDescendCase wildcard_cases_descend[] = {
+    { "src/*.c", "", TSM_FLAG_PATH, TSM_OK },
+    { "src/*.c", "src", TSM_FLAG_PATH, TSM_OK },
+    { "src/*.c", "src/", TSM_FLAG_PATH, TSM_OK },
+    { "src/*.c", "src/sub", TSM_FLAG_PATH, TSM_FAIL },
+    { "src/*.c", "docs", TSM_FLAG_PATH, TSM_FAIL },
+    { "src/*.c", "sr", TSM_FLAG_PATH, TSM_FAIL },
+    { "src/**/*.c", "src/a/b/c", TSM_FLAG_PATH, TSM_OK },
+    { "**/test/*.c", "a/b", TSM_FLAG_PATH, TSM_OK },
+    { "*/test", "a/test", TSM_FLAG_PATH, TSM_FAIL },  // no paths under a matching file
+    { "*/test/*", "a/test", TSM_FLAG_PATH, TSM_OK },
+    { "src/*.c", "src/sub", TSM_FLAG_NONE, TSM_OK },  // '*' matches '/' without TSM_FLAG_PATH
+    { "SRC/*", "src", TSM_FLAG_PATH | TSM_FLAG_ICASE, TSM_OK },
+    { "src/*", "src\x81", TSM_FLAG_PATH, TSM_FAIL },  // bad rune
+    { "\xe4/*", "\xe4", TSM_FLAG_PATH | TSM_FLAG_BYTES, TSM_OK },
+};
+
+INSTANTIATE_TEST_SUITE_P(WildcardDescendTestInstantiation,
+    WildcardDescendTest,
+    ::testing::ValuesIn(wildcard_cases_descend));
+
+TEST_P(WildcardDescendTest, tsm_wildcard_can_descend) {
+    const WildcardDescendCase test_case = GetParam();
+    TsmWildcard *compiled;
+    ASSERT_EQ(TSM_OK, tsm_wildcard_compile(test_case.pattern, test_case.flags, &compiled));
+    EXPECT_EQ(test_case.expected, tsm_wildcard_can_descend(compiled, test_case.dir))
+        << "\npattern: " << test_case.pattern << ", dir: " << test_case.dir
+        << ", flags: " << test_case.flags << "\n";
+    tsm_wildcard_free(compiled);
+}
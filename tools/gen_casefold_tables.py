@@ -0,0 +1,130 @@
+"""Generates src/casefold_tables.h for case-insensitive matching.
+
+Usage: python3 tools/gen_casefold_tables.py [output]
+
+The tables have the simple case folding of CaseFolding.txt (status C and S).
+Python's str.casefold() has the C and F mappings of the same file,
+and str.lower() gives the S mappings of the characters that have F mappings.
+
+casefold_lower folds characters, and casefold_upper maps each folded character back to
+its uppercase. Both are ranges of characters that move by the same delta.
+Case classes of three or more characters, such as k, K, and the Kelvin sign,
+are cycles in casefold_orbit.
+"""
+import os
+import sys
+import unicodedata
+
+ASCII_MAX = 0x7F
+
+
+def simple_fold(cp):
+    c = chr(cp)
+    folded = c.casefold()
+    if len(folded) == 1:
+        return ord(folded)
+    # Full folding (F). Use the simple one (S) when it exists.
+    lower = c.lower()
+    if len(lower) == 1 and lower != c and simple_fold(ord(lower)) == ord(lower):
+        return ord(lower)
+    return cp
+
+
+def build_classes():
+    fold = {}
+    for cp in range(0x110000):
+        if 0xD800 <= cp < 0xE000:
+            continue
+        f = simple_fold(cp)
+        if f != cp:
+            fold[cp] = f
+    classes = {}
+    for cp, f in fold.items():
+        assert fold.get(f, f) == f
+        classes.setdefault(f, {f}).add(cp)
+    return fold, classes
+
+
+def to_ranges(mapping):
+    # [first, last, delta, stride]. Keys between first and last are every stride code points.
+    ranges = []
+    for cp, target in sorted(mapping.items()):
+        delta = target - cp
+        if ranges:
+            r = ranges[-1]
+            step = cp - r[1]
+            if r[2] == delta and (step == r[3] or (r[3] == 0 and step in (1, 2))):
+                r[1] = cp
+                r[3] = step
+                continue
+        ranges.append([cp, cp, delta, 0])
+    for r in ranges:
+        r[3] = r[3] or 1
+    return ranges
+
+
+def put_ranges(lines, name, comment, ranges):
+    lines.append(comment)
+    lines.append(f"static const FoldRange {name}[{len(ranges)}] = {{")
+    for first, last, delta, stride in ranges:
+        lines.append(f"    {{ 0x{first:04X}, 0x{last:04X}, {delta}, {stride} }},")
+    lines.append("};")
+    lines.append("")
+
+
+def main():
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    output = sys.argv[1] if len(sys.argv) > 1 else os.path.join(root, "src", "casefold_tables.h")
+
+    fold, classes = build_classes()
+    lower = {cp: f for cp, f in fold.items() if cp > ASCII_MAX}
+    upper = {}
+    orbit = []
+    for f, members in classes.items():
+        if f > ASCII_MAX:
+            u = chr(f).upper()
+            if len(u) == 1 and ord(u) in members and ord(u) != f:
+                upper[f] = ord(u)
+            else:
+                upper[f] = min(cp for cp in members if cp != f)
+        if len(members) > 2:
+            members = sorted(members)
+            for i, cp in enumerate(members):
+                orbit.append((cp, members[(i + 1) % len(members)]))
+    orbit.sort()
+
+    lines = [
+        "// This file is generated by tools/gen_casefold_tables.py. DO NOT EDIT.",
+        f"// Unicode version: {unicodedata.unidata_version}",
+        "#ifndef __TINY_STR_MATCH_INCLUDE_CASEFOLD_TABLES_H__",
+        "#define __TINY_STR_MATCH_INCLUDE_CASEFOLD_TABLES_H__",
+        "",
+        "#include <stdint.h>",
+        "",
+        "// Characters in [first, last] (every `stride` code points) map by adding `delta`.",
+        "typedef struct {",
+        "    uint32_t first;",
+        "    uint32_t last;",
+        "    int32_t delta;",
+        "    uint32_t stride;",
+        "} FoldRange;",
+        "",
+    ]
+    put_ranges(lines, "casefold_lower", "// Simple case folding for non-ASCII characters",
+               to_ranges(lower))
+    put_ranges(lines, "casefold_upper", "// Folded non-ASCII characters to their uppercase",
+               to_ranges(upper))
+    lines.append("// Case classes of three or more characters. Each maps to the next one.")
+    lines.append(f"static const uint32_t casefold_orbit[{len(orbit)}][2] = {{")
+    for cp, next_cp in orbit:
+        lines.append(f"    {{ 0x{cp:04X}, 0x{next_cp:04X} }},")
+    lines.append("};")
+    lines.append("")
+    lines.append("#endif  // __TINY_STR_MATCH_INCLUDE_CASEFOLD_TABLES_H__")
+
+    with open(output, "w", newline="\n") as f:
+        f.write("\n".join(lines) + "\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,88 @@
+"""Generates src/uctype_tables.h for Unicode-aware \\d, \\w, and \\s.
+
+Usage: python3 tools/gen_uctype_tables.py [output]
+
+Each property is stored as a two-level table.
+The first level maps (code point >> 8) to a block index,
+and the second level has 256-bit bitmaps shared between identical blocks.
+Code points from UCTYPE_MAX_CP are out of the tables and never match.
+"""
+import os
+import sys
+import unicodedata
+
+MAX_CP = 0x40000  # planes 0 to 3
+BLOCK = 256
+
+ASCII_SPACE = [0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x20, 0x85]
+
+
+def is_digit(cp):
+    return unicodedata.category(chr(cp)) == "Nd"
+
+
+def is_word(cp):
+    cat = unicodedata.category(chr(cp))
+    return cat[0] == "L" or cat in ("Mn", "Mc", "Nd", "Pc")
+
+
+def is_space(cp):
+    return cp in ASCII_SPACE or unicodedata.category(chr(cp)) in ("Zs", "Zl", "Zp")
+
+
+def build(name, func):
+    blocks = []
+    block_ids = {}
+    index = []
+    for base in range(0, MAX_CP, BLOCK):
+        words = [0] * (BLOCK // 32)
+        for cp in range(base, base + BLOCK):
+            if func(cp):
+                words[(cp - base) // 32] |= 1 << (cp % 32)
+        key = tuple(words)
+        if key not in block_ids:
+            block_ids[key] = len(blocks)
+            blocks.append(key)
+        index.append(block_ids[key])
+    assert len(blocks) <= 256
+
+    lines = []
+    lines.append(f"static const uint8_t uctype_{name}_index[{len(index)}] = {{")
+    for i in range(0, len(index), 16):
+        lines.append("    " + ", ".join(str(n) for n in index[i:i + 16]) + ",")
+    lines.append("};")
+    lines.append("")
+    lines.append(f"static const uint32_t uctype_{name}_blocks[{len(blocks)}][8] = {{")
+    for words in blocks:
+        lines.append("    { " + ", ".join(f"0x{w:08X}" for w in words[:4]) + ",")
+        lines.append("      " + ", ".join(f"0x{w:08X}" for w in words[4:]) + " },")
+    lines.append("};")
+    return lines
+
+
+def main():
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    output = sys.argv[1] if len(sys.argv) > 1 else os.path.join(root, "src", "uctype_tables.h")
+
+    lines = [
+        "// This file is generated by tools/gen_uctype_tables.py. DO NOT EDIT.",
+        f"// Unicode version: {unicodedata.unidata_version}",
+        "#ifndef __TINY_STR_MATCH_INCLUDE_UCTYPE_TABLES_H__",
+        "#define __TINY_STR_MATCH_INCLUDE_UCTYPE_TABLES_H__",
+        "",
+        "#include <stdint.h>",
+        "",
+        f"#define UCTYPE_MAX_CP 0x{MAX_CP:X}",
+        "",
+    ]
+    for name, func in (("digit", is_digit), ("word", is_word), ("space", is_space)):
+        lines += build(name, func)
+        lines.append("")
+    lines.append("#endif  // __TINY_STR_MATCH_INCLUDE_UCTYPE_TABLES_H__")
+
+    with open(output, "w", newline="\n") as f:
+        f.write("\n".join(lines) + "\n")
+
+
+if __name__ == "__main__":
+    main()
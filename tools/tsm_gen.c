@@ -0,0 +1,633 @@
+/*
+ * tsm-gen: compiles regex patterns to a C source file at build time.
+ *
+ * Usage: tsm-gen patterns.txt output.c output.h
+ *
+ * Each line of the list has a name, flags, and a pattern separated by spaces.
+ * Flags are "-" or a comma-separated list of icase, unicode, memoize, bytes, and safe.
+ * The pattern is the rest of the line. Empty lines and lines starting with '#' are skipped.
+ *
+ *   # name  flags        pattern
+ *   digits  -            ^\d+$
+ *   image   icase,bytes  ^[a-z]+\.png$
+ *
+ * The source file defines the compiled patterns as static const objects with all the tables,
+ * and the header declares `const TsmRegex *const name` for each of them.
+ * The source file includes private headers of the library, so it should be compiled
+ * with the include directories and the options of the library (tiny_str_match_gen_dep).
+ * Patterns with syntax errors fail the build.
+ * Patterns that can backtrack in super-linear time without memoize or safe print warnings.
+ *
+ */
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "str_match.h"
+#include "re.h"
+#include "complexity.h"
+
+#define MAX_LINE 4096
+#define WRAP_COLUMN 96
+
+typedef struct Entry {
+    char *name;
+    char *pattern;
+    const char *flag_text;
+    int line;
+    struct TsmRegex *re;
+} Entry;
+
+#define MAX_DEPTH 8
+
+typedef struct Output {
+    FILE *fp;
+    const char *self;  // name of the object that is written
+    int indent;
+    int col;           // column of the current line of items, or zero
+    int depth;         // number of open lists
+    int written;       // number of open lists that have been written
+    char heads[MAX_DEPTH][32];  // e.g. ".objs =" or "[3] ="
+} Output;
+
+static void usage(FILE *out) {
+    fprintf(out,
+            "Usage: tsm-gen patterns.txt output.c output.h\n"
+            "Compiles a list of regex patterns to a C source file and its header.\n"
+            "\n"
+            "Each line of the list is \"name flags pattern\".\n"
+            "Flags are \"-\" or a comma-separated list of icase, unicode, memoize, bytes,\n"
+            "and safe.\n");
+}
+
+static int parse_flags(const char *text, size_t len, int *flags) {
+    static const struct { const char *name; int flag; } names[] = {
+        { "icase", TSM_FLAG_ICASE },
+        { "unicode", TSM_FLAG_UNICODE },
+        { "memoize", TSM_FLAG_MEMOIZE },
+        { "bytes", TSM_FLAG_BYTES },
+        { "safe", TSM_FLAG_SAFE },
+    };
+    size_t i, n;
+    *flags = TSM_FLAG_NONE;
+    if (len == 1 && text[0] == '-')
+        return 1;
+    while (len) {
+        for (n = 0; n < len && text[n] != ','; n++) {}
+        for (i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+            if (strlen(names[i].name) == n && memcmp(names[i].name, text, n) == 0)
+                break;
+        }
+        if (i == sizeof(names) / sizeof(names[0]))
+            return 0;
+        *flags |= names[i].flag;
+        text += n;
+        len -= n;
+        if (len) {
+            text++;
+            len--;
+            if (!len)
+                return 0;  // trailing ','
+        }
+    }
+    return 1;
+}
+
+static int is_identifier(const char *s) {
+    if (!(*s == '_' || (*s >= 'a' && *s <= 'z') || (*s >= 'A' && *s <= 'Z')))
+        return 0;
+    for (s++; *s; s++) {
+        if (!(*s == '_' || (*s >= 'a' && *s <= 'z') || (*s >= 'A' && *s <= 'Z') ||
+              (*s >= '0' && *s <= '9')))
+            return 0;
+    }
+    return 1;
+}
+
+static char *copy_string(const char *s, size_t len) {
+    char *copy = (char *)malloc(len + 1);
+    if (copy == NULL) {
+        fprintf(stderr, "tsm-gen: out of memory\n");
+        exit(1);
+    }
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+// Same as tsm_regex_compile() without the JIT.
+// The memory is zeroed, so fields that the engines don't use are written as zeros.
+static struct TsmRegex *compile(const char *pattern, int flags) {
+    struct TsmRegex *re = (struct TsmRegex *)calloc(1, sizeof(struct TsmRegex));
+    if (re == NULL) {
+        fprintf(stderr, "tsm-gen: out of memory\n");
+        exit(1);
+    }
+    if (!re_compile_flags(re, pattern, flags, 0)) {
+        free(re);
+        return NULL;
+    }
+    return re;
+}
+
+// Reads the list. Returns the number of entries, or -1 on errors.
+static int read_list(const char *path, Entry **entries) {
+    char buf[MAX_LINE];
+    int count = 0, cap = 0, line = 0, errors = 0;
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "tsm-gen: can't open %s\n", path);
+        return -1;
+    }
+    *entries = NULL;
+    while (fgets(buf, sizeof(buf), fp) != NULL) {
+        size_t len = strlen(buf);
+        const char *name, *flag_text, *pattern;
+        size_t name_len, flag_len;
+        int flags, degree, i;
+        line++;
+        if (len == sizeof(buf) - 1 && buf[len - 1] != '\n' && !feof(fp)) {
+            fprintf(stderr, "%s:%d: line too long\n", path, line);
+            errors++;
+            break;
+        }
+        while (len && (buf[len - 1] == '\n' || buf[len - 1] == '\r'))
+            buf[--len] = '\0';
+
+        name = buf;
+        while (*name == ' ' || *name == '\t')
+            name++;
+        if (*name == '\0' || *name == '#')
+            continue;
+        for (name_len = 0; name[name_len] && name[name_len] != ' ' && name[name_len] != '\t';
+             name_len++) {}
+        flag_text = name + name_len;
+        while (*flag_text == ' ' || *flag_text == '\t')
+            flag_text++;
+        for (flag_len = 0;
+             flag_text[flag_len] && flag_text[flag_len] != ' ' && flag_text[flag_len] != '\t';
+             flag_len++) {}
+        pattern = flag_text + flag_len;
+        while (*pattern == ' ' || *pattern == '\t')
+            pattern++;
+        if (*pattern == '\0') {
+            fprintf(stderr, "%s:%d: expected \"name flags pattern\"\n", path, line);
+            errors++;
+            continue;
+        }
+        if (!parse_flags(flag_text, flag_len, &flags)) {
+            fprintf(stderr, "%s:%d: unknown flags: %.*s\n",
+                    path, line, (int)flag_len, flag_text);
+            errors++;
+            continue;
+        }
+
+        if (count == cap) {
+            cap = cap ? cap * 2 : 16;
+            *entries = (Entry *)realloc(*entries, (size_t)cap * sizeof(Entry));
+            if (*entries == NULL) {
+                fprintf(stderr, "tsm-gen: out of memory\n");
+                exit(1);
+            }
+        }
+        Entry *e = &(*entries)[count];
+        e->name = copy_string(name, name_len);
+        e->flag_text = copy_string(flag_text, flag_len);
+        e->pattern = copy_string(pattern, strlen(pattern));
+        e->line = line;
+        if (!is_identifier(e->name)) {
+            fprintf(stderr, "%s:%d: invalid name: %s\n", path, line, e->name);
+            errors++;
+            continue;
+        }
+        for (i = 0; i < count && strcmp((*entries)[i].name, e->name) != 0; i++) {}
+        if (i < count) {
+            fprintf(stderr, "%s:%d: %s is already defined at line %d\n",
+                    path, line, e->name, (*entries)[i].line);
+            errors++;
+            continue;
+        }
+        e->re = compile(e->pattern, flags);
+        if (e->re == NULL) {
+            fprintf(stderr, "%s:%d: syntax error in pattern: %s\n", path, line, e->pattern);
+            errors++;
+            continue;
+        }
+        degree = re_complexity(e->re->objs);
+        if (!e->re->memoize && degree > 1)
+            fprintf(stderr, "%s:%d: warning: %s can take O(n^%d) steps. Add the safe flag.\n",
+                    path, line, e->name, degree);
+        count++;
+    }
+    if (ferror(fp)) {
+        fprintf(stderr, "tsm-gen: %s: read error\n", path);
+        errors++;
+    }
+    fclose(fp);
+    return errors ? -1 : count;
+}
+
+// Writes a string as the contents of a C string literal.
+// In comments, "*/" is broken, and the escapes are only for reading.
+static void put_escaped(FILE *fp, const char *s, size_t len, int comment) {
+    size_t i;
+    for (i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c == '"' || c == '\\' || c == '?')  // '?' for trigraphs
+            fprintf(fp, "\\%c", c);
+        else if (comment && c == '/' && i > 0 && s[i - 1] == '*')
+            fputs("\\/", fp);
+        else if (c >= 0x20 && c < 0x7F)
+            fputc(c, fp);
+        else
+            fprintf(fp, "\\%03o", c);
+    }
+}
+
+// Lists are written with their first items, so empty lists are left out. (C99 needs items.)
+static void write_heads(Output *o) {
+    while (o->written < o->depth) {
+        fprintf(o->fp, "%*s%s {\n", o->indent, "", o->heads[o->written]);
+        o->indent += 4;
+        o->written++;
+    }
+}
+
+static void put_line(Output *o, const char *fmt, ...) {
+    va_list args;
+    write_heads(o);
+    fprintf(o->fp, "%*s", o->indent, "");
+    va_start(args, fmt);
+    vfprintf(o->fp, fmt, args);
+    va_end(args);
+    fputc('\n', o->fp);
+}
+
+static void open_list(Output *o, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(o->heads[o->depth], sizeof(o->heads[0]), fmt, args);
+    va_end(args);
+    o->depth++;
+    o->col = 0;
+}
+
+static void close_list(Output *o) {
+    if (o->col)
+        fputc('\n', o->fp);
+    o->col = 0;
+    o->depth--;
+    if (o->written > o->depth) {
+        o->written--;
+        o->indent -= 4;
+        put_line(o, "},");
+    }
+}
+
+// Writes an item of a list. Short items share lines.
+static void put_item(Output *o, const char *fmt, ...) {
+    char buf[128];
+    va_list args;
+    int len;
+    va_start(args, fmt);
+    len = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    write_heads(o);
+    if (o->col && o->col + 1 + len > WRAP_COLUMN) {
+        fputc('\n', o->fp);
+        o->col = 0;
+    }
+    if (o->col) {
+        fputc(' ', o->fp);
+        o->col++;
+    } else {
+        fprintf(o->fp, "%*s", o->indent, "");
+        o->col = o->indent;
+    }
+    fputs(buf, o->fp);
+    o->col += len;
+}
+
+// Scalars and arrays only write non-zero values. Others are zero-initialized.
+static void put_int(Output *o, const char *name, long value) {
+    if (value)
+        put_line(o, ".%s = %ld,", name, value);
+}
+
+static void put_u8s(Output *o, const char *name, const uint8_t *a, size_t n) {
+    size_t i, last = n;
+    for (i = 0; i < n; i++) {
+        if (a[i])
+            last = i;
+    }
+    if (last == n)
+        return;
+    open_list(o, ".%s =", name);
+    for (i = 0; i <= last; i++)
+        put_item(o, "%u,", (unsigned)a[i]);
+    close_list(o);
+}
+
+static void put_u32s(Output *o, const char *name, const uint32_t *a, size_t n) {
+    size_t i, last = n;
+    for (i = 0; i < n; i++) {
+        if (a[i])
+            last = i;
+    }
+    if (last == n)
+        return;
+    open_list(o, ".%s =", name);
+    for (i = 0; i <= last; i++)
+        put_item(o, "0x%08" PRIx32 "u,", a[i]);
+    close_list(o);
+}
+
+static void put_u64s(Output *o, const char *name, const uint64_t *a, size_t n) {
+    size_t i;
+    int any = 0;
+    for (i = 0; i < n; i++)
+        any |= a[i] != 0;
+    if (!any)
+        return;
+    open_list(o, ".%s =", name);
+    for (i = 0; i < n; i++) {
+        if (a[i])
+            put_item(o, "[%u] = UINT64_C(0x%" PRIx64 "),", (unsigned)i, a[i]);
+    }
+    close_list(o);
+}
+
+static void put_u64(Output *o, const char *name, uint64_t value) {
+    if (value)
+        put_line(o, ".%s = UINT64_C(0x%" PRIx64 "),", name, value);
+}
+
+static void put_objs(Output *o, const struct TsmRegex *re) {
+    int i;
+    open_list(o, ".objs =");
+    for (i = 0; i < MAX_REGEXP_OBJECTS; i++) {
+        const regex_t *obj = &re->objs[i];
+        open_list(o, "[%d] =", i);
+        put_int(o, "type", obj->type);
+        put_int(o, "flags", obj->flags);
+        switch (obj->type) {
+        case CHAR:
+            put_line(o, ".u.ch = {%u, %u, %u, %u},", obj->u.ch[0], obj->u.ch[1],
+                     obj->u.ch[2], obj->u.ch[3]);
+            break;
+        case ICASE_CHAR:
+            put_line(o, ".u.cp = {0x%" PRIx32 "u, 0x%" PRIx32 "u},", obj->u.cp[0], obj->u.cp[1]);
+            break;
+        case CHAR_CLASS:
+        case INV_CHAR_CLASS:
+            put_line(o, ".u.ccl = &%s.ccl[%d],", o->self, (int)(obj->u.ccl - re->ccl));
+            break;
+        case TIMES:
+            put_line(o, ".u.times = {%u, %u},", obj->u.times.n, obj->u.times.m);
+            break;
+        default:
+            break;
+        }
+        put_int(o, "ch_size", obj->ch_size);
+        close_list(o);
+        if (obj->type == UNUSED)
+            break;
+    }
+    close_list(o);
+}
+
+static void put_classes(Output *o, const struct TsmRegex *re) {
+    int i;
+    if (re->ccl[0].str == NULL)
+        return;
+    open_list(o, ".ccl =");
+    for (i = 0; i < MAX_CHAR_CLASSES && re->ccl[i].str != NULL; i++) {
+        open_list(o, "[%d] =", i);
+        put_u32s(o, "ascii", re->ccl[i].ascii, 4);
+        put_line(o, ".str = &%s.ccl_buf[%d],", o->self, (int)(re->ccl[i].str - re->ccl_buf));
+        put_line(o, ".tables = %d,", re->ccl[i].tables);
+        close_list(o);
+    }
+    close_list(o);
+    put_u8s(o, "ccl_buf", re->ccl_buf, MAX_CHAR_CLASS_LEN);
+}
+
+static void put_bitpar(Output *o, const bitpar_t *bp) {
+    open_list(o, ".bp =");
+    put_u64s(o, "ascii", bp->ascii, 128);
+    put_u64s(o, "latin1", bp->latin1, 128);
+    put_u64(o, "mb_fixed", bp->mb_fixed);
+    put_u64(o, "mb_var", bp->mb_var);
+    put_u64(o, "repeat", bp->repeat);
+    put_u64(o, "optional", bp->optional);
+    put_u64(o, "opt_begin", bp->opt_begin);
+    put_u64(o, "opt_end", bp->opt_end);
+    put_u64(o, "accept", bp->accept);
+    put_int(o, "len", bp->len);
+    put_int(o, "anchored_begin", bp->anchored_begin);
+    put_int(o, "anchored_end", bp->anchored_end);
+    put_int(o, "use_bndm", bp->use_bndm);
+    put_int(o, "bytes", bp->bytes);
+    put_u32s(o, "src", bp->src, BP_MAX_POSITIONS);
+    close_list(o);
+}
+
+static void put_vm(Output *o, const struct TsmRegex *re) {
+    const vm_prog_t *vm = &re->vm;
+    int i;
+    open_list(o, ".vm =");
+    if (vm->len) {
+        open_list(o, ".insts =");
+        for (i = 0; i < vm->len; i++) {
+            const vm_inst_t *inst = &vm->insts[i];
+            open_list(o, "[%d] =", i);
+            put_int(o, "op", inst->op);
+            put_int(o, "mb", inst->mb);
+            put_int(o, "obj", inst->obj);
+            put_int(o, "ch", inst->ch);
+            put_int(o, "possessive", inst->possessive);
+            put_int(o, "x", inst->x);
+            put_int(o, "y", inst->y);
+            put_u32s(o, "ascii", inst->ascii, 4);
+            close_list(o);
+        }
+        close_list(o);
+    }
+    put_line(o, ".len = %d,", vm->len);  // the list isn't empty without TSM_PROFILE
+    put_u8s(o, "entries", vm->entries, VM_MAX_INSTS);
+    put_int(o, "branch_count", vm->branch_count);
+    put_int(o, "anchored", vm->anchored);
+    put_u64(o, "nullable", vm->nullable);
+    put_int(o, "bytes", vm->bytes);
+    if (vm->spans == re->spans)
+        put_line(o, ".spans = %s.spans,", o->self);
+    fputs("#ifdef TSM_PROFILE\n", o->fp);
+    put_line(o, ".stats = &%s.stats,", o->self);
+    fputs("#endif\n", o->fp);
+    close_list(o);
+}
+
+// Spans generated on this machine don't know the processor of the program.
+// Nibble tables are scanned with the best kernel there.
+static int portable_kind(const span_t *sp) {
+    int b;
+    if (sp->kind == SPAN_NONE)
+        return SPAN_NONE;
+    for (b = 0; b < 256; b++) {
+        int nibbles = (sp->lo[b & 15] & sp->hi[b >> 4]) != 0;
+        if (nibbles != (int)((sp->bits[b >> 5] >> (b & 31)) & 1))
+            return SPAN_SCALAR;
+    }
+    return SPAN_DETECT;
+}
+
+static void put_spans(Output *o, const struct TsmRegex *re) {
+    int i, any = 0;
+    for (i = 0; i < MAX_REGEXP_OBJECTS; i++)
+        any |= re->spans[i].kind != SPAN_NONE;
+    if (!re->use_spans || !any)
+        return;
+    open_list(o, ".spans =");
+    for (i = 0; i < MAX_REGEXP_OBJECTS; i++) {
+        const span_t *sp = &re->spans[i];
+        if (sp->kind == SPAN_NONE)
+            continue;
+        open_list(o, "[%d] =", i);
+        put_u32s(o, "bits", sp->bits, 8);
+        put_u8s(o, "lo", sp->lo, 16);
+        put_u8s(o, "hi", sp->hi, 16);
+        put_int(o, "kind", portable_kind(sp));
+        close_list(o);
+    }
+    close_list(o);
+}
+
+static void put_regex(FILE *fp, const Entry *e) {
+    const struct TsmRegex *re = e->re;
+    char self[MAX_LINE + 16];
+    Output o;
+    snprintf(self, sizeof(self), "tsm_gen_%s", e->name);
+    memset(&o, 0, sizeof(o));
+    o.fp = fp;
+    o.self = self;
+
+    fprintf(fp, "/* %s (%s): \"", e->name, e->flag_text);
+    put_escaped(fp, e->pattern, strlen(e->pattern), 1);
+    fprintf(fp, "\" */\n");
+    fprintf(fp, "static TSM_GEN_CONST struct TsmRegex %s = {\n", self);
+    o.indent = 4;
+    put_objs(&o, re);
+    put_classes(&o, re);
+    put_u8s(&o, "branches", re->branches, MAX_REGEXP_OBJECTS);
+    put_int(&o, "branch_count", re->branch_count);
+    put_int(&o, "strategy", re->strategy);
+    put_int(&o, "memoize", re->memoize);
+    put_int(&o, "bytes", re->bytes);
+    put_int(&o, "use_spans", re->use_spans);
+    if (re->literal_len) {
+        put_line(&o, ".literal_len = %lu,", (unsigned long)re->literal_len);
+        fprintf(fp, "%*s.literal = \"", o.indent, "");
+        put_escaped(fp, re->literal, re->literal_len, 0);
+        fprintf(fp, "\",\n");
+    }
+    put_bitpar(&o, &re->bp);
+    put_vm(&o, re);
+    put_spans(&o, re);
+    fprintf(fp, "};\n");
+    fprintf(fp, "const TsmRegex *const %s = &%s;\n\n", e->name, self);
+}
+
+static const char *base_name(const char *path) {
+    const char *base = path, *p;
+    for (p = path; *p; p++) {
+        if (*p == '/' || *p == '\\')
+            base = p + 1;
+    }
+    return base;
+}
+
+static int write_source(const char *path, const char *header, const char *list,
+                        const Entry *entries, int count) {
+    int i;
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL) {
+        fprintf(stderr, "tsm-gen: can't open %s\n", path);
+        return 0;
+    }
+    fprintf(fp, "/* Generated by tsm-gen from %s. Don't edit. */\n\n", base_name(list));
+    fprintf(fp, "#include \"re.h\"\n");
+    fprintf(fp, "#include \"%s\"\n\n", base_name(header));
+    fprintf(fp, "/* Profiling counters are updated while matching. */\n");
+    fprintf(fp, "#ifdef TSM_PROFILE\n#define TSM_GEN_CONST\n#else\n");
+    fprintf(fp, "#define TSM_GEN_CONST const\n#endif\n\n");
+    for (i = 0; i < count; i++)
+        put_regex(fp, &entries[i]);
+    if (fclose(fp) != 0) {
+        fprintf(stderr, "tsm-gen: %s: write error\n", path);
+        return 0;
+    }
+    return 1;
+}
+
+static int write_header(const char *path, const char *list, const Entry *entries, int count) {
+    char guard[MAX_LINE];
+    const char *base = base_name(path);
+    size_t i;
+    int j;
+    FILE *fp;
+
+    snprintf(guard, sizeof(guard), "TSM_GEN_%s_", base);
+    for (i = 0; guard[i]; i++) {
+        if (guard[i] >= 'a' && guard[i] <= 'z')
+            guard[i] = (char)(guard[i] - 'a' + 'A');
+        else if (!((guard[i] >= 'A' && guard[i] <= 'Z') || (guard[i] >= '0' && guard[i] <= '9')))
+            guard[i] = '_';
+    }
+
+    fp = fopen(path, "wb");
+    if (fp == NULL) {
+        fprintf(stderr, "tsm-gen: can't open %s\n", path);
+        return 0;
+    }
+    fprintf(fp, "/* Generated by tsm-gen from %s. Don't edit. */\n\n", base_name(list));
+    fprintf(fp, "#ifndef %s\n#define %s\n\n", guard, guard);
+    fprintf(fp, "#include \"str_match.h\"\n\n");
+    fprintf(fp, "#ifdef __cplusplus\nextern \"C\" {\n#endif\n\n");
+    fprintf(fp, "/* Compiled patterns. Don't free them with tsm_regex_free(). */\n");
+    for (j = 0; j < count; j++)
+        fprintf(fp, "extern const TsmRegex *const %s;\n", entries[j].name);
+    fprintf(fp, "\n#ifdef __cplusplus\n}\n#endif\n\n#endif  /* %s */\n", guard);
+    if (fclose(fp) != 0) {
+        fprintf(stderr, "tsm-gen: %s: write error\n", path);
+        return 0;
+    }
+    return 1;
+}
+
+int main(int argc, char *argv[]) {
+    Entry *entries;
+    int count;
+
+    if (argc == 2 && (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0)) {
+        usage(stdout);
+        return 0;
+    }
+    if (argc != 4) {
+        usage(stderr);
+        return 1;
+    }
+
+    // Nothing is written when the list has errors.
+    count = read_list(argv[1], &entries);
+    if (count < 0)
+        return 1;
+    if (!write_source(argv[2], argv[3], argv[1], entries, count) ||
+        !write_header(argv[3], argv[1], entries, count)) {
+        remove(argv[2]);
+        remove(argv[3]);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,411 @@
+/*
+ * tsm-grep: prints lines that match a regex or wildcard pattern.
+ *
+ * Usage: tsm-grep [options] pattern [file...]
+ *
+ * Regular files are mapped into memory with mmap and split into chunks at line breaks.
+ * Each thread scans its own chunk, and the matching lines are printed in order.
+ * Pipes, terminals, and files that can't be mapped are scanned with buffered reads.
+ * (Windows always uses buffered reads with a single thread.)
+ *
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "str_match.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TSM_GREP_MMAP 1
+#endif
+
+#define READ_BLOCK_SIZE ((size_t)1 << 16)
+#define MIN_CHUNK_SIZE ((size_t)1 << 16)  // don't use threads for small files
+#define MAX_THREADS 64
+
+typedef struct Options {
+    int wildcard;        // -w: match whole lines with a wildcard pattern
+    int flags;           // -i, -u: TsmFlag values
+    int count_only;      // -c: print the number of matching lines
+    int files_with_matches;  // -l: print the names of files that have matching lines
+    int threads;         // -j: maximum number of threads (0 for all processors)
+    int show_names;      // print file names before lines
+} Options;
+
+typedef struct Pattern {
+    TsmRegex *re;
+    TsmWildcard *wc;
+} Pattern;
+
+// Lines in [begin, end) of a buffer. end should be at a line break or the end of the buffer.
+typedef struct Job {
+    const Pattern *pat;
+    const char *buf;
+    size_t begin;
+    size_t end;
+    int keep_lines;
+    size_t count;       // number of matching lines
+    size_t *lines;      // offsets of matching lines
+    size_t line_cap;
+    char *tmp;          // null-terminated copy of a line for wildcard patterns
+    size_t tmp_cap;
+    int error;          // failed to allocate memory
+} Job;
+
+static void usage(FILE *out) {
+    fprintf(out,
+            "Usage: tsm-grep [options] pattern [file...]\n"
+            "Prints lines that match a regex pattern. Reads stdin when no files are given.\n"
+            "\n"
+            "Options:\n"
+            "  -w      Use a wildcard pattern that should match whole lines\n"
+            "  -i      Case-insensitive matching\n"
+            "  -u      Unicode-aware \\d, \\w, and \\s\n"
+            "  -c      Print only the number of matching lines\n"
+            "  -l      Print only the names of files with matching lines\n"
+            "  -j NUM  Use up to NUM threads for regular files (0 for all processors)\n"
+            "  -h      Show this help\n");
+}
+
+static int grow(void **ptr, size_t *cap, size_t needed, size_t elem_size) {
+    size_t new_cap = *cap ? *cap : 64;
+    void *new_ptr;
+    if (needed <= *cap)
+        return 1;
+    while (new_cap < needed)
+        new_cap *= 2;
+    new_ptr = realloc(*ptr, new_cap * elem_size);
+    if (new_ptr == NULL)
+        return 0;
+    *ptr = new_ptr;
+    *cap = new_cap;
+    return 1;
+}
+
+static int match_line(Job *job, const char *line, size_t len) {
+    if (job->pat->re) {
+        TsmMatch match;
+        return tsm_regex_search(job->pat->re, line, len, 0, &match) == TSM_OK;
+    }
+
+    // Wildcard patterns need null-terminated strings.
+    if (!grow((void **)&job->tmp, &job->tmp_cap, len + 1, 1)) {
+        job->error = 1;
+        return 0;
+    }
+    memcpy(job->tmp, line, len);
+    job->tmp[len] = '\0';
+    return tsm_wildcard_match_compiled(job->pat->wc, job->tmp) == TSM_OK;
+}
+
+static void run_job(Job *job) {
+    size_t pos = job->begin;
+    while (pos < job->end && !job->error) {
+        const char *line = job->buf + pos;
+        const char *lf = (const char *)memchr(line, '\n', job->end - pos);
+        size_t len = lf ? (size_t)(lf - line) : job->end - pos;
+        if (match_line(job, line, len)) {
+            if (job->keep_lines) {
+                if (!grow((void **)&job->lines, &job->line_cap, job->count + 1, sizeof(size_t))) {
+                    job->error = 1;
+                    return;
+                }
+                job->lines[job->count] = pos;
+            }
+            job->count++;
+        }
+        pos += len + 1;
+    }
+}
+
+static void print_line(const Options *opt, const char *name, const char *line, size_t size) {
+    const char *lf = (const char *)memchr(line, '\n', size);
+    size_t len = lf ? (size_t)(lf - line) : size;
+    if (opt->show_names)
+        printf("%s:", name);
+    fwrite(line, 1, len, stdout);
+    putchar('\n');
+}
+
+#ifdef TSM_GREP_MMAP
+static void *job_main(void *arg) {
+    run_job((Job *)arg);
+    return NULL;
+}
+
+// Scans a mapped file with threads. Returns the number of matching lines, or -1 for errors.
+static long long scan_mapped(const Options *opt, const Pattern *pat, const char *name,
+                             const char *buf, size_t size) {
+    Job jobs[MAX_THREADS];
+    pthread_t th[MAX_THREADS];
+    int started[MAX_THREADS];
+    int threads = opt->threads;
+    int job_count = 0;
+    int i;
+    size_t begin = 0;
+    size_t j;
+    long long total = 0;
+    int error = 0;
+
+    if (threads <= 0) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = n > 0 ? (int)n : 1;
+    }
+    if (threads > MAX_THREADS)
+        threads = MAX_THREADS;
+    if ((size_t)threads > size / MIN_CHUNK_SIZE)
+        threads = (int)(size / MIN_CHUNK_SIZE);
+    if (threads < 1)
+        threads = 1;
+
+    // Split the buffer into chunks at line breaks.
+    for (i = 0; i < threads && begin < size; i++) {
+        size_t end = (i == threads - 1) ? size : size / (size_t)threads * (size_t)(i + 1);
+        const char *lf;
+        if (end < begin)
+            end = begin;
+        lf = (const char *)memchr(buf + end, '\n', size - end);
+        end = lf ? (size_t)(lf - buf) + 1 : size;
+        memset(&jobs[job_count], 0, sizeof(Job));
+        jobs[job_count].pat = pat;
+        jobs[job_count].buf = buf;
+        jobs[job_count].begin = begin;
+        jobs[job_count].end = end;
+        jobs[job_count].keep_lines = !opt->count_only && !opt->files_with_matches;
+        job_count++;
+        begin = end;
+    }
+
+    for (i = 1; i < job_count; i++)
+        started[i] = pthread_create(&th[i], NULL, job_main, &jobs[i]) == 0;
+    if (job_count > 0)
+        run_job(&jobs[0]);
+    for (i = 1; i < job_count; i++) {
+        if (started[i])
+            pthread_join(th[i], NULL);
+        else
+            run_job(&jobs[i]);
+    }
+
+    for (i = 0; i < job_count; i++) {
+        Job *job = &jobs[i];
+        error |= job->error;
+        if (!error && job->keep_lines) {
+            for (j = 0; j < job->count; j++) {
+                size_t offset = job->lines[j];
+                print_line(opt, name, buf + offset, size - offset);
+            }
+        }
+        total += (long long)job->count;
+        free(job->lines);
+        free(job->tmp);
+    }
+    return error ? -1 : total;
+}
+#endif  // TSM_GREP_MMAP
+
+// Scans a stream with buffered reads. Returns the number of matching lines, or -1 for errors.
+static long long scan_stream(const Options *opt, const Pattern *pat, const char *name,
+                             FILE *fp) {
+    Job job;
+    char *buf = NULL;
+    size_t cap = 0;
+    size_t size = 0;
+    long long total = 0;
+    int eof = 0;
+
+    memset(&job, 0, sizeof(Job));
+    job.pat = pat;
+
+    while (!eof) {
+        size_t n, line_start = 0, pos;
+        if (!grow((void **)&buf, &cap, size + READ_BLOCK_SIZE, 1)) {
+            job.error = 1;
+            break;
+        }
+        n = fread(buf + size, 1, READ_BLOCK_SIZE, fp);
+        if (n < READ_BLOCK_SIZE)
+            eof = 1;
+        pos = size;
+        size += n;
+
+        // Scan complete lines. The last line doesn't need a line break at the end of input.
+        while (pos < size || (eof && line_start < size)) {
+            const char *lf = (const char *)memchr(buf + pos, '\n', size - pos);
+            size_t end = lf ? (size_t)(lf - buf) : size;
+            if (!lf && !eof)
+                break;
+            if (match_line(&job, buf + line_start, end - line_start)) {
+                total++;
+                if (!opt->count_only && !opt->files_with_matches)
+                    print_line(opt, name, buf + line_start, end - line_start);
+            }
+            if (job.error)
+                break;
+            line_start = pos = end + 1;
+        }
+        if (job.error)
+            break;
+
+        // Keep the incomplete line.
+        if (line_start > 0 && line_start <= size) {
+            memmove(buf, buf + line_start, size - line_start);
+            size -= line_start;
+        } else if (line_start > size) {
+            size = 0;
+        }
+    }
+    if (ferror(fp)) {
+        fprintf(stderr, "tsm-grep: %s: read error\n", name);
+        job.error = 1;
+    }
+    free(buf);
+    free(job.tmp);
+    return job.error ? -1 : total;
+}
+
+static long long scan_file(const Options *opt, const Pattern *pat, const char *path) {
+    const char *name = path ? path : "(standard input)";
+    FILE *fp;
+    long long res;
+
+#ifdef TSM_GREP_MMAP
+    int fd = path ? open(path, O_RDONLY) : STDIN_FILENO;
+    struct stat st;
+    if (fd < 0) {
+        perror(name);
+        return -1;
+    }
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        size_t size = (size_t)st.st_size;
+        void *buf = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (buf != MAP_FAILED) {
+            res = scan_mapped(opt, pat, name, (const char *)buf, size);
+            munmap(buf, size);
+            if (path)
+                close(fd);
+            return res;
+        }
+    }
+    // Fall back to buffered reads.
+    fp = path ? fdopen(fd, "rb") : stdin;
+    if (fp == NULL) {
+        perror(name);
+        close(fd);
+        return -1;
+    }
+#else
+    fp = path ? fopen(path, "rb") : stdin;
+    if (fp == NULL) {
+        perror(name);
+        return -1;
+    }
+#endif
+
+    res = scan_stream(opt, pat, name, fp);
+    if (path)
+        fclose(fp);
+    return res;
+}
+
+int main(int argc, char *argv[]) {
+    Options opt;
+    Pattern pat;
+    const char *pattern = NULL;
+    int first_file = 0;
+    int i;
+    int found = 0;
+    int error = 0;
+    TsmResult res;
+
+    memset(&opt, 0, sizeof(Options));
+    memset(&pat, 0, sizeof(Pattern));
+
+    for (i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (arg[0] != '-' || arg[1] == '\0')
+            break;
+        if (strcmp(arg, "--") == 0) {
+            i++;
+            break;
+        }
+        for (arg++; *arg; arg++) {
+            switch (*arg) {
+                case 'w': opt.wildcard = 1; break;
+                case 'i': opt.flags |= TSM_FLAG_ICASE; break;
+                case 'u': opt.flags |= TSM_FLAG_UNICODE; break;
+                case 'c': opt.count_only = 1; break;
+                case 'l': opt.files_with_matches = 1; break;
+                case 'h':
+                    usage(stdout);
+                    return 0;
+                case 'j':
+                    if (arg[1] != '\0') {
+                        opt.threads = atoi(arg + 1);
+                    } else if (i + 1 < argc) {
+                        opt.threads = atoi(argv[++i]);
+                    } else {
+                        usage(stderr);
+                        return 2;
+                    }
+                    arg += strlen(arg) - 1;
+                    break;
+                default:
+                    fprintf(stderr, "tsm-grep: unknown option -%c\n", *arg);
+                    usage(stderr);
+                    return 2;
+            }
+        }
+    }
+    if (i >= argc) {
+        usage(stderr);
+        return 2;
+    }
+    pattern = argv[i++];
+    first_file = i;
+    opt.show_names = argc - first_file > 1;
+
+    if (opt.wildcard)
+        res = tsm_wildcard_compile(pattern, opt.flags, &pat.wc);
+    else
+        res = tsm_regex_compile(pattern, opt.flags, &pat.re);
+    if (res != TSM_OK) {
+        fprintf(stderr, "tsm-grep: invalid pattern: %s\n", pattern);
+        return 2;
+    }
+
+    for (i = first_file; i < argc || i == first_file; i++) {
+        const char *path = (i < argc && strcmp(argv[i], "-") != 0) ? argv[i] : NULL;
+        const char *name = path ? path : "(standard input)";
+        long long count = scan_file(&opt, &pat, path);
+        if (count < 0) {
+            error = 1;
+            continue;
+        }
+        if (count > 0)
+            found = 1;
+        if (opt.files_with_matches) {
+            if (count > 0)
+                printf("%s\n", name);
+        } else if (opt.count_only) {
+            if (opt.show_names)
+                printf("%s:", name);
+            printf("%lld\n", count);
+        }
+        if (i >= argc)
+            break;
+    }
+
+    tsm_regex_free(pat.re);
+    tsm_wildcard_free(pat.wc);
+    return error ? 2 : (found ? 0 : 1);
+}